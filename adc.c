@@ -0,0 +1,414 @@
+//*************************************************************************************
+/** \file adc.c
+ *  \brief This file contains the ADC scan sequencer, which converts a list of ADC
+ *  channels over and over from the conversion complete interrupt. The conversions of
+ *  the motor currents are started by the Timer 1 overflow, so they are in step with
+ *  the PWM.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "timestamp.h"
+#include "adc.h"
+#include "task_motors.h"
+#include "trip.h"
+#include "thermal.h"
+
+// Marks a channel which isn't in the scan list, in adc_slot_of.
+#define ADC_NOT_SCANNED 0xFF
+
+/// The channels to convert, in order.
+static const uint8_t adc_channels[ADC_SCAN_LENGTH] = ADC_SCAN_LIST;
+
+/// The slot of each of the 8 ADC channels, or ADC_NOT_SCANNED.
+static uint8_t adc_slot_of[8];
+
+/// Latest reading of each channel in the scan list. Written by the ADC ISR.
+static volatile uint16_t adc_values[ADC_SCAN_LENGTH];
+
+/// Count of readings of each channel, so readers can tell a new reading from an old one.
+static volatile uint8_t adc_sequences[ADC_SCAN_LENGTH];
+
+/// Latest raw readings of each triggered channel, and where the next one goes.
+static volatile uint16_t adc_samples[ADC_SCAN_LENGTH][ADC_SAMPLE_BUFFER_SIZE];
+static volatile uint8_t adc_sample_next[ADC_SCAN_LENGTH];
+
+/// Duty cycle register of the motor whose current each triggered slot reads, or NULL.
+static volatile uint16_t *adc_pwm_ocr[ADC_SCAN_LENGTH];
+
+#if (ADC_SAMPLE_BUFFER_SIZE & (ADC_SAMPLE_BUFFER_SIZE - 1)) != 0
+	#error ADC_SAMPLE_BUFFER_SIZE must be a power of 2
+#endif
+
+/// How each channel is filtered.
+static const adc_filter_config adc_filter_configs[ADC_SCAN_LENGTH] = ADC_FILTER_LIST;
+
+/// State of the filters of one channel.
+typedef struct
+{
+	uint16_t sum;               ///< Sum of the readings being oversampled
+	uint8_t count;              ///< Number of readings in sum
+	uint32_t iir;               ///< Low pass state, the output times 2^iir
+	uint32_t window_sum;        ///< Sum of the decimated readings in this window
+	uint16_t window_min;        ///< Smallest decimated reading in this window
+	uint16_t window_max;        ///< Largest decimated reading in this window
+	uint16_t window_count;      ///< Number of decimated readings in this window
+	adc_filtered out;           ///< The published values
+} adc_filter_state;
+
+static adc_filter_state adc_filters[ADC_SCAN_LENGTH];
+
+/// The slot whose conversion is in progress.
+static uint8_t adc_scan_index;
+
+/// Statistics, and the time at which they were last reset.
+static volatile uint32_t adc_conversions;
+static volatile uint32_t adc_held;
+#ifdef ADC_READ_TIMING
+static uint16_t adc_read_time_max;
+#endif
+static portTickType adc_stats_start;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the state of the filters of one channel.
+ */
+static void adc_filter_reset(adc_filter_state *filter){
+	filter->sum = 0;
+	filter->count = 0;
+	filter->iir = 0;
+	filter->window_sum = 0;
+	filter->window_min = 0xFFFF;
+	filter->window_max = 0;
+	filter->window_count = 0;
+	filter->out.value = 0;
+	filter->out.min = 0;
+	filter->out.max = 0;
+	filter->out.mean = 0;
+	filter->out.sequence = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function works out the ADC control register values for the scan.
+ *  \details The ADC runs in auto trigger mode with Timer 1 overflow as the source, so
+ *  a conversion starts either on the next overflow or, when the start bit is set, at 
+ *  once. It only fills in the structure, so the values can be checked off target.
+ *  @param regs The structure into which the register values are put.
+ *  @param channel The channel the first conversion is of.
+ *  @param triggered Nonzero if the first conversion is to wait for the trigger, zero
+ *  to start it at once.
+ */
+void adc_make_registers(adc_registers *regs, uint8_t channel, uint8_t triggered){
+	// Use AVCC as the reference voltage, and select the channel.
+	regs->admux = (1<<REFS0) | (channel & ((1<<MUX2)|(1<<MUX1)|(1<<MUX0)));
+
+	// Enable the ADC and its conversion complete interrupt, set the clock prescaler 
+	// and turn on auto triggering, from the source selected in ADCSRB.
+	regs->adcsra = (1<<ADEN) | (1<<ADIE) | (1<<ADATE) | ADC_PRESCALER_BITS;
+	if(!triggered)
+	{
+		regs->adcsra |= (1<<ADSC);
+	}
+	regs->adcsrb = ADC_TRIGGER_BITS;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function initializes the ADC on the ATMEGA 1284p and starts the scan.
+ *  \details Call once from main(), before interrupts are enabled. From then on the
+ *  ADC ISR converts the channels of ADC_SCAN_LIST in turn, for good. The triggered
+ *  channels are only converted while Timer 1 runs and its overflow interrupt, which
+ *  clears the overflow flag each period, is enabled by control_init(). Each triggered
+ *  channel which is the current sense of an axis in motor_axes[] is matched with the
+ *  duty cycle register of that axis.
+ */
+void adc_init(void){
+	for(uint8_t channel = 0; channel < 8; channel++)
+	{
+		adc_slot_of[channel] = ADC_NOT_SCANNED;
+	}
+	for(uint8_t slot = 0; slot < ADC_SCAN_LENGTH; slot++)
+	{
+		adc_slot_of[adc_channels[slot]] = slot;
+		adc_values[slot] = 0;
+		adc_sequences[slot] = 0;
+		adc_sample_next[slot] = 0;
+		adc_pwm_ocr[slot] = NULL;
+		for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+		{
+			if((ADC_SCAN_TRIGGERED & (1<<slot)) 
+			   && MOTOR_AXIS_BYTE(axis, current) == adc_channels[slot])
+			{
+				adc_pwm_ocr[slot] = MOTOR_AXIS_PTR(axis, ocr);
+			}
+		}
+		for(uint8_t index = 0; index < ADC_SAMPLE_BUFFER_SIZE; index++)
+		{
+			adc_samples[slot][index] = 0;
+		}
+		adc_filter_reset(&adc_filters[slot]);
+	}
+	adc_scan_index = 0;
+	adc_reset_stats();
+
+	adc_registers regs;
+	adc_make_registers(&regs, adc_channels[0], ADC_SCAN_TRIGGERED & (1<<0));
+	ADMUX = regs.admux;
+	ADCSRB = (ADCSRB & ~((1<<ADTS2)|(1<<ADTS1)|(1<<ADTS0))) | regs.adcsrb;
+	ADCSRA = regs.adcsra;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the latest reading of an ADC channel.
+ *  \details It never waits for a conversion, so it may be called from any task, at
+ *  any rate. The reading is at most one scan old.
+ *  @param adc_channel Takes one of the ADC_ channel #defines from adc.h. It must be in
+ *  ADC_SCAN_LIST, else 0 is returned.
+ *  @return Returns an unsigned 10-bit reading.
+ */
+uint16_t adc_read(uint8_t adc_channel){
+	uint8_t sequence;
+	return adc_read_sequence(adc_channel, &sequence);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the latest reading of an ADC channel and its count.
+ *  \details Compare the count with the one from the previous call to tell whether a
+ *  new conversion has finished since then.
+ *  @param adc_channel Takes one of the ADC_ channel #defines from adc.h. It must be in
+ *  ADC_SCAN_LIST, else 0 is returned.
+ *  @param sequence Where to put the count of readings of the channel, which wraps.
+ *  @return Returns an unsigned 10-bit reading.
+ */
+uint16_t adc_read_sequence(uint8_t adc_channel, uint8_t *sequence){
+	uint8_t slot = adc_slot_of[adc_channel & 0x07];
+	uint16_t value = 0;
+	*sequence = 0;
+	if(slot == ADC_NOT_SCANNED)
+	{
+		return 0;
+	}
+	taskENTER_CRITICAL();
+#ifdef ADC_READ_TIMING
+		uint32_t start = timestamp_now_in_ISR();
+#endif
+		value = adc_values[slot];
+		*sequence = adc_sequences[slot];
+#ifdef ADC_READ_TIMING
+		uint16_t read_time = timestamp_now_in_ISR() - start;
+		if(read_time > adc_read_time_max)
+		{
+			adc_read_time_max = read_time;
+		}
+#endif
+	taskEXIT_CRITICAL();
+	return value;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the filtered values of an ADC channel.
+ *  \details The filters run in the ADC ISR, so this costs no more than a copy.
+ *  @param adc_channel Takes one of the ADC_ channel #defines from adc.h. It must be in
+ *  ADC_SCAN_LIST, else all values are 0.
+ *  @param filtered Where to copy the values, in 1/ADC_FILTER_SCALE ADC counts.
+ */
+void adc_read_filtered(uint8_t adc_channel, adc_filtered *filtered){
+	uint8_t slot = adc_slot_of[adc_channel & 0x07];
+	if(slot == ADC_NOT_SCANNED)
+	{
+		filtered->value = filtered->min = filtered->max = filtered->mean = 0;
+		filtered->sequence = 0;
+		return;
+	}
+	taskENTER_CRITICAL();
+		*filtered = adc_filters[slot].out;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the latest raw readings of a triggered ADC channel.
+ *  \details Each reading was sampled at the same point of a PWM period, so they can
+ *  be averaged or compared without ripple from the PWM.
+ *  @param adc_channel Takes one of the ADC_ channel #defines from adc.h. It must be a
+ *  triggered channel of ADC_SCAN_LIST, else nothing is copied.
+ *  @param samples Where to copy the readings, oldest first.
+ *  @param count How many readings to copy, at most ADC_SAMPLE_BUFFER_SIZE.
+ *  @return Returns the number of readings copied.
+ */
+uint8_t adc_read_samples(uint8_t adc_channel, uint16_t *samples, uint8_t count){
+	uint8_t slot = adc_slot_of[adc_channel & 0x07];
+	if(slot == ADC_NOT_SCANNED || !(ADC_SCAN_TRIGGERED & (1<<slot)))
+	{
+		return 0;
+	}
+	if(count > ADC_SAMPLE_BUFFER_SIZE)
+	{
+		count = ADC_SAMPLE_BUFFER_SIZE;
+	}
+	taskENTER_CRITICAL();
+		uint8_t index = adc_sample_next[slot] - count;
+		for(uint8_t sample = 0; sample < count; sample++)
+		{
+			samples[sample] = adc_samples[slot][index++ & (ADC_SAMPLE_BUFFER_SIZE - 1)];
+		}
+	taskEXIT_CRITICAL();
+	return count;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the statistics of the ADC scan.
+ *  @param stats The structure into which the statistics are copied.
+ */
+void adc_get_stats(adc_stats *stats){
+	uint32_t elapsed;
+	taskENTER_CRITICAL();
+		stats->conversions = adc_conversions;
+		stats->held = adc_held;
+#ifdef ADC_READ_TIMING
+		stats->read_time_max = adc_read_time_max;
+#else
+		stats->read_time_max = 0;
+#endif
+		elapsed = (xTaskGetTickCount() - adc_stats_start)*portTICK_RATE_MS;
+	taskEXIT_CRITICAL();
+
+	// The count times 1000 overflows after about 7 minutes, so go to whole seconds
+	// when the statistics are older than that.
+	if(stats->conversions < 0xFFFFFFFFUL/1000UL)
+	{
+		stats->conversions_per_s = elapsed ? (stats->conversions*1000UL)/elapsed : 0;
+	}
+	else
+	{
+		stats->conversions_per_s = stats->conversions/(elapsed/1000UL);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the statistics of the ADC scan.
+ */
+void adc_reset_stats(void){
+	taskENTER_CRITICAL();
+		adc_conversions = 0;
+		adc_held = 0;
+#ifdef ADC_READ_TIMING
+		adc_read_time_max = 0;
+#endif
+		adc_stats_start = xTaskGetTickCount();
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one reading through the filters of its channel.
+ *  \details Called from the ADC ISR only. Each step is incremental, so the cost per
+ *  reading is a few additions, and shifts by constant amounts.
+ *  @param slot The slot of the channel.
+ *  @param reading The 10-bit reading.
+ */
+static inline void adc_filter(uint8_t slot, uint16_t reading){
+	adc_filter_state *filter = &adc_filters[slot];
+	const adc_filter_config *config = &adc_filter_configs[slot];
+
+	// Oversample: sum 4^n readings, then drop n bits, for 10+n significant bits,
+	// which are then moved up to the 16-bit scale of the outputs.
+	filter->sum += reading;
+	if(++filter->count < (1U<<(2*config->oversample)))
+	{
+		return;
+	}
+	uint16_t decimated = (filter->sum >> config->oversample) << (6 - config->oversample);
+	filter->sum = 0;
+	filter->count = 0;
+
+	// First-order low pass, y += (x - y)/2^k. The state holds y*2^k, so no bits are
+	// lost to the shift. It starts from the first reading rather than from 0.
+	if(filter->out.sequence == 0 && filter->iir == 0)
+	{
+		filter->iir = (uint32_t)decimated << config->iir;
+	}
+	filter->iir += decimated - (filter->iir >> config->iir);
+	filter->out.value = filter->iir >> config->iir;
+	filter->out.sequence++;
+
+	// Min/max/mean over a window of 2^m decimated readings, published when full.
+	filter->window_sum += decimated;
+	if(decimated < filter->window_min) filter->window_min = decimated;
+	if(decimated > filter->window_max) filter->window_max = decimated;
+	if(++filter->window_count >= (1U<<config->window))
+	{
+		filter->out.min = filter->window_min;
+		filter->out.max = filter->window_max;
+		filter->out.mean = filter->window_sum >> config->window;
+		filter->window_sum = 0;
+		filter->window_min = 0xFFFF;
+		filter->window_max = 0;
+		filter->window_count = 0;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This ISR stores a finished conversion and starts the next one in the scan.
+ *  \details A triggered reading of a motor current is replaced when the PWM pulse of 
+ *  the motor was too short for it to be taken in the on-time, see ADC_SAMPLE_MIN_OCR.
+ *  The multiplexer is switched before the next conversion is started, so the
+ *  sample and hold always sees the channel the result will be stored for. If the next
+ *  slot is triggered, its conversion is left for the Timer 1 overflow to start.
+ */
+ISR(ADC_vect){
+	uint8_t slot = adc_scan_index;
+	uint16_t reading = ADC;
+	adc_conversions++;
+	if(ADC_SCAN_TRIGGERED & (1<<slot))
+	{
+		// A pulse too short to be sampled gives the off-time current, see adc.h.
+		uint16_t duty = (adc_pwm_ocr[slot] != NULL) ? *adc_pwm_ocr[slot] : 0xFFFF;
+		if(duty == 0)
+		{
+			reading = 0;
+		}
+		else if(duty < ADC_SAMPLE_MIN_OCR)
+		{
+			reading = adc_values[slot];
+			adc_held++;
+		}
+		uint8_t next = adc_sample_next[slot];
+		adc_samples[slot][next & (ADC_SAMPLE_BUFFER_SIZE - 1)] = reading;
+		adc_sample_next[slot] = next + 1;
+	}
+	adc_values[slot] = reading;
+	adc_sequences[slot]++;
+	adc_filter(slot, reading);
+	trip_current(adc_channels[slot], reading);
+	thermal_current(adc_channels[slot], reading);
+
+	if(++slot >= ADC_SCAN_LENGTH)
+	{
+		slot = 0;
+	}
+	adc_scan_index = slot;
+	ADMUX = (ADMUX & ~((1<<MUX2)|(1<<MUX1)|(1<<MUX0))) | adc_channels[slot];
+	if(!(ADC_SCAN_TRIGGERED & (1<<slot)))
+	{
+		ADCSRA |= (1<<ADSC);
+	}
+}
@@ -0,0 +1,145 @@
+//*************************************************************************************
+/** \file adc.h
+ *  \brief This file contains #defines, types and function declarations for the ADC
+ *  scan sequencer.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _ADC_H_
+#define _ADC_H_
+
+// ADC CHANNELS
+#define ADC_CURRENT_M1 4 /// CHECK THESE VALUES!!!!!!!!!
+#define ADC_CURRENT_M2 5
+#define ADC_JOYSTICK_Y 0x06
+#define ADC_JOYSTICK_X 0x07
+
+// The channels converted by the scan, in order. Each one gets a slot which holds its
+// latest reading; to read another input, add its channel here.
+#define ADC_SCAN_LIST { ADC_CURRENT_M1, ADC_JOYSTICK_X, ADC_CURRENT_M2, ADC_JOYSTICK_Y }
+#define ADC_SCAN_LENGTH 4
+
+// Bit n set means the conversion of slot n waits for the trigger, the overflow of
+// Timer 1 where each PWM period starts, instead of following the one before it. The
+// motor currents are triggered so that they are always sampled at the same point of 
+// the PWM period; the joystick readings follow them. The two currents alternate, so 
+// each is sampled every other PWM period, once per control cycle.
+#define ADC_SCAN_TRIGGERED ( (1<<0) | (1<<2) )
+
+// How each channel in the scan list is filtered, in the same order. Each entry is
+// { oversample, iir, window }:
+//   oversample  Sum 4^n readings and drop n bits, giving n extra bits (n = 0 to 3).
+//               This needs a few LSB of noise on the input to work.
+//   iir         Time constant of the first-order low pass, 2^k decimated readings;
+//               0 turns the filter off.
+//   window      Length of the min/max/mean window, 2^m decimated readings.
+// The host tests set their own list on the command line, to cover every setting.
+#ifndef ADC_FILTER_LIST
+#define ADC_FILTER_LIST { {1, 2, 4}, {0, 2, 0}, {1, 2, 4}, {0, 2, 0} }
+#endif
+
+// Number of raw readings kept for each triggered channel, a power of 2. They can be
+// copied out with adc_read_samples().
+#define ADC_SAMPLE_BUFFER_SIZE 8
+
+// Filtered values are in 1/ADC_FILTER_SCALE of a 10-bit ADC count, so that they fit
+// 16 bits with up to 3 extra bits from oversampling. Compare them with thresholds in
+// ADC counts times this scale.
+#define ADC_FILTER_SCALE 64U
+#define ADC_OVERSAMPLE_MAX 3
+
+// The ADC clock is F_CPU/128, 125 kHz, within the 50-200 kHz needed for full 10-bit
+// accuracy. A conversion takes 13 ADC clocks, 104 us, so a triggered conversion and
+// the one following it are done well within the 512 us PWM period.
+#define ADC_PRESCALER_BITS ( (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0) )
+#define ADC_CLOCK_DIVIDER 128U
+
+// A triggered conversion starts on the next ADC clock after the overflow, and samples
+// its input 2 ADC clocks later, so 16 to 24 us into the PWM pulse; its result is 
+// ready 13.5 ADC clocks, about 108 us, after the start. In counts of Timer 1, which
+// runs at F_CPU/8, the sample is taken at most this far into the period:
+#define ADC_SAMPLE_OFFSET_COUNTS ( 3U*ADC_CLOCK_DIVIDER/8U )
+
+// A pulse shorter than the offset plus a margin for the current sense to settle is
+// over before the sample is taken, which would then read the off-time. For such short
+// pulses the ADC ISR holds the last reading of the channel instead, and with no pulse
+// at all, a duty cycle of 0, it stores 0. The ISR reads the duty cycle when the 
+// conversion is done, so it may already be the one written for the next period.
+#define ADC_SAMPLE_MARGIN_COUNTS 16U
+#define ADC_SAMPLE_MIN_OCR ( ADC_SAMPLE_OFFSET_COUNTS + ADC_SAMPLE_MARGIN_COUNTS )
+
+// The auto trigger source, ADTS2:0 in ADCSRB; 110 is Timer/Counter1 overflow.
+#define ADC_TRIGGER_BITS ( (1<<ADTS2) | (1<<ADTS1) )
+
+/** This structure holds the values for the ADC control registers, as worked out by 
+ *  adc_make_registers(). 
+ */
+typedef struct
+{
+	uint8_t admux;              ///< Reference and first channel
+	uint8_t adcsra;             ///< Enable, interrupt, auto trigger, prescaler, start
+	uint8_t adcsrb;             ///< Auto trigger source
+} adc_registers;
+
+/** This structure sets up the filters of one channel, see ADC_FILTER_LIST.
+ */
+typedef struct
+{
+	uint8_t oversample;         ///< log4 of the readings summed per decimated reading
+	uint8_t iir;                ///< log2 of the low pass time constant, 0 for none
+	uint8_t window;             ///< log2 of the min/max/mean window length
+} adc_filter_config;
+
+/** This structure holds the filtered values of one channel, in units of 
+ *  1/ADC_FILTER_SCALE ADC counts. They are updated by the ADC ISR, so reading them 
+ *  costs only a copy.
+ */
+typedef struct
+{
+	uint16_t value;             ///< Latest output of the low pass filter
+	uint16_t min;               ///< Smallest decimated reading in the last window
+	uint16_t max;               ///< Largest decimated reading in the last window
+	uint16_t mean;              ///< Mean of the decimated readings in the last window
+	uint8_t sequence;           ///< Count of low pass outputs, which wraps
+} adc_filtered;
+
+/** This structure holds statistics of the ADC scan. Times are in time stamp counts, 
+ *  TIMESTAMP_HZ per second.
+ */
+typedef struct
+{
+	uint32_t conversions;       ///< Conversions since the statistics were reset
+	uint16_t conversions_per_s; ///< Average rate of conversions since then
+	uint32_t held;              ///< Triggered readings held because the PWM pulse was
+	                            ///< shorter than ADC_SAMPLE_MIN_OCR
+	uint16_t read_time_max;     ///< Longest time a call to adc_read() took, only timed
+	                            ///< when built with -DADC_READ_TIMING, else 0
+} adc_stats;
+
+void adc_make_registers(adc_registers *regs, uint8_t channel, uint8_t triggered);
+void adc_init(void);
+uint16_t adc_read(uint8_t adc_channel);
+uint16_t adc_read_sequence(uint8_t adc_channel, uint8_t *sequence);
+void adc_read_filtered(uint8_t adc_channel, adc_filtered *filtered);
+uint8_t adc_read_samples(uint8_t adc_channel, uint16_t *samples, uint8_t count);
+void adc_get_stats(adc_stats *stats);
+void adc_reset_stats(void);
+
+#endif
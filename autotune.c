@@ -0,0 +1,163 @@
+//*************************************************************************************
+/** \file autotune.c
+ *  \brief This file contains the relay feedback autotuner. It runs the experiment of
+ *  Astrom and Hagglund on one axis and works out PI or PID gains from the ultimate
+ *  gain and period it measures.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <stdint.h>
+#include <math.h>
+
+#include "autotune.h"
+
+//-------------------------------------------------------------------------------------
+/** \brief This function marks an experiment as not run, with its output at 0.
+ */
+void autotune_init(relay_autotune *at){
+	at->output = 0;
+	at->status = AUTOTUNE_IDLE;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function starts a relay experiment.
+ *  \details The relay oscillates the axis about the position it is at now. Call
+ *  autotune_update() once per period_us from then on.
+ *  @param position The position of the axis now, in counts.
+ *  @param relay The relay output, in motor power counts.
+ *  @param period_us The time between updates, in us.
+ */
+void autotune_start(relay_autotune *at, int32_t position, int16_t relay, uint16_t period_us){
+	at->center = position;
+	at->relay = relay;
+	at->output = relay;
+	at->period_us = period_us;
+	at->cycles_run = 0;
+	at->timeout_cycles = (AUTOTUNE_TIMEOUT_S*1000000UL)/period_us;
+	at->last_switch = 0;
+	at->peak_max = position;
+	at->peak_min = position;
+	at->oscillations = 0;
+	at->period_sum = 0;
+	at->swing_sum = 0;
+	at->status = AUTOTUNE_RUNNING;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one update of a relay experiment.
+ *  \details Once the experiment has finished, for whatever reason, the output is 0.
+ *  @param position The position of the axis, in counts.
+ *  @return The motor power to apply, in the sign convention of the controllers.
+ */
+int16_t autotune_update(relay_autotune *at, int32_t position){
+	if(at->status != AUTOTUNE_RUNNING)
+	{
+		return 0;
+	}
+	int32_t error = position - at->center;
+	at->cycles_run++;
+	if(error > AUTOTUNE_EXCURSION_MAX || error < -AUTOTUNE_EXCURSION_MAX)
+	{
+		at->status = AUTOTUNE_RUNAWAY;
+		return 0;
+	}
+	if(at->cycles_run > at->timeout_cycles)
+	{
+		at->status = AUTOTUNE_TIMED_OUT;
+		return 0;
+	}
+
+	if(position > at->peak_max) at->peak_max = position;
+	if(position < at->peak_min) at->peak_min = position;
+
+	if(at->output > 0 && error > AUTOTUNE_HYSTERESIS)
+	{
+		at->output = -at->relay;
+	}
+	else if(at->output < 0 && error < -AUTOTUNE_HYSTERESIS)
+	{
+		// A switch to +relay ends one oscillation cycle. The first cycles are
+		// skipped, since the axis starts from rest.
+		at->output = at->relay;
+		if(at->oscillations >= AUTOTUNE_SETTLE_CYCLES)
+		{
+			at->period_sum += at->cycles_run - at->last_switch;
+			at->swing_sum += at->peak_max - at->peak_min;
+		}
+		at->last_switch = at->cycles_run;
+		at->peak_max = position;
+		at->peak_min = position;
+		if(++at->oscillations >= AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_CYCLES)
+		{
+			at->status = AUTOTUNE_DONE;
+			return 0;
+		}
+	}
+	return at->output;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the status of a relay experiment.
+ *  @return One of the AUTOTUNE_ status codes from autotune.h.
+ */
+uint8_t autotune_status(const relay_autotune *at){
+	return at->status;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function works out controller gains from a finished experiment.
+ *  \details The describing function of a relay with hysteresis gives the ultimate
+ *  gain as Ku = 4d/(pi*sqrt(a^2 - e^2)), for relay output d, oscillation amplitude a
+ *  and hysteresis e. The gains then follow the Tyreus-Luyben rules, which are less
+ *  aggressive than Ziegler-Nichols: PI Kp = Ku/3.2, Ti = 2.2 Tu, or with
+ *  AUTOTUNE_DERIVATIVE set, PID Kp = Ku/2.2, Ti = 2.2 Tu, Td = Tu/6.3. Call from a
+ *  task or once at the end of the experiment, since it uses floating point.
+ *  @param gains Where to put the ultimate gain and period and the gains.
+ *  @return AUTOTUNE_DONE if the gains are valid, else the reason they're not.
+ */
+uint8_t autotune_gains_get(const relay_autotune *at, autotune_gains *gains){
+	gains->k_ultimate = gains->t_ultimate = 0.0F;
+	gains->k_prop = gains->k_int = gains->k_der = 0.0F;
+	if(at->status != AUTOTUNE_DONE)
+	{
+		return at->status;
+	}
+
+	float period = (float)at->period_us*1e-6F;
+	float amplitude = (float)at->swing_sum/(2.0F*AUTOTUNE_CYCLES);
+	float hysteresis = AUTOTUNE_HYSTERESIS;
+	if(amplitude <= hysteresis)
+	{
+		return AUTOTUNE_NO_OSCILLATION;
+	}
+	gains->k_ultimate = 4.0F*at->relay
+	                    /(M_PI*sqrtf(amplitude*amplitude - hysteresis*hysteresis));
+	gains->t_ultimate = (float)at->period_sum/AUTOTUNE_CYCLES*period;
+
+#if AUTOTUNE_DERIVATIVE
+	gains->k_prop = gains->k_ultimate/2.2F;
+	gains->k_der = gains->k_prop*(gains->t_ultimate/6.3F)/period;
+#else
+	gains->k_prop = gains->k_ultimate/3.2F;
+#endif
+	gains->k_int = gains->k_prop*period/(2.2F*gains->t_ultimate);
+	return AUTOTUNE_DONE;
+}
@@ -0,0 +1,100 @@
+//*************************************************************************************
+/** \file autotune.h
+ *  \brief This file contains #defines, types and function declarations for the relay
+ *  feedback autotuner, which measures the ultimate gain and period of an axis and
+ *  works out controller gains from them.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _AUTOTUNE_H_
+#define _AUTOTUNE_H_
+
+// The relay output is this fraction of the axis power limit, as a shift: 1 is half.
+#define AUTOTUNE_RELAY_SHIFT 1
+
+// Hysteresis of the relay, in counts either side of the start position. It must be
+// more than the encoder noise, so the relay switches only on the oscillation.
+#define AUTOTUNE_HYSTERESIS 2
+
+// The first AUTOTUNE_SETTLE_CYCLES oscillation cycles are not measured; the next
+// AUTOTUNE_CYCLES are averaged.
+#define AUTOTUNE_SETTLE_CYCLES 2
+#define AUTOTUNE_CYCLES 6
+
+// The experiment is stopped, the axis left unpowered and the gains left as they were
+// if it isn't done within this many seconds, or if the axis gets further than this
+// many counts from where it started.
+#define AUTOTUNE_TIMEOUT_S 30
+#define AUTOTUNE_EXCURSION_MAX 2000
+
+// Set to 1 for PID gains, 0 for PI. The derivative needs a clean position signal.
+#define AUTOTUNE_DERIVATIVE 0
+
+// Status of an experiment
+#define AUTOTUNE_IDLE 0                 ///< Not run
+#define AUTOTUNE_RUNNING 1              ///< The relay is running
+#define AUTOTUNE_DONE 2                 ///< Measured; the gains are valid
+#define AUTOTUNE_TIMED_OUT 3            ///< Too few cycles within AUTOTUNE_TIMEOUT_S
+#define AUTOTUNE_RUNAWAY 4              ///< Moved more than AUTOTUNE_EXCURSION_MAX
+#define AUTOTUNE_NO_OSCILLATION 5       ///< Oscillation within the hysteresis band
+
+/** This structure holds the state of one relay experiment. The relay drives the axis
+ *  with +relay while it is below its start position plus the hysteresis and -relay
+ *  while above it minus the hysteresis, which makes it oscillate at the frequency 
+ *  where its phase lag is 180 degrees. The period and amplitude of each cycle, from
+ *  one switch to +relay to the next, are summed.
+ */
+typedef struct
+{
+	int32_t center;             ///< Position at the start, in counts
+	int16_t relay;              ///< Relay output, in motor power counts
+	int16_t output;             ///< Present relay output
+	uint16_t period_us;         ///< Time between updates
+	uint32_t cycles_run;        ///< Updates since the start
+	uint32_t timeout_cycles;    ///< Updates allowed before timing out
+	uint32_t last_switch;       ///< Update at which the relay last switched to +relay
+	int32_t peak_max;           ///< Highest position in this oscillation cycle
+	int32_t peak_min;           ///< Lowest position in this oscillation cycle
+	uint8_t oscillations;       ///< Oscillation cycles completed
+	uint32_t period_sum;        ///< Sum of the measured periods, in updates
+	uint32_t swing_sum;         ///< Sum of the measured peak to peak swings, in counts
+	uint8_t status;             ///< One of the AUTOTUNE_ status codes
+} relay_autotune;
+
+/** This structure holds the result of an experiment and the gains worked out from it.
+ *  The gains are in the form pid_set_gains() takes, with the integral and derivative
+ *  gains per update of the experiment.
+ */
+typedef struct
+{
+	float k_ultimate;           ///< Ultimate gain, motor power counts per count
+	float t_ultimate;           ///< Ultimate period, in s
+	float k_prop;               ///< Proportional gain
+	float k_int;                ///< Integral gain, per update
+	float k_der;                ///< Derivative gain, per update
+} autotune_gains;
+
+void autotune_init(relay_autotune *at);
+void autotune_start(relay_autotune *at, int32_t position, int16_t relay, uint16_t period_us);
+int16_t autotune_update(relay_autotune *at, int32_t position);
+uint8_t autotune_status(const relay_autotune *at);
+uint8_t autotune_gains_get(const relay_autotune *at, autotune_gains *gains);
+
+#endif
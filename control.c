@@ -0,0 +1,802 @@
+//*************************************************************************************
+/** \file control.c
+ *  \brief This file contains the control executive, which runs position control
+ *  of all axes from the PWM timer overflow interrupt.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+#include "queue.h"                          // FreeRTOS inter-task communication queues
+#include "croutine.h" 
+#include "semphr.h"
+
+#include "shares.h"
+#include "fixed.h"
+#include "pid.h"
+#include "profile.h"
+#include "friction.h"
+#include "encoder.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "task_safety.h"
+#include "adc.h"
+#include "autotune.h"
+#include "supervisor.h"
+#include "trip.h"
+#include "control.h"
+
+#if ENC_NUM_AXES != MOTOR_NUM_AXES
+	#error "Every motor axis needs an encoder: ENC_NUM_AXES must equal MOTOR_NUM_AXES"
+#endif
+
+#if defined(CURRENT_LOOP) && \
+    (CURRENT_LIMIT_1 >= MAX_CURRENT_M1 || CURRENT_LIMIT_2 >= MAX_CURRENT_M2)
+	#error "The current limits CURRENT_LIMIT_x must be below the trip levels MAX_CURRENT_Mx"
+#endif
+
+// Position controllers, one per motor. Only used by the control ISR.
+static pid_controller ctl_pid[MOTOR_NUM_AXES];
+
+#ifdef VELOCITY_LOOP
+// Velocity controllers, whose references come from ctl_pid[], and the velocity each 
+// position controller asked for when it last ran.
+static pid_controller ctl_velocity_pid[MOTOR_NUM_AXES];
+static int16_t ctl_velocity_cmd[MOTOR_NUM_AXES];
+
+/// Counts control cycles, the position loops run when it is 0.
+static uint8_t ctl_position_divider;
+#endif
+
+#ifdef CURRENT_LOOP
+// Current controllers, the innermost loops, whose references come from the loop above.
+static pid_controller ctl_current_pid[MOTOR_NUM_AXES];
+#endif
+
+// Motion profiles, which smooth the position commands fed to the controllers.
+static motion_profile ctl_profile[MOTOR_NUM_AXES];
+
+// Static friction compensation of each axis, and its calibration.
+static friction_comp ctl_friction[MOTOR_NUM_AXES];
+
+/// Feedforward gains of each axis, from motor_axes[] in Q16.16.
+static q16_t ctl_k_ff_vel[MOTOR_NUM_AXES];
+static q16_t ctl_k_ff_acc[MOTOR_NUM_AXES];
+
+/// The fraction of a count of feedforward each axis has yet to apply, in Q16.16.
+static q16_t ctl_ff_residue[MOTOR_NUM_AXES];
+
+/// The setpoint sequence seen last, and the time since it changed, in whole seconds and
+/// microseconds.
+static uint8_t ctl_setpoint_sequence;
+static uint16_t ctl_setpoint_age_s;
+static uint32_t ctl_setpoint_age_us;
+
+/// The relay experiment, the axis it runs on, whether the breakaway calibration of 
+/// that axis has been started, and the outcome for each axis.
+static relay_autotune ctl_autotune;
+static uint8_t ctl_autotune_axis;
+static uint8_t ctl_calibration_started;
+static uint8_t ctl_autotune_status[MOTOR_NUM_AXES];
+static autotune_gains ctl_autotune_gains[MOTOR_NUM_AXES];
+
+/// Supervisor of each axis, and the fault bit each of its causes latches.
+static axis_supervisor ctl_supervisor[MOTOR_NUM_AXES];
+static const uint8_t ctl_supervisor_faults[] =
+{
+	0, TRIP_STALL, TRIP_RUNAWAY, TRIP_ENCODER_LOSS
+};
+
+/// Whether each axis is asleep, and for how many cycles it has been settled.
+static uint8_t ctl_asleep[MOTOR_NUM_AXES];
+static uint16_t ctl_settled_cycles[MOTOR_NUM_AXES];
+
+/// Timing statistics, written by the control ISR.
+static control_stats ctl_stats;
+
+/// The system state seen by the previous control cycle, to detect mode changes.
+static uint8_t ctl_previous_state;
+
+/// The power applied to each motor by the previous control cycle.
+static int16_t ctl_power[MOTOR_NUM_AXES];
+
+//-------------------------------------------------------------------------------------
+/** \brief This function initializes the motors and the control executive.
+ *  \details Call once from main(), before interrupts are enabled. The controller gains
+ *  in pid.h were tuned at PID_TUNED_PERIOD_US, so they are rescaled to the control 
+ *  cycle here.
+ */
+void control_init(void){
+	motors_init();
+
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		motor_axis copy;
+		motor_get_axis(axis, &copy);
+		const motor_axis *motor = &copy;
+#ifdef CURRENT_LOOP
+		pid_init(&ctl_current_pid[axis], motor->k_prop_cur, motor->k_int_cur, 0.0F,
+		         motor->peak_limit, motor->peak_limit, CURRENT_TUNED_PERIOD_US);
+		pid_set_period(&ctl_current_pid[axis], CONTROL_PERIOD_US);
+#endif
+		pid_init(&ctl_pid[axis], motor->k_prop, motor->k_int, motor->k_der,
+		         motor->int_clamp, motor->out_clamp, PID_TUNED_PERIOD_US);
+#ifdef VELOCITY_LOOP
+		pid_set_period(&ctl_pid[axis], CONTROL_PERIOD_US*CONTROL_POSITION_DIVIDER);
+	#ifdef CURRENT_LOOP
+		int16_t effort_limit = motor->current_limit;
+	#else
+		int16_t effort_limit = motor->peak_limit;
+	#endif
+		pid_init(&ctl_velocity_pid[axis], motor->k_prop_vel, motor->k_int_vel, 0.0F,
+		         effort_limit, effort_limit, VELOCITY_TUNED_PERIOD_US);
+		pid_set_period(&ctl_velocity_pid[axis], CONTROL_PERIOD_US);
+		ctl_velocity_cmd[axis] = 0;
+#else
+		pid_set_period(&ctl_pid[axis], CONTROL_PERIOD_US);
+#endif
+		profile_init(&ctl_profile[axis], motor->vel_max, motor->acc_max, motor->jerk_max,
+		             CONTROL_PERIOD_US);
+		friction_init(&ctl_friction[axis], motor->breakaway, motor->dither,
+		              motor->peak_limit);
+		ctl_k_ff_vel[axis] = q16_from_float(motor->k_ff_vel);
+		ctl_k_ff_acc[axis] = q16_from_float(motor->k_ff_acc);
+		ctl_ff_residue[axis] = 0;
+		ctl_power[axis] = 0;
+		ctl_asleep[axis] = 0;
+		ctl_settled_cycles[axis] = 0;
+		ctl_autotune_status[axis] = AUTOTUNE_IDLE;
+		supervisor_init(&ctl_supervisor[axis], motor->power_limit);
+	}
+	autotune_init(&ctl_autotune);
+	ctl_autotune_axis = MOTOR_NUM_AXES;
+	ctl_calibration_started = 0;
+
+	ctl_previous_state = AWAITING_CAL;
+	ctl_setpoint_sequence = 0;
+	ctl_setpoint_age_s = 0;
+	ctl_setpoint_age_us = 0;
+#ifdef VELOCITY_LOOP
+	ctl_position_divider = 0;
+#endif
+	control_reset_stats();
+
+	// Run the control cycle from the Timer 1 overflow, which is where the PWM cycle
+	// starts and where new OCR1A/B values take effect.
+	TIMSK1 |= (1<<TOIE1);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the control executive's timing statistics.
+ *  @param stats The structure into which the statistics are copied.
+ */
+void control_get_stats(control_stats *stats){
+	taskENTER_CRITICAL();
+		*stats = ctl_stats;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the control executive's timing statistics.
+ */
+void control_reset_stats(void){
+	taskENTER_CRITICAL();
+		ctl_stats.cycles = 0;
+		ctl_stats.latency_min = 0xFFFF;
+		ctl_stats.latency_max = 0;
+		ctl_stats.run_time_max = 0;
+		for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+		{
+			ctl_stats.awake_cycles[axis] = 0;
+		}
+		ctl_stats.update_time_sum = 0;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function estimates the CPU time saved by axes sleeping.
+ *  \details Each axis update skipped while asleep is taken to have cost as long as the
+ *  average update at the full rate. The checks made while asleep aren't subtracted.
+ *  The result wraps once over 71 minutes have been saved, so read it at least that 
+ *  often before control_reset_stats().
+ *  @param stats Statistics from control_get_stats().
+ *  @return The time saved since the statistics were reset, in us.
+ */
+uint32_t control_time_saved_us(const control_stats *stats){
+	uint32_t awake = 0;
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		awake += stats->awake_cycles[axis];
+	}
+	if(awake == 0)
+	{
+		return 0;
+	}
+	uint32_t skipped = stats->cycles*MOTOR_NUM_AXES - awake;
+	float update_us = (float)stats->update_time_sum/((float)awake*CONTROL_COUNTS_PER_US);
+	return (uint32_t)(skipped*update_us);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the outcome of the latest autotune of one axis.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param gains The structure into which the measurement and gains are copied.
+ *  @return One of the AUTOTUNE_ status codes; the gains are only valid if it is
+ *  AUTOTUNE_DONE.
+ */
+uint8_t control_get_autotune(uint8_t axis, autotune_gains *gains){
+	uint8_t status;
+	taskENTER_CRITICAL();
+		status = ctl_autotune_status[axis];
+		*gains = ctl_autotune_gains[axis];
+	taskEXIT_CRITICAL();
+	return status;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the breakaway powers of one axis.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param breakaway_pos Where to put the power at which the axis breaks away forward,
+ *  @param breakaway_neg and in reverse, as magnitudes in the controllers' convention.
+ *  @return The status of the latest calibration, one of the FRICTION_CAL_ codes.
+ */
+uint8_t control_get_friction(uint8_t axis, int16_t *breakaway_pos, int16_t *breakaway_neg){
+	uint8_t status;
+	taskENTER_CRITICAL();
+		status = friction_calibrate_status(&ctl_friction[axis]);
+		*breakaway_pos = ctl_friction[axis].breakaway_pos;
+		*breakaway_neg = ctl_friction[axis].breakaway_neg;
+	taskEXIT_CRITICAL();
+	return status;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the fault the supervisor of one axis has found.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @return One of the SUPERVISOR_ codes of supervisor.h.
+ */
+uint8_t control_get_supervisor(uint8_t axis){
+	uint8_t cause;
+	taskENTER_CRITICAL();
+		cause = supervisor_cause(&ctl_supervisor[axis]);
+	taskEXIT_CRITICAL();
+	return cause;
+}
+
+#ifdef CURRENT_LOOP
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the measured current of a motor axis.
+ *  \details The reading is the latest one taken in step with the PWM, at most one 
+ *  control cycle old. The current sense of the driver gives only the magnitude of the
+ *  current it supplies, so the sign is taken from the power applied in the previous
+ *  cycle, and current fed back by the motor while braking reads as about zero.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @return The current in ADC counts, signed like the controller output.
+ */
+static int16_t control_current(uint8_t axis){
+	int16_t current = adc_read(MOTOR_AXIS_BYTE(axis, current));
+	int8_t sign = MOTOR_AXIS_BYTE(axis, sign);
+	return (sign*ctl_power[axis] < 0) ? -current : current;
+}
+#endif
+
+#ifdef VELOCITY_LOOP
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the measured velocity of a motor axis.
+ *  \details The estimate is updated at the start of every control cycle by
+ *  encoder_velocity_update(); see there for how it is measured.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @return The velocity in counts/s times CONTROL_VEL_SCALE.
+ */
+static int32_t control_velocity(uint8_t axis){
+	return encoder_get_velocity(MOTOR_AXIS_BYTE(axis, encoder)) >> CONTROL_VEL_SHIFT;
+}
+#endif
+
+//-------------------------------------------------------------------------------------
+/** \brief This function works out where the trajectory of an axis is now.
+ *  \details task_orient writes the position, rate and acceleration of the trajectory
+ *  only now and then. In between, the position is extrapolated from them, so the axis
+ *  follows the trajectory instead of stepping at each update. Once the update is
+ *  CONTROL_EXTRAPOLATE_MAX_S old the trajectory stops where it got to.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param cmd The commands for this cycle.
+ *  @param rate Where to put the rate of the trajectory now, in counts/s in Q16.16.
+ *  @param accel Where to put its acceleration now, in counts/s^2 in Q16.16.
+ *  @return The position of the trajectory now, in counts.
+ */
+static int32_t control_trajectory(uint8_t axis, const control_command *cmd, q16_t *rate,
+                                  q16_t *accel){
+	// Time since the update in Q16.16 seconds, within a count. The microseconds are 
+	// below 10^6, so halved and times 4295 they fit 32 bits; 4295/32768 is 
+	// 2*65536/10^6.
+	q16_t time = ((q16_t)ctl_setpoint_age_s << 16) 
+	             + (((ctl_setpoint_age_us >> 1)*4295UL) >> 15);
+
+	// x = x0 + t*(v0 + v)/2, with v = v0 + a*t.
+	q16_t rate_now = q16_add_sat(cmd->rate_cmd[axis], q16_mul_sat(cmd->accel_cmd[axis], time));
+	q16_t mean_rate = (cmd->rate_cmd[axis] >> 1) + (rate_now >> 1);
+	q16_t offset = q16_mul_sat(time, mean_rate);
+	*rate = rate_now;
+	*accel = cmd->accel_cmd[axis];
+	if(ctl_setpoint_age_s >= CONTROL_EXTRAPOLATE_MAX_S)
+	{
+		*rate = 0;
+		*accel = 0;
+	}
+	return cmd->position_cmd[axis] + ((offset + (Q16_ONE/2)) >> 16);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the feedforward of one axis.
+ *  \details It is the effort which the model of the axis says the trajectory needs, 
+ *  so the controllers only have to correct for the model's error instead of building
+ *  that effort up from a tracking error. At tracking rates it is a fraction of a 
+ *  count, so the fraction left over each cycle is carried to the next, and the power
+ *  applied averages out to the feedforward rather than rounding to nothing.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param rate The rate of the trajectory, in counts/s in Q16.16.
+ *  @param accel The acceleration of the trajectory, in counts/s^2 in Q16.16.
+ *  @return The feedforward, in motor power or, with CURRENT_LOOP, current counts.
+ */
+static int16_t control_feedforward(uint8_t axis, q16_t rate, q16_t accel){
+	q16_t feedforward = q16_add_sat(q16_mul_sat(ctl_k_ff_vel[axis], rate),
+	                                q16_mul_sat(ctl_k_ff_acc[axis], accel));
+	feedforward = q16_add_sat(feedforward, ctl_ff_residue[axis]);
+	q16_t whole = q16_add_sat(feedforward, Q16_ONE/2) & ~(Q16_ONE - 1);
+	ctl_ff_residue[axis] = feedforward - whole;
+	return q16_to_int(whole);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function limits a value to +/- limit.
+ */
+static int16_t control_clamp(int32_t value, int16_t limit){
+	if(value > limit) return limit;
+	if(value < -limit) return -limit;
+	return value;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the tracking controllers of one axis for one cycle.
+ *  \details The position controller alone sets the motor power, unless it is built 
+ *  with VELOCITY_LOOP and/or CURRENT_LOOP, in which case each loop sets the reference
+ *  of the one inside it. The feedforward of the trajectory is added to the effort,
+ *  and with VELOCITY_LOOP its rate to the velocity command.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param position The measured position, in counts.
+ *  @param reference The position to track, in counts.
+ *  @param rate The rate of the trajectory, in counts/s in Q16.16.
+ *  @param accel The acceleration of the trajectory, in counts/s^2 in Q16.16.
+ *  @return The motor power, in the sign convention of the controller.
+ */
+static int16_t control_track(uint8_t axis, int32_t position, int32_t reference,
+                             q16_t rate, q16_t accel){
+	int16_t effort;
+#ifdef VELOCITY_LOOP
+	if(ctl_position_divider == 0)
+	{
+		int32_t rate_ff = ((rate >> 8)*CONTROL_VEL_SCALE) >> 8;
+		ctl_velocity_cmd[axis] = control_clamp(
+			pid_update(&ctl_pid[axis], position, reference) + rate_ff,
+			ctl_pid[axis].out_clamp);
+	}
+	effort = control_clamp(
+		(int32_t)pid_update(&ctl_velocity_pid[axis], control_velocity(axis), 
+		                    ctl_velocity_cmd[axis]) + control_feedforward(axis, rate, accel),
+		ctl_velocity_pid[axis].out_clamp);
+#else
+	effort = control_clamp(
+		(int32_t)pid_update(&ctl_pid[axis], position, reference) 
+		+ control_feedforward(axis, rate, accel),
+		ctl_pid[axis].out_clamp);
+#endif
+#ifdef CURRENT_LOOP
+	effort = pid_update(&ctl_current_pid[axis], control_current(axis), effort);
+#endif
+	return effort;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function presets the tracking controllers of one axis to take over.
+ *  \details Working from the inside out, each loop is preset to produce what is being
+ *  applied now, and the loop above it to ask for what is measured now, so the 
+ *  takeover causes no bump.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param position The measured position, in counts.
+ */
+static void control_takeover(uint8_t axis, int32_t position){
+	int16_t effort = (int8_t)MOTOR_AXIS_BYTE(axis, sign)*ctl_power[axis];
+#ifdef CURRENT_LOOP
+	int16_t current = control_current(axis);
+	pid_bumpless(&ctl_current_pid[axis], current, current, effort);
+	effort = current;
+#endif
+#ifdef VELOCITY_LOOP
+	int32_t velocity = control_velocity(axis);
+	pid_bumpless(&ctl_velocity_pid[axis], velocity, velocity, effort);
+	effort = velocity;
+	ctl_velocity_cmd[axis] = effort;
+#endif
+	pid_bumpless(&ctl_pid[axis], position, position, effort);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the tracking controllers of one axis.
+ *  @param axis The motor, an index into motor_axes[].
+ */
+static void control_restart(uint8_t axis){
+	pid_reset(&ctl_pid[axis]);
+#ifdef VELOCITY_LOOP
+	pid_reset(&ctl_velocity_pid[axis]);
+	ctl_velocity_cmd[axis] = 0;
+#endif
+#ifdef CURRENT_LOOP
+	pid_reset(&ctl_current_pid[axis]);
+#endif
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function decides whether an axis tracking a target sleeps this cycle.
+ *  \details See CONTROL_SLEEP_DEADBAND for when an axis goes to sleep and wakes up. An
+ *  axis wakes with its profile started from where it is, but its controllers carry on
+ *  where they stopped, so the integral term which overcame friction before is there
+ *  again at once.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param position The measured position, in counts.
+ *  @param trajectory The position of the trajectory, in counts.
+ *  @return Nonzero if the axis is asleep.
+ */
+static uint8_t control_sleep(uint8_t axis, int32_t position, int32_t trajectory){
+	int32_t error = trajectory - position;
+	if(error < 0) error = -error;
+
+	if(ctl_asleep[axis])
+	{
+		if(error <= CONTROL_WAKE_DEADBAND)
+		{
+			return 1;
+		}
+		ctl_asleep[axis] = 0;
+		ctl_settled_cycles[axis] = 0;
+		profile_reset(&ctl_profile[axis], position);
+		friction_reset(&ctl_friction[axis]);
+		supervisor_reset(&ctl_supervisor[axis]);
+		return 0;
+	}
+
+	int32_t velocity = encoder_get_velocity(MOTOR_AXIS_BYTE(axis, encoder));
+	if(velocity < 0) velocity = -velocity;
+	if(error > CONTROL_SLEEP_DEADBAND 
+	   || velocity > (int32_t)CONTROL_SLEEP_VELOCITY*ENC_VEL_SCALE)
+	{
+		ctl_settled_cycles[axis] = 0;
+		return 0;
+	}
+	if(++ctl_settled_cycles[axis] < CONTROL_SLEEP_CYCLES)
+	{
+		return 0;
+	}
+	ctl_asleep[axis] = 1;
+	return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the supervisor of one axis for one cycle.
+ *  \details A fault it finds is latched like a trip, which turns the motors off and
+ *  tells the master the cause.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param position The measured position, in counts.
+ *  @param output The motor power, in the sign convention of the controller.
+ */
+static void control_supervise(uint8_t axis, int32_t position, int16_t output){
+	uint8_t cause = supervisor_update(&ctl_supervisor[axis], output,
+	                                  adc_read(MOTOR_AXIS_BYTE(axis, current)), position,
+	                                  encoder_get_errors(MOTOR_AXIS_BYTE(axis, encoder)));
+	if(cause != SUPERVISOR_OK)
+	{
+		taskENTER_CRITICAL();
+			trip_fault_from_ISR(ctl_supervisor_faults[cause]);
+		taskEXIT_CRITICAL();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the autotune of one axis for one cycle.
+ *  \details The axes are tuned one at a time, from the position each is at, while the
+ *  others are left unpowered. First the power at which the axis breaks away is 
+ *  calibrated, for the friction compensation; an axis which doesn't move at all is
+ *  left at that. Then the relay experiment runs. The relay drives the motor power 
+ *  directly, so what it measures is the plant the position controller sees when it
+ *  sets the power itself; only then are the gains it works out applied. With
+ *  VELOCITY_LOOP or CURRENT_LOOP they are kept for control_get_autotune() only. An
+ *  axis which runs away is a safety fault, latched as TRIP_RUNAWAY. Once every axis
+ *  is done the master is told, which takes effect at its next tick, since this ISR
+ *  doesn't yield.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param position The measured position, in counts.
+ *  @return The motor power, in the sign convention of the controller.
+ */
+static int16_t control_autotune(uint8_t axis, int32_t position){
+	if(axis != ctl_autotune_axis)
+	{
+		return 0;
+	}
+	friction_comp *fc = &ctl_friction[axis];
+	if(!ctl_calibration_started)
+	{
+		friction_calibrate_start(fc, position);
+		ctl_calibration_started = 1;
+	}
+	if(friction_calibrate_status(fc) < FRICTION_CAL_DONE)
+	{
+		return friction_calibrate_update(fc, position);
+	}
+	if(friction_calibrate_status(fc) == FRICTION_CAL_STUCK)
+	{
+		ctl_autotune_status[axis] = AUTOTUNE_NO_OSCILLATION;
+	}
+	else
+	{
+		if(autotune_status(&ctl_autotune) == AUTOTUNE_IDLE)
+		{
+			autotune_start(&ctl_autotune, position,
+			               (int16_t)MOTOR_AXIS_WORD(axis, power_limit) >> AUTOTUNE_RELAY_SHIFT,
+			               CONTROL_PERIOD_US);
+		}
+		int16_t power = autotune_update(&ctl_autotune, position);
+		if(autotune_status(&ctl_autotune) == AUTOTUNE_RUNNING)
+		{
+			return power;
+		}
+
+		// The experiment is over, so this runs once per axis.
+		autotune_gains *gains = &ctl_autotune_gains[axis];
+		ctl_autotune_status[axis] = autotune_gains_get(&ctl_autotune, gains);
+#if !defined(VELOCITY_LOOP) && !defined(CURRENT_LOOP)
+		if(ctl_autotune_status[axis] == AUTOTUNE_DONE)
+		{
+			pid_set_gains(&ctl_pid[axis], gains->k_prop, gains->k_int, gains->k_der);
+			pid_reset(&ctl_pid[axis]);
+		}
+#endif
+		if(ctl_autotune_status[axis] == AUTOTUNE_RUNAWAY)
+		{
+			taskENTER_CRITICAL();
+				trip_fault_from_ISR(TRIP_RUNAWAY);
+			taskEXIT_CRITICAL();
+		}
+		autotune_init(&ctl_autotune);
+	}
+	ctl_calibration_started = 0;
+	if(++ctl_autotune_axis == MOTOR_NUM_AXES)
+	{
+		taskENTER_CRITICAL();
+			master_post_from_ISR(MASTER_EVENT_AUTOTUNE_DONE);
+		taskEXIT_CRITICAL();
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one control cycle for one motor axis.
+ *  \details This function decides, based on the system state, which control signal gets
+ *  to set the power level of the motor. System state is decided/updated in task_master.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param cmd The commands for this cycle.
+ *  @param state_changed Nonzero if the state differs from the previous cycle's.
+ */
+static void control_axis(uint8_t axis, const control_command *cmd, uint8_t state_changed){
+	uint8_t encoder = MOTOR_AXIS_BYTE(axis, encoder);
+	int8_t sign = MOTOR_AXIS_BYTE(axis, sign);
+	motion_profile *prof = &ctl_profile[axis];
+	int32_t position = encoder_get_position(encoder);
+	int16_t power_cmd = 0;
+	int32_t trajectory;
+	q16_t rate;
+	q16_t accel;
+	encoder_velocity_update(encoder);
+
+	if(state_changed)
+	{
+		// The profile starts from where the axis is, so a new mode never starts with
+		// a step in the setpoint.
+		profile_reset(prof, position);
+		friction_reset(&ctl_friction[axis]);
+		supervisor_reset(&ctl_supervisor[axis]);
+		ctl_asleep[axis] = 0;
+		ctl_settled_cycles[axis] = 0;
+
+		// Take over from the joystick at the power it was applying, so the axis
+		// doesn't jump; start from clean controllers in every other case.
+		if(cmd->state == TRACK_TARG && ctl_previous_state == SELECT_TARG)
+		{
+			control_takeover(axis, position);
+		}
+		else
+		{
+			control_restart(axis);
+		}
+	}
+
+	switch(cmd->state){
+		case CALIBRATION  :
+			// map 0-1023 ADC reading to (-1024,+1023)
+			power_cmd = cmd->joystick[axis]*2-1023;
+			encoder_set_position(encoder, 0);
+			break;
+			
+		case SELECT_TARG  :
+			// map 0-1023 ADC reading to (-1024,+1023)
+			power_cmd = cmd->joystick[axis]*2-1023;
+			position_targ_init_SHARED[axis] = position;
+			break;
+			
+		case TRACK_TARG  : // position_cmd_SHARED (aka position_cmd) is updated by task_orient
+			trajectory = control_trajectory(axis, cmd, &rate, &accel);
+			if(control_sleep(axis, position, trajectory))
+			{
+				break;
+			}
+			power_cmd = control_track(axis, position, profile_update(prof, trajectory),
+			                          rate, accel);
+			power_cmd = friction_update(&ctl_friction[axis], power_cmd);
+			control_supervise(axis, position, power_cmd);
+			power_cmd = sign*power_cmd;
+			break;
+
+		case AUTOTUNE  :
+			power_cmd = sign*control_autotune(axis, position);
+			break;
+			
+		default : //Note: states are defined/described in task_master.h/.c
+			power_cmd = 0;
+	}
+	// The trip ISRs also write the PWM, and the ADC ISR the thermal state which 
+	// motor_power() reads, so the outputs are set with interrupts off.
+	taskENTER_CRITICAL();
+		if(ctl_asleep[axis])
+		{
+			motor_sleep(axis);
+		}
+		else
+		{
+			motor_power(axis, power_cmd);
+		}
+	taskEXIT_CRITICAL();
+	ctl_power[axis] = power_cmd;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This ISR is the control executive. It runs the control cycle for all axes
+ *  every CONTROL_PWM_DIVIDER overflows of Timer 1.
+ *  \details Running at the PWM overflow means the new duty cycles are written early 
+ *  in a PWM period, and take effect at the start of the next one, so the control 
+ *  output is in lockstep with the PWM. Tasks write the shared command variables with
+ *  interrupts off, so the snapshot copied here is always consistent. After the 
+ *  snapshot interrupts are enabled again, so encoder edges and trips are not held off
+ *  while the axes are updated; whatever the axis updates share with other ISRs is 
+ *  accessed in critical sections. Note that ISRs run on the stack of whichever task 
+ *  they interrupt, so each task stack needs room for this ISR and one nested ISR.
+ */
+ISR(TIMER1_OVF_vect){
+	static uint8_t divider = 0;
+	uint16_t latency = TCNT1;
+
+	if(++divider < CONTROL_PWM_DIVIDER)
+	{
+		return;
+	}
+	divider = 0;
+
+	// Take the snapshot of the commands for this cycle.
+	control_command cmd;
+	cmd.state = state_SHARED;
+	int16_t joysticks[MOTOR_NUM_JOYSTICKS] = { motor1_power_SHARED, motor2_power_SHARED };
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		cmd.joystick[axis] = joysticks[MOTOR_AXIS_BYTE(axis, joystick)];
+		cmd.position_cmd[axis] = position_cmd_SHARED[axis];
+		cmd.rate_cmd[axis] = rate_cmd_SHARED[axis];
+		cmd.accel_cmd[axis] = accel_cmd_SHARED[axis];
+	}
+	cmd.setpoint_sequence = setpoint_sequence_SHARED;
+	if(cmd.setpoint_sequence != ctl_setpoint_sequence)
+	{
+		ctl_setpoint_sequence = cmd.setpoint_sequence;
+		ctl_setpoint_age_s = 0;
+		ctl_setpoint_age_us = 0;
+	}
+	uint8_t state_changed = (cmd.state != ctl_previous_state);
+	if(state_changed)
+	{
+		// Whatever the way out of an autotune was, the next one starts afresh.
+		autotune_init(&ctl_autotune);
+		ctl_autotune_axis = (cmd.state == AUTOTUNE) ? 0 : MOTOR_NUM_AXES;
+		ctl_calibration_started = 0;
+	}
+
+	// Let the other interrupts in. This overflow stays masked, so a cycle which runs
+	// long can't start another on top of itself, and so does the RTOS tick, whose
+	// context switch would suspend this ISR inside whichever task it interrupted. A
+	// tick held off is credited by timestamp_now_in_ISR() as long as the cycle ends
+	// within one tick, 1 ms; run_time_max in the statistics shows that it does.
+	#ifdef TIMER3_COMPA_vect
+		uint8_t tick_enabled = TIMSK3 & (1<<OCIE3A);
+		TIMSK3 &= ~(1<<OCIE3A);
+	#endif
+	TIMSK1 &= ~(1<<TOIE1);
+	sei();
+
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		// A sleeping axis is only looked at every CONTROL_SLEEP_DIVIDER cycles.
+		if(ctl_asleep[axis] && !state_changed 
+		   && (ctl_stats.cycles & (CONTROL_SLEEP_DIVIDER - 1)) != 0)
+		{
+			continue;
+		}
+		uint16_t update_start = TCNT1;
+		control_axis(axis, &cmd, state_changed);
+		if(!ctl_asleep[axis])
+		{
+			ctl_stats.awake_cycles[axis]++;
+			ctl_stats.update_time_sum += (TCNT1 - update_start) & 0x03FF;
+		}
+	}
+	ctl_previous_state = cmd.state;
+
+	// Age the setpoint, up to the limit of the extrapolation.
+	if(ctl_setpoint_age_s < CONTROL_EXTRAPOLATE_MAX_S)
+	{
+		ctl_setpoint_age_us += CONTROL_PERIOD_US;
+		if(ctl_setpoint_age_us >= 1000000UL)
+		{
+			ctl_setpoint_age_us -= 1000000UL;
+			ctl_setpoint_age_s++;
+		}
+	}
+#ifdef VELOCITY_LOOP
+	if(++ctl_position_divider >= CONTROL_POSITION_DIVIDER)
+	{
+		ctl_position_divider = 0;
+	}
+#endif
+
+	cli();
+	TIMSK1 |= (1<<TOIE1);
+	#ifdef TIMER3_COMPA_vect
+		TIMSK3 |= tick_enabled;
+	#endif
+
+	// Record how late the cycle started and how long it took. An overflow which came
+	// while this ran is still pending, and adds a PWM period to the run time.
+	uint16_t run_time = (TCNT1 - latency) & 0x03FF; // Timer 1 TOP is 0x3FF
+	if(TIFR1 & (1<<TOV1))
+	{
+		run_time += 0x0400;
+	}
+	ctl_stats.cycles++;
+	if(latency < ctl_stats.latency_min) ctl_stats.latency_min = latency;
+	if(latency > ctl_stats.latency_max) ctl_stats.latency_max = latency;
+	if(run_time > ctl_stats.run_time_max) ctl_stats.run_time_max = run_time;
+}
@@ -0,0 +1,103 @@
+//*************************************************************************************
+/** \file control.h
+ *  \brief This file contains #defines, types and function declarations for the
+ *  control executive, which runs position control of all axes from the PWM timer.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _CONTROL_H_
+#define _CONTROL_H_
+
+#include "fixed.h"
+#include "autotune.h"
+
+// The control cycle runs once every CONTROL_PWM_DIVIDER periods of the Timer 1 PWM.
+// Timer 1 runs 10-bit fast PWM at F_CPU/8, so one PWM period is 512 us at 16 MHz and
+// a divider of 2 gives a 1024 us (977 Hz) control cycle.
+#define CONTROL_PWM_DIVIDER 2
+#define CONTROL_PWM_PERIOD_US ( 1024UL*8UL*1000000UL/F_CPU )
+#define CONTROL_PERIOD_US ( CONTROL_PWM_PERIOD_US*CONTROL_PWM_DIVIDER )
+
+// With VELOCITY_LOOP the position loops run once every CONTROL_POSITION_DIVIDER control
+// cycles, and the velocity loops every cycle. Velocities in the loops are in counts/s
+// times CONTROL_VEL_SCALE, which is the encoder's scale shifted down by 
+// CONTROL_VEL_SHIFT so that the errors fit 16 bits.
+#define CONTROL_POSITION_DIVIDER 4
+#define CONTROL_VEL_SHIFT 7
+#define CONTROL_VEL_SCALE ( ENC_VEL_SCALE >> CONTROL_VEL_SHIFT )
+
+// Between updates from task_orient the trajectory is extrapolated from its rate and
+// acceleration, for at most this many seconds after the last update; after that the
+// setpoint holds still until the next one.
+#define CONTROL_EXTRAPOLATE_MAX_S 1800
+
+// An axis tracking a target goes to sleep once it has stayed within 
+// CONTROL_SLEEP_DEADBAND counts of the trajectory, slower than CONTROL_SLEEP_VELOCITY
+// counts/s, for CONTROL_SLEEP_CYCLES cycles. Asleep, its PWM is off and it is only
+// checked every CONTROL_SLEEP_DIVIDER cycles, a power of two. It wakes once the
+// trajectory or a disturbance puts it more than CONTROL_WAKE_DEADBAND counts away, or
+// the system state changes.
+#define CONTROL_SLEEP_DEADBAND 1
+#define CONTROL_SLEEP_VELOCITY 2
+#define CONTROL_SLEEP_CYCLES 500
+#define CONTROL_SLEEP_DIVIDER 64
+#define CONTROL_WAKE_DEADBAND 3
+
+// Timer 1 counts per microsecond; latencies and run times in control_stats use these.
+#define CONTROL_COUNTS_PER_US ( F_CPU/8UL/1000000UL )
+
+/** This structure holds a snapshot of every command the control cycle acts on. The
+ *  control ISR copies it from the shared variables once at the start of each cycle,
+ *  so all axes see the same state and commands for the whole cycle.
+ */
+typedef struct
+{
+	uint8_t state;              ///< System state, from the master task
+	int16_t joystick[MOTOR_NUM_AXES]; ///< Reading of the joystick driving each axis, 0-1023
+	int32_t position_cmd[MOTOR_NUM_AXES]; ///< Position command of each axis, in counts
+	q16_t rate_cmd[MOTOR_NUM_AXES];  ///< Its rate, counts/s, and acceleration, counts/s^2,
+	q16_t accel_cmd[MOTOR_NUM_AXES]; ///< at the time it was written
+	uint8_t setpoint_sequence;  ///< Changes each time the position commands are written
+} control_command;
+
+/** This structure holds timing statistics of the control executive. Times are in
+ *  Timer 1 counts, CONTROL_COUNTS_PER_US per microsecond. The duty of an axis, the 
+ *  share of cycles it ran at the full rate rather than asleep, is awake_cycles/cycles;
+ *  control_time_saved_us() estimates the CPU time its sleep saved.
+ */
+typedef struct
+{
+	uint32_t cycles;            ///< Number of control cycles run
+	uint16_t latency_min;       ///< Shortest delay from PWM cycle start to the ISR
+	uint16_t latency_max;       ///< Longest delay; the jitter is max - min
+	uint16_t run_time_max;      ///< Longest time from the ISR's start to its end
+	uint32_t awake_cycles[MOTOR_NUM_AXES]; ///< Cycles each axis ran at the full rate
+	uint32_t update_time_sum;   ///< Total time of those full rate axis updates
+} control_stats;
+
+void control_init(void);
+void control_get_stats(control_stats *stats);
+void control_reset_stats(void);
+uint32_t control_time_saved_us(const control_stats *stats);
+uint8_t control_get_autotune(uint8_t axis, autotune_gains *gains);
+uint8_t control_get_friction(uint8_t axis, int16_t *breakaway_pos, int16_t *breakaway_neg);
+uint8_t control_get_supervisor(uint8_t axis);
+
+#endif
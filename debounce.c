@@ -0,0 +1,170 @@
+//*************************************************************************************
+/** \file debounce.c
+ *  \brief This file contains the debouncer of the switch inputs. It runs a vertical 
+ *  counter on each port from the RTOS tick, and passes each accepted edge, with its 
+ *  time stamp, to the subscribers of that input.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "timestamp.h"
+#include "debounce.h"
+
+/** This structure holds the debouncer of one port. Bit n of each byte belongs to pin
+ *  n. The two count bytes together are a 2-bit counter for each pin, counting the 
+ *  samples in a row which differ from the debounced state.
+ */
+typedef struct
+{
+	volatile uint8_t *pin;      ///< PINx register of the port
+	uint8_t mask;               ///< Pins which are switch inputs
+	uint8_t state;              ///< Debounced state, 1 where active
+	uint8_t count0;             ///< Low bits of the counters
+	uint8_t count1;             ///< High bits of the counters
+} debounce_port;
+
+/** This structure is one subscriber.
+ */
+typedef struct
+{
+	uint16_t inputs;            ///< Bit n set for each input n it subscribes to
+	debounce_handler handler;   ///< Called for each edge of those inputs
+} debounce_subscriber;
+
+static debounce_port dbn_ports[DEBOUNCE_NUM_PORTS] =
+{
+	{ &PINC, DEBOUNCE_MASK_C, 0, 0, 0 },
+	{ &PIND, DEBOUNCE_MASK_D, 0, 0, 0 }
+};
+
+static debounce_subscriber dbn_subscribers[DEBOUNCE_MAX_SUBSCRIBERS];
+static uint8_t dbn_num_subscribers;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up the switch inputs.
+ *  \details The pins become inputs with pullups. Every input starts out inactive, so
+ *  a switch which is closed at power up, such as a pressed emergency stop, gives an
+ *  edge once the first samples are in. Call once from main(), before the scheduler
+ *  starts.
+ */
+void debounce_init(void){
+	DDRC &= ~DEBOUNCE_MASK_C;
+	PORTC |= DEBOUNCE_MASK_C;
+	DDRD &= ~DEBOUNCE_MASK_D;
+	PORTD |= DEBOUNCE_MASK_D;
+	for(uint8_t p = 0; p < DEBOUNCE_NUM_PORTS; p++)
+	{
+		dbn_ports[p].state = 0;
+		dbn_ports[p].count0 = 0;
+		dbn_ports[p].count1 = 0;
+	}
+	dbn_num_subscribers = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function adds a subscriber to edges of some of the inputs.
+ *  @param inputs Bit n set for each input n to subscribe to, see DEBOUNCE_INPUT().
+ *  @param handler The function to call, from the tick interrupt, for each edge.
+ *  @return Nonzero if subscribed, 0 if there are already DEBOUNCE_MAX_SUBSCRIBERS.
+ */
+uint8_t debounce_subscribe(uint16_t inputs, debounce_handler handler){
+	uint8_t subscribed = 0;
+	taskENTER_CRITICAL();
+		if(dbn_num_subscribers < DEBOUNCE_MAX_SUBSCRIBERS)
+		{
+			dbn_subscribers[dbn_num_subscribers].inputs = inputs;
+			dbn_subscribers[dbn_num_subscribers].handler = handler;
+			dbn_num_subscribers++;
+			subscribed = 1;
+		}
+	taskEXIT_CRITICAL();
+	return subscribed;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function passes the edges of one port to their subscribers.
+ *  @param p The port, one of the DEBOUNCE_PORT_ numbers.
+ *  @param edges Bit n set for each pin n which has just changed state.
+ *  @param time The time stamp of the edges.
+ */
+static void debounce_publish(uint8_t p, uint8_t edges, uint32_t time){
+	debounce_event event;
+	event.time = time;
+	for(uint8_t bit = 0; bit < 8; bit++)
+	{
+		if(!(edges & (1<<bit)))
+		{
+			continue;
+		}
+		event.input = DEBOUNCE_INPUT(p, bit);
+		event.active = (dbn_ports[p].state >> bit) & 1;
+		for(uint8_t s = 0; s < dbn_num_subscribers; s++)
+		{
+			if(dbn_subscribers[s].inputs & (1U << event.input))
+			{
+				dbn_subscribers[s].handler(&event);
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the debouncer. Call it from the RTOS tick hook.
+ *  \details Every DEBOUNCE_TICK_DIVIDER ticks each port is sampled, and all its pins 
+ *  are debounced at once with a vertical counter: each pin's counter counts the 
+ *  samples in a row which differ from its debounced state, and is cleared by any 
+ *  sample which agrees. When it wraps after 4 such samples the pin's state flips.
+ */
+void debounce_tick(void){
+	static uint8_t divider = 0;
+	if(++divider < DEBOUNCE_TICK_DIVIDER)
+	{
+		return;
+	}
+	divider = 0;
+
+	for(uint8_t p = 0; p < DEBOUNCE_NUM_PORTS; p++)
+	{
+		debounce_port *port = &dbn_ports[p];
+		uint8_t sample = ~*port->pin & port->mask;
+		uint8_t delta = sample ^ port->state;
+		port->count1 = (port->count1 ^ port->count0) & delta;
+		port->count0 = ~port->count0 & delta;
+		uint8_t edges = delta & ~(port->count0 | port->count1);
+		port->state ^= edges;
+		if(edges)
+		{
+			debounce_publish(p, edges, timestamp_now_in_ISR());
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the debounced state of one input.
+ *  @param input The input, one of the DEBOUNCE_ numbers.
+ *  @return Nonzero if the input is active.
+ */
+uint8_t debounce_active(uint8_t input){
+	return (dbn_ports[input >> 3].state >> (input & 7)) & 1;
+}
@@ -0,0 +1,72 @@
+//*************************************************************************************
+/** \file debounce.h
+ *  \brief This file contains #defines, types and function declarations for the
+ *  debouncer of the switch inputs, which runs from the RTOS tick.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _DEBOUNCE_H_
+#define _DEBOUNCE_H_
+
+// Inputs are numbered by port and bit, so up to 8 per port. Each port is debounced as a
+// whole byte; the masks select the pins which are switch inputs. All of them are
+// switches to ground with the internal pullup on, so an input is active when low.
+#define DEBOUNCE_NUM_PORTS 2
+#define DEBOUNCE_PORT_C 0
+#define DEBOUNCE_PORT_D 1
+#define DEBOUNCE_INPUT(port, bit) ( ((port) << 3) | (bit) )
+
+#define DEBOUNCE_BUTTON   DEBOUNCE_INPUT(DEBOUNCE_PORT_C, PC3) ///< Target set button
+#define DEBOUNCE_LIMIT_1  DEBOUNCE_INPUT(DEBOUNCE_PORT_C, PC2) ///< Motor 1 limit switch
+#define DEBOUNCE_LIMIT_2  DEBOUNCE_INPUT(DEBOUNCE_PORT_C, PC7) ///< Motor 2 limit switch
+#define DEBOUNCE_ESTOP    DEBOUNCE_INPUT(DEBOUNCE_PORT_D, PD2) ///< Emergency stop
+#define DEBOUNCE_STOW     DEBOUNCE_INPUT(DEBOUNCE_PORT_D, PD3) ///< Wind stow request
+#define DEBOUNCE_AUTOTUNE DEBOUNCE_INPUT(DEBOUNCE_PORT_D, PD6) ///< Autotune request
+
+#define DEBOUNCE_MASK_C ( (1<<PC3) | (1<<PC2) | (1<<PC7) )
+#define DEBOUNCE_MASK_D ( (1<<PD2) | (1<<PD3) | (1<<PD6) )
+
+// The pins are sampled every DEBOUNCE_TICK_DIVIDER RTOS ticks, and a change counts
+// once it has been seen in 4 samples in a row, so after 8 ms at 1 kHz.
+#define DEBOUNCE_TICK_DIVIDER 2
+
+// Number of subscribers the debouncer can hold.
+#define DEBOUNCE_MAX_SUBSCRIBERS 4
+
+/** This structure is one edge of a debounced input, as passed to subscribers.
+ */
+typedef struct
+{
+	uint8_t input;              ///< Which input, one of the DEBOUNCE_ numbers
+	uint8_t active;             ///< Nonzero if the input has just become active
+	uint32_t time;              ///< When the edge was accepted, from timestamp_now()
+} debounce_event;
+
+/** A subscriber's handler. It runs in the RTOS tick interrupt, so it has to be short
+ *  and may only use the FromISR functions of FreeRTOS.
+ */
+typedef void (*debounce_handler)(const debounce_event *event);
+
+void debounce_init(void);
+uint8_t debounce_subscribe(uint16_t inputs, debounce_handler handler);
+void debounce_tick(void);
+uint8_t debounce_active(uint8_t input);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,387 @@
+//*************************************************************************************
+/** \file encoder.c
+ *  \brief This file contains the quadrature encoder drivers and the encoder
+ *  interrupt service routine.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+#include "queue.h"                          // FreeRTOS inter-task communication queues
+#include "croutine.h" 
+#include "semphr.h"
+
+#include "shares.h"
+#include "timestamp.h"
+#include "encoder.h"
+
+/** The multi-turn position of each axis in encoder counts. Written only by the
+ *  encoder ISR and encoder_set_position(); read through encoder_get_position().
+ */
+static volatile int32_t enc_position[ENC_NUM_AXES];
+
+/** Net count of legal edges on each axis. Unlike enc_position it is never
+ *  re-referenced, so the velocity estimator can difference it across a calibration.
+ */
+static volatile int16_t enc_edges[ENC_NUM_AXES];
+
+/// Time stamp of the most recent legal edge on each axis.
+static volatile uint32_t enc_edge_time[ENC_NUM_AXES];
+
+/** Sequence counter for enc_position, enc_edges and enc_edge_time. It is odd while
+ *  an update is in progress, and changes on every update, so readers can detect a 
+ *  torn copy and retry instead of disabling interrupts. Each update adds 2, so a 
+ *  reader held off for 32768 updates would see the same count and take a torn copy;
+ *  at the highest edge rate that is hundreds of milliseconds, far longer than any 
+ *  task is preempted. An 8-bit count would wrap in 128 updates, about a millisecond.
+ *  The AVR reads it as two bytes; a read torn by the ISR is odd, or differs from the 
+ *  read after the copy, so it is retried like a torn copy.
+ */
+static volatile uint16_t enc_sequence;
+
+/// Count of illegal transitions on each axis, see encoder_get_errors().
+static volatile uint16_t enc_errors[ENC_NUM_AXES];
+
+/** This table holds the position step for every encoder transition. It is indexed by
+ *  (previous_state<<2)|current_state, where a state is (B<<1)|A for one channel. The
+ *  legal sequence 3,2,0,1 counts down, and the reverse sequence counts up. Entries
+ *  marked ENC_ILLEGAL are transitions in which both lines changed at once.
+ */
+static const int8_t enc_transition[16] = {
+//  current:  0             1             2             3
+	          0,           -1,            1,  ENC_ILLEGAL,   // previous 0
+	          1,            0,  ENC_ILLEGAL,           -1,   // previous 1
+	         -1,  ENC_ILLEGAL,            0,            1,   // previous 2
+	ENC_ILLEGAL,            1,           -1,            0    // previous 3
+};
+
+/// State of the velocity estimator for one axis.
+typedef struct
+{
+	int16_t edges;          ///< Edge count at the start of the measuring window
+	uint32_t edge_time;     ///< Time stamp of the edge which started the window
+	uint32_t period;        ///< Average time between edges in the last window
+	int32_t velocity;       ///< Latest estimate, counts/s times ENC_VEL_SCALE
+	uint8_t has_edge;       ///< Nonzero once the window starts from an edge
+} enc_velocity_state;
+
+static enc_velocity_state enc_velocity[ENC_NUM_AXES];
+
+/// The encoder lines as read by the last run of the ISR, both channels packed.
+static uint8_t enc_previous_pins;
+
+/// Bit mask of axes which skipped a state, see encoder_get_overspeed().
+static volatile uint8_t enc_overspeed;
+
+/// Number of runs of the encoder ISR, see encoder_get_isr_count().
+static volatile uint32_t enc_isr_count;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function initializes all motor encoders.
+ *  \details This function initializes all of the required pins, variables, and
+ *  interrupts necessary to use the quadrature encoders.
+ */
+void encoders_init(void){	// Set encoder pins as inputs.
+	DDRA &= (uint8_t)~ENC_PIN_MASK;
+
+    //Global variables, defined in encoder.c. Only access in critical
+    //sections, or in tasks with priority : configMAX_PRIORITIES.
+    //Initialization is the only exception to this rule.
+    enc_sequence = 0;
+    for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+    {
+    	enc_position[axis] = 0;
+    	enc_errors[axis] = 0;
+    	enc_edges[axis] = 0;
+    	enc_edge_time[axis] = 0;
+    	enc_velocity[axis].edges = 0;
+    	enc_velocity[axis].edge_time = 0;
+    	enc_velocity[axis].period = ENC_VEL_TIMEOUT;
+    	enc_velocity[axis].velocity = 0;
+    	enc_velocity[axis].has_edge = 0;
+    }
+
+	// Start the decoder from the real line states, so the first edge is not
+	// mistaken for an illegal transition.
+	enc_previous_pins = PINA & ENC_PIN_MASK;
+
+	enc_overspeed = 0;
+	enc_isr_count = 0;
+
+	#ifdef ENCODER_SAMPLED
+		// Sample the encoder inputs from Timer 2 in CTC mode, at F_CPU/8/(OCR2A+1).
+		TCCR2A = (1<<WGM21);
+		TCCR2B = (1<<CS21);
+		OCR2A = (F_CPU/8UL)/ENC_SAMPLE_HZ - 1;
+		TIMSK2 |= (1<<OCIE2A);
+	#else
+		// Set encoder inputs as Pin Change interrupts.
+		PCICR |= (1<<PCIE0);
+	    PCMSK0 |= ENC_PIN_MASK; // PCINT0-7 are PA0-7
+	#endif
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns a consistent snapshot of an axis position.
+ *  \details The copy is retried if the encoder ISR updated the position while it was
+ *  being read, so interrupts are never disabled. Safe to call from any task.
+ *  @param axis One of the ENC_AXIS_ numbers from encoder.h.
+ *  @return The multi-turn position of the axis, in encoder counts.
+ */
+int32_t encoder_get_position(uint8_t axis){
+	uint16_t sequence;
+	int32_t position;
+	do
+	{
+		sequence = enc_sequence;
+		position = enc_position[axis];
+	} while( (sequence & 1) || sequence != enc_sequence );
+	return position;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function re-references an axis to a new position.
+ *  \details Used to zero the axis during calibration. The write is done with
+ *  interrupts off, so no encoder edge can be lost between reading and writing.
+ *  @param axis One of the ENC_AXIS_ numbers from encoder.h.
+ *  @param position The new position of the axis, in encoder counts.
+ */
+void encoder_set_position(uint8_t axis, int32_t position){
+	taskENTER_CRITICAL();
+		enc_sequence++;
+		enc_position[axis] = position;
+		enc_sequence++;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function updates the velocity estimate of one axis.
+ *  \details Call this periodically from the task which owns the axis. The window over
+ *  which velocity is measured runs from edge to edge, so it is always exact to within
+ *  one timer count. When fewer than ENC_VEL_COUNT_MIN edges arrived since the last
+ *  call, the window is held open until an edge arrives and the result is the inverse
+ *  of the edge period (1/T method); while waiting, the estimate decays as 1/(time
+ *  since the last edge). At higher speeds the edge count over the window is used (M
+ *  method), with the window span taken from the edge time stamps.
+ *  @param axis One of the ENC_AXIS_ numbers from encoder.h.
+ */
+void encoder_velocity_update(uint8_t axis){
+	enc_velocity_state *est = &enc_velocity[axis];
+	uint16_t sequence;
+	int16_t edges;
+	uint32_t edge_time;
+	uint32_t now;
+	do
+	{
+		sequence = enc_sequence;
+		edges = enc_edges[axis];
+		edge_time = enc_edge_time[axis];
+	} while( (sequence & 1) || sequence != enc_sequence );
+	now = timestamp_now();
+
+	int16_t counts = edges - est->edges;
+	uint16_t magnitude = (counts < 0) ? -counts : counts;
+	int32_t velocity;
+
+	if(counts == 0)
+	{
+		// No new edge. Keep the window open, and once the time since the last edge
+		// exceeds the last period, the axis must be slower than that period says.
+		uint32_t waiting = now - est->edge_time;
+		velocity = est->velocity;
+		if(waiting >= ENC_VEL_TIMEOUT)
+		{
+			velocity = 0;
+		}
+		else if(waiting > est->period && velocity != 0)
+		{
+			velocity = (TIMESTAMP_HZ*ENC_VEL_SCALE)/waiting;
+			if(est->velocity < 0)
+			{
+				velocity = -velocity;
+			}
+		}
+	}
+	else if(!est->has_edge)
+	{
+		// The first window opened at encoders_init(), not on an edge, so its span 
+		// would be short. It only finds the edge which opens the next window.
+		velocity = est->velocity;
+		est->has_edge = 1;
+		est->edges = edges;
+		est->edge_time = edge_time;
+	}
+	else
+	{
+		uint32_t span = edge_time - est->edge_time;
+		if(span == 0)
+		{
+			span = 1;
+		}
+		uint32_t quotient = (TIMESTAMP_HZ*ENC_VEL_SCALE)/span;
+		velocity = (uint32_t)magnitude*quotient;
+		if(magnitude < ENC_VEL_COUNT_MIN)
+		{
+			// 1/T: the window is long, so add back the remainder of the quotient. 
+			// With so few edges the product can't overflow.
+			velocity += ((uint32_t)magnitude*((TIMESTAMP_HZ*ENC_VEL_SCALE)%span))/span;
+		}
+		if(counts < 0)
+		{
+			velocity = -velocity;
+		}
+		est->edges = edges;
+		est->edge_time = edge_time;
+		est->period = span/magnitude;
+	}
+
+	taskENTER_CRITICAL();
+		est->velocity = velocity;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the latest velocity estimate of an axis.
+ *  @param axis One of the ENC_AXIS_ numbers from encoder.h.
+ *  @return The velocity in counts/s times ENC_VEL_SCALE.
+ */
+int32_t encoder_get_velocity(uint8_t axis){
+	int32_t velocity;
+	taskENTER_CRITICAL();
+		velocity = enc_velocity[axis].velocity;
+	taskEXIT_CRITICAL();
+	return velocity;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns and clears the overspeed flags.
+ *  \details In sampled mode (ENCODER_SAMPLED) a transition which skips a state means
+ *  an axis moved more than one count between samples, so counts were lost. The 
+ *  encoder ISR latches a flag for the axis when that happens. In pin change mode the
+ *  flags are also set by illegal transitions, which there indicate noise or an
+ *  ISR held off for too long.
+ *  @return A bit mask with bit ENC_AXIS_ set for each axis which lost counts.
+ */
+uint8_t encoder_get_overspeed(void){
+	uint8_t overspeed;
+	taskENTER_CRITICAL();
+		overspeed = enc_overspeed;
+		enc_overspeed = 0;
+	taskEXIT_CRITICAL();
+	return overspeed;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the number of illegal transitions seen on an axis.
+ *  @param axis One of the ENC_AXIS_ numbers from encoder.h.
+ *  @return The count since encoders_init(); it wraps at 65535.
+ */
+uint16_t encoder_get_errors(uint8_t axis){
+	uint16_t errors;
+	taskENTER_CRITICAL();
+		errors = enc_errors[axis];
+	taskEXIT_CRITICAL();
+	return errors;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the number of times the encoder ISR has run.
+ *  \details Multiplied by the cycles taken by one run of the ISR, the rate of this
+ *  count gives the CPU load of encoder decoding. In pin change mode it follows the
+ *  edge rate, in sampled mode it is fixed at ENC_SAMPLE_HZ.
+ */
+uint32_t encoder_get_isr_count(void){
+	uint32_t count;
+	taskENTER_CRITICAL();
+		count = enc_isr_count;
+	taskEXIT_CRITICAL();
+	return count;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function decodes a new reading of the encoder lines.
+ *  \details Every axis is decoded with one table lookup, so the run time does not
+ *  depend on the encoder state, and grows linearly with ENC_NUM_AXES. Called from the
+ *  encoder ISR only.
+ *  @param pins The encoder lines, read from PINA and masked with ENC_PIN_MASK.
+ */
+static inline void encoder_decode(uint8_t pins){
+	uint32_t now = timestamp_now_in_ISR();
+	uint8_t previous = enc_previous_pins;
+	uint8_t current = pins;
+
+	// Mark the positions as being updated, for encoder_get_position().
+	enc_sequence++;
+
+	// Each pass decodes the lowest two bits, then shifts the next axis down. The loop
+	// has a constant count, so the compiler can unroll it.
+	for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+	{
+		int8_t step = enc_transition[ ((previous & 0x03)<<2) | (current & 0x03) ];
+		if (step == ENC_ILLEGAL)
+		{
+			enc_errors[axis]++;
+			enc_overspeed |= (1<<axis);
+		}
+		else
+		{
+			enc_position[axis] += step;
+			if (step)
+			{
+				enc_edges[axis] += step;
+				enc_edge_time[axis] = now;
+			}
+		}
+		previous >>= 2;
+		current >>= 2;
+	}
+
+	enc_sequence++;
+
+	//save previous state
+	enc_previous_pins = pins;
+}
+
+#ifdef ENCODER_SAMPLED
+//-------------------------------------------------------------------------------------
+/** \brief This ISR samples the encoder lines at a fixed rate, ENC_SAMPLE_HZ.
+ *  \details Its CPU load is fixed no matter how fast the shafts turn. Samples in 
+ *  which no line changed return right away.
+ */
+ISR(TIMER2_COMPA_vect){
+	uint8_t pins = PINA & ENC_PIN_MASK;
+	enc_isr_count++;
+	if (pins != enc_previous_pins)
+	{
+		encoder_decode(pins);
+	}
+}
+#else
+//-------------------------------------------------------------------------------------
+/** \brief This ISR updates the motors position when a pin change interrupt has occured
+ *  as a result of a change in the encoder output waveforms.
+ */
+ISR(PCINT0_vect){
+	enc_isr_count++;
+	encoder_decode(PINA & ENC_PIN_MASK);
+}
+#endif // ENCODER_SAMPLED
@@ -0,0 +1,72 @@
+//*************************************************************************************
+/** \file encoder.h
+ *  \brief This file contains #defines and function declarations for the quadrature
+ *  encoder drivers.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _ENCODER_H_
+#define _ENCODER_H_
+
+// Axis numbers used to select an encoder in the position functions. Must match
+// MOTOR_NUM_AXES in task_motors.h; up to four axes fit on port A.
+#define ENC_AXIS_M1 0
+#define ENC_AXIS_M2 1
+#ifndef ENC_NUM_AXES
+#define ENC_NUM_AXES 2
+#endif
+
+// ENCODER CONTROL SIGNALS
+// The decoder reads all lines with a single read of PINA, and expects axis n on 
+// bits 2n (A) and 2n+1 (B) of that port.
+#define ENC_A_M1 PA0
+#define ENC_B_M1 PA1
+#define ENC_A_M2 PA2
+#define ENC_B_M2 PA3
+#define ENC_PIN_MASK ( (uint8_t)((1<<(2*ENC_NUM_AXES)) - 1) )
+
+// Rate at which the encoder lines are sampled when compiled with -DENCODER_SAMPLED.
+// An axis which moves more than one count per sample is flagged as overspeed. Must
+// be between 7813 and 2000000 Hz to fit Timer 2 with a prescaler of 8.
+#define ENC_SAMPLE_HZ 10000UL
+
+// Velocities are given in counts/s times this scale, so slow axes keep resolution.
+#define ENC_VEL_SCALE 1024
+
+// Below this many counts per update the estimator times single edge periods (1/T),
+// at or above it the counts in the window are divided by their span (M method).
+#define ENC_VEL_COUNT_MIN 8
+
+// After this long without an edge, in time stamp counts, the velocity is zero.
+#define ENC_VEL_TIMEOUT ( 30UL*TIMESTAMP_HZ )
+
+// Marks a transition in the decode table which skips a state (both lines changed).
+#define ENC_ILLEGAL 2
+
+void encoders_init(void);
+int32_t encoder_get_position(uint8_t axis);
+void encoder_set_position(uint8_t axis, int32_t position);
+void encoder_velocity_update(uint8_t axis);
+int32_t encoder_get_velocity(uint8_t axis);
+uint8_t encoder_get_overspeed(void);
+uint16_t encoder_get_errors(uint8_t axis);
+uint32_t encoder_get_isr_count(void);
+
+#endif
@@ -0,0 +1,191 @@
+//*************************************************************************************
+/** \file fixed.h
+ *  \brief This file contains types and saturating arithmetic for Q15 and Q16.16
+ *  fixed-point numbers.
+ *  \details The functions are static inline, since they're used in the motor control
+ *  loop and a function call would cost as much as the arithmetic itself. Only 
+ *  q16_from_float() uses floating point, and is meant for configuration code.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _FIXED_H_
+#define _FIXED_H_
+
+#include <stdint.h>
+
+/// Q15 fraction, range [-1, 1), resolution 2^-15.
+typedef int16_t q15_t;
+
+/// Q16.16 number, range [-32768, 32768), resolution 2^-16.
+typedef int32_t q16_t;
+
+#define Q15_MAX INT16_MAX
+#define Q15_MIN INT16_MIN
+#define Q16_MAX INT32_MAX
+#define Q16_MIN INT32_MIN
+#define Q16_ONE 0x00010000L
+
+// Convert a constant to Q15 or Q16.16, rounding to nearest. Intended for constants
+// which the compiler can fold; with a variable argument this uses floating point.
+#define Q15(x) ( (q15_t)( (x) >= 0 ? (x)*32768.0 + 0.5 : (x)*32768.0 - 0.5 ) )
+#define Q16(x) ( (q16_t)( (x) >= 0 ? (x)*65536.0 + 0.5 : (x)*65536.0 - 0.5 ) )
+
+//-------------------------------------------------------------------------------------
+/** \brief This function converts an integer to Q16.16, saturating.
+ */
+static inline q16_t q16_from_int(int32_t value)
+{
+	if(value > INT16_MAX) return Q16_MAX;
+	if(value < INT16_MIN) return Q16_MIN;
+	return value*Q16_ONE;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function converts a float to Q16.16, rounding and saturating.
+ *  \details Uses soft-float, so keep it out of control loops; use it when gains or
+ *  limits are set.
+ */
+static inline q16_t q16_from_float(float value)
+{
+	if(value >= 32767.99998F) return Q16_MAX;
+	if(value <= -32768.0F) return Q16_MIN;
+	return (q16_t)( value >= 0 ? value*65536.0F + 0.5F : value*65536.0F - 0.5F );
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function converts a Q16.16 number to an integer, truncating toward 
+ *  zero the same way a float to integer conversion does.
+ */
+static inline int16_t q16_to_int(q16_t value)
+{
+	if(value < 0)
+	{
+		return (int16_t)((value + (Q16_ONE - 1)) >> 16);
+	}
+	return (int16_t)(value >> 16);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function adds two Q16.16 numbers, saturating on overflow.
+ */
+static inline q16_t q16_add_sat(q16_t a, q16_t b)
+{
+	q16_t sum = (q16_t)((uint32_t)a + (uint32_t)b);
+	// Overflow happened if both operands have the same sign and the sum does not.
+	if( ((a ^ sum) & (b ^ sum)) < 0 )
+	{
+		return (a < 0) ? Q16_MIN : Q16_MAX;
+	}
+	return sum;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function subtracts Q16.16 b from a, saturating on overflow.
+ */
+static inline q16_t q16_sub_sat(q16_t a, q16_t b)
+{
+	q16_t difference = (q16_t)((uint32_t)a - (uint32_t)b);
+	if( ((a ^ b) & (a ^ difference)) < 0 )
+	{
+		return (a < 0) ? Q16_MIN : Q16_MAX;
+	}
+	return difference;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function limits a Q16.16 number to +/- limit.
+ */
+static inline q16_t q16_clamp(q16_t value, q16_t limit)
+{
+	if(value > limit) return limit;
+	if(value < -limit) return -limit;
+	return value;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function multiplies two Q16.16 numbers, saturating on overflow.
+ *  \details The product is built from four 16x16 bit partial products, which the
+ *  AVR multiplier handles directly, instead of a 64-bit multiply. The result is
+ *  truncated toward zero.
+ */
+static inline q16_t q16_mul_sat(q16_t a, q16_t b)
+{
+	uint8_t negative = (a < 0) ^ (b < 0);
+	uint32_t ua = (a < 0) ? -(uint32_t)a : (uint32_t)a;
+	uint32_t ub = (b < 0) ? -(uint32_t)b : (uint32_t)b;
+	uint16_t a_hi = ua >> 16;
+	uint16_t a_lo = ua;
+	uint16_t b_hi = ub >> 16;
+	uint16_t b_lo = ub;
+	uint32_t limit = negative ? 0x80000000UL : 0x7FFFFFFFUL;
+
+	uint32_t high = (uint32_t)a_hi*b_hi;
+	if(high > 0x7FFF)
+	{
+		return negative ? Q16_MIN : Q16_MAX;
+	}
+	uint32_t result = high << 16;
+	uint32_t part = (uint32_t)a_hi*b_lo;
+	result += part;
+	if(result < part) result = 0xFFFFFFFFUL;
+	part = (uint32_t)a_lo*b_hi;
+	result += part;
+	if(result < part) result = 0xFFFFFFFFUL;
+	part = ((uint32_t)a_lo*b_lo) >> 16;
+	result += part;
+	if(result < part) result = 0xFFFFFFFFUL;
+
+	if(result > limit)
+	{
+		result = limit;
+	}
+	return negative ? -(q16_t)(result - 1) - 1 : (q16_t)result;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function adds two Q15 numbers, saturating on overflow.
+ */
+static inline q15_t q15_add_sat(q15_t a, q15_t b)
+{
+	int32_t sum = (int32_t)a + b;
+	if(sum > Q15_MAX) return Q15_MAX;
+	if(sum < Q15_MIN) return Q15_MIN;
+	return sum;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function multiplies two Q15 numbers, saturating -1 * -1 to Q15_MAX.
+ */
+static inline q15_t q15_mul_sat(q15_t a, q15_t b)
+{
+	int32_t product = ((int32_t)a*b) >> 15;
+	if(product > Q15_MAX) return Q15_MAX;
+	return (q15_t)product;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function scales a Q16.16 number by a Q15 fraction.
+ */
+static inline q16_t q16_mul_q15(q16_t a, q15_t b)
+{
+	return q16_mul_sat(a, (q16_t)b << 1);
+}
+
+#endif
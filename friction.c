@@ -0,0 +1,197 @@
+//*************************************************************************************
+/** \file friction.c
+ *  \brief This file contains the static friction compensation of the motor power path
+ *  and the calibration which measures the power at which each axis breaks away.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <stdint.h>
+
+#include "friction.h"
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets the compensation offsets from the breakaway powers.
+ */
+static void friction_set_offsets(friction_comp *fc){
+	fc->offset_pos = ((int32_t)fc->breakaway_pos*FRICTION_COMP_PERCENT)/100;
+	fc->offset_neg = ((int32_t)fc->breakaway_neg*FRICTION_COMP_PERCENT)/100;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up the compensation of one axis.
+ *  @param breakaway The breakaway power to use until calibrated, in both directions.
+ *  @param dither The dither amplitude, 0 for none.
+ *  @param limit The largest magnitude of power to put out.
+ */
+void friction_init(friction_comp *fc, int16_t breakaway, int16_t dither, int16_t limit){
+	fc->breakaway_pos = breakaway;
+	fc->breakaway_neg = breakaway;
+	fc->dither = dither;
+	fc->limit = limit;
+	fc->cal_status = FRICTION_CAL_IDLE;
+	friction_set_offsets(fc);
+	friction_reset(fc);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the state of the compensation and stops a calibration.
+ *  \details The breakaway powers are kept, and so is the status of the last 
+ *  calibration which finished, until the next one starts. A calibration stopped 
+ *  part way hasn't changed the powers, so its status goes back to FRICTION_CAL_IDLE.
+ *  Call it whenever the output which the compensation follows starts from scratch.
+ */
+void friction_reset(friction_comp *fc){
+	fc->direction = 0;
+	fc->dither_sign = 1;
+	fc->dither_count = 0;
+	if(fc->cal_status < FRICTION_CAL_DONE)
+	{
+		fc->cal_status = FRICTION_CAL_IDLE;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function compensates one controller output for static friction.
+ *  \details Once the output is past FRICTION_ON counts in one direction, the offset 
+ *  of that direction is added to it, until it is back within FRICTION_OFF counts. The
+ *  hysteresis keeps an output which hovers about zero from toggling the offset on and
+ *  off every cycle. Without any breakaway or dither the output is passed through.
+ *  @param power The controller output.
+ *  @return The compensated output, clamped to +/- the limit.
+ */
+int16_t friction_update(friction_comp *fc, int16_t power){
+	if(fc->direction*power <= FRICTION_OFF)
+	{
+		fc->direction = 0;
+	}
+	if(power > FRICTION_ON)
+	{
+		fc->direction = 1;
+	}
+	else if(power < -FRICTION_ON)
+	{
+		fc->direction = -1;
+	}
+
+	int16_t output = power;
+	if(fc->direction > 0)
+	{
+		output += fc->offset_pos;
+	}
+	else if(fc->direction < 0)
+	{
+		output -= fc->offset_neg;
+	}
+
+	if(fc->dither)
+	{
+		output += fc->dither_sign*fc->dither;
+		if(++fc->dither_count >= FRICTION_DITHER_CYCLES)
+		{
+			fc->dither_count = 0;
+			fc->dither_sign = -fc->dither_sign;
+		}
+	}
+
+	if(output > fc->limit) return fc->limit;
+	if(output < -fc->limit) return -fc->limit;
+	return output;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function starts the calibration of the breakaway powers.
+ *  \details The axis must be at rest. Call friction_calibrate_update() every update
+ *  from then on; it ramps the power forward until the axis moves, lets it stop, then
+ *  does the same in reverse.
+ *  @param position The position of the axis now, in counts.
+ */
+void friction_calibrate_start(friction_comp *fc, int32_t position){
+	fc->cal_status = FRICTION_CAL_POSITIVE;
+	fc->cal_start = position;
+	fc->cal_power = 0;
+	fc->cal_count = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one update of the breakaway calibration.
+ *  \details The breakaway powers are only changed once both directions have been
+ *  measured. If the axis hasn't moved by the time the ramp reaches the power limit,
+ *  the calibration stops as FRICTION_CAL_STUCK and the old powers are kept.
+ *  @param position The position of the axis, in counts.
+ *  @return The power to apply, 0 once the calibration is over.
+ */
+int16_t friction_calibrate_update(friction_comp *fc, int32_t position){
+	int32_t moved = position - fc->cal_start;
+	switch(fc->cal_status){
+		case FRICTION_CAL_POSITIVE :
+		case FRICTION_CAL_NEGATIVE :
+			if(fc->cal_status == FRICTION_CAL_NEGATIVE)
+			{
+				moved = -moved;
+			}
+			if(moved >= FRICTION_MOTION_COUNTS)
+			{
+				if(fc->cal_status == FRICTION_CAL_POSITIVE)
+				{
+					fc->cal_breakaway = fc->cal_power;
+					fc->cal_status = FRICTION_CAL_REST;
+					fc->cal_count = 0;
+				}
+				else
+				{
+					fc->breakaway_pos = fc->cal_breakaway;
+					fc->breakaway_neg = fc->cal_power;
+					friction_set_offsets(fc);
+					fc->cal_status = FRICTION_CAL_DONE;
+				}
+				return 0;
+			}
+			if(++fc->cal_count >= FRICTION_RAMP_CYCLES)
+			{
+				fc->cal_count = 0;
+				if(++fc->cal_power > fc->limit)
+				{
+					fc->cal_status = FRICTION_CAL_STUCK;
+					return 0;
+				}
+			}
+			return (fc->cal_status == FRICTION_CAL_POSITIVE) ? fc->cal_power : -fc->cal_power;
+
+		case FRICTION_CAL_REST :
+			if(++fc->cal_count >= FRICTION_REST_CYCLES)
+			{
+				friction_calibrate_start(fc, position);
+				fc->cal_status = FRICTION_CAL_NEGATIVE;
+			}
+			return 0;
+
+		default :
+			return 0;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the status of the breakaway calibration.
+ *  @return One of the FRICTION_CAL_ status codes from friction.h.
+ */
+uint8_t friction_calibrate_status(const friction_comp *fc){
+	return fc->cal_status;
+}
@@ -0,0 +1,93 @@
+//*************************************************************************************
+/** \file friction.h
+ *  \brief This file contains #defines, types and function declarations for the static
+ *  friction compensation, which lifts small controller outputs over the power at which
+ *  an axis breaks away, and for the calibration which measures that power.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _FRICTION_H_
+#define _FRICTION_H_
+
+// Default breakaway power of each axis, in motor power counts, used until it has been
+// calibrated. 0 leaves the compensation off.
+#define FRICTION_BREAKAWAY_1 0
+#define FRICTION_BREAKAWAY_2 0
+
+// Amplitude of the dither added to the output of each axis, in motor power counts. The
+// dither is a square wave which flips every FRICTION_DITHER_CYCLES updates, 0 is off.
+#define FRICTION_DITHER_1 0
+#define FRICTION_DITHER_2 0
+#define FRICTION_DITHER_CYCLES 4
+
+// The compensation starts pushing in one direction once the controller output is past
+// FRICTION_ON counts that way, and stops once it is back within FRICTION_OFF counts.
+#define FRICTION_ON 3
+#define FRICTION_OFF 1
+
+// Share of the breakaway power which is added, in percent. Once moving, friction is
+// lower than at breakaway, so adding all of it overshoots into a limit cycle.
+#define FRICTION_COMP_PERCENT 80
+
+// The calibration ramps the power up by one count every FRICTION_RAMP_CYCLES updates 
+// until the axis moves FRICTION_MOTION_COUNTS, then rests FRICTION_REST_CYCLES updates
+// before it ramps the other way.
+#define FRICTION_RAMP_CYCLES 10
+#define FRICTION_MOTION_COUNTS 2
+#define FRICTION_REST_CYCLES 500
+
+// Calibration status codes
+#define FRICTION_CAL_IDLE 0             ///< Not run
+#define FRICTION_CAL_POSITIVE 1         ///< Ramping up the positive power
+#define FRICTION_CAL_REST 2             ///< Waiting for the axis to stop
+#define FRICTION_CAL_NEGATIVE 3         ///< Ramping up the negative power
+#define FRICTION_CAL_DONE 4             ///< Measured; the breakaway powers are in use
+#define FRICTION_CAL_STUCK 5            ///< No motion up to the power limit
+
+/** This structure holds the compensation state of one axis. Powers are in the sign
+ *  convention of the controllers, and the breakaway of each direction is kept apart,
+ *  since gravity and gearing make them differ.
+ */
+typedef struct
+{
+	int16_t breakaway_pos;      ///< Power at which the axis starts to move forward
+	int16_t breakaway_neg;      ///< and in reverse, as a magnitude
+	int16_t offset_pos;         ///< FRICTION_COMP_PERCENT of each breakaway, the power
+	int16_t offset_neg;         ///< added while compensating
+	int16_t dither;             ///< Dither amplitude, 0 for none
+	int16_t limit;              ///< Largest magnitude of power
+	int8_t direction;           ///< Direction being compensated, -1, 0 or +1
+	int8_t dither_sign;         ///< Sign of the dither now
+	uint8_t dither_count;       ///< Updates since the dither last flipped
+	uint8_t cal_status;         ///< One of the FRICTION_CAL_ codes
+	int32_t cal_start;          ///< Position at the start of the ramp
+	int16_t cal_power;          ///< Power of the ramp now, as a magnitude
+	int16_t cal_breakaway;      ///< Breakaway measured forward, until both are known
+	uint16_t cal_count;         ///< Updates at this ramp step, or resting
+} friction_comp;
+
+void friction_init(friction_comp *fc, int16_t breakaway, int16_t dither, int16_t limit);
+void friction_reset(friction_comp *fc);
+int16_t friction_update(friction_comp *fc, int16_t power);
+void friction_calibrate_start(friction_comp *fc, int32_t position);
+int16_t friction_calibrate_update(friction_comp *fc, int32_t position);
+uint8_t friction_calibrate_status(const friction_comp *fc);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+//*************************************************************************************
+/** \file fsm.c
+ *  \brief This file contains the table driven finite state machine engine, and the
+ *  trace which records every state transition.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "timestamp.h"
+#include "fsm.h"
+
+#ifdef TRANSITION_TRACE
+	/// The transition trace, a ring buffer which overwrites its oldest records.
+	static fsm_trace_record fsm_ring[FSM_TRACE_SIZE];
+
+	/// Where the next record goes in the ring.
+	static uint8_t fsm_ring_next;
+
+	/// Number of records in the ring, up to FSM_TRACE_SIZE.
+	static uint8_t fsm_ring_used;
+#endif
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up a state machine.
+ *  @param fsm The state machine.
+ *  @param table The transition table, which must be in flash (PROGMEM).
+ *  @param size The number of rows in the table.
+ *  @param initial The state the machine starts in.
+ *  @param machine The number of the machine in the trace.
+ *  @param context A pointer passed to the guards and actions, which may be NULL.
+ */
+void fsm_init(fsm_machine *fsm, const fsm_transition *table, uint8_t size,
+              uint8_t initial, uint8_t machine, void *context){
+	fsm->table = table;
+	fsm->size = size;
+	fsm->state = initial;
+	fsm->machine = machine;
+	fsm->context = context;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function feeds an event to a state machine.
+ *  \details The table is searched from the top for a row which matches the present
+ *  state and the event, and whose guard, if any, passes. That row's action is run,
+ *  the state changes and the transition is traced.
+ *  @param fsm The state machine.
+ *  @param event The event.
+ *  @return Nonzero if a transition was taken.
+ */
+uint8_t fsm_dispatch(fsm_machine *fsm, uint8_t event){
+	const fsm_transition *row = fsm->table;
+	for(uint8_t index = 0; index < fsm->size; index++, row++)
+	{
+		uint8_t state = pgm_read_byte(&row->state);
+		uint8_t next = pgm_read_byte(&row->next);
+		if(pgm_read_byte(&row->event) != event)
+		{
+			continue;
+		}
+		if(state != fsm->state && (state != FSM_ANY_STATE || next == fsm->state))
+		{
+			continue;
+		}
+
+		fsm_guard guard = (fsm_guard)pgm_read_ptr(&row->guard);
+		if(guard && !guard(fsm->context))
+		{
+			continue;
+		}
+		fsm_action action = (fsm_action)pgm_read_ptr(&row->action);
+		if(action)
+		{
+			action(fsm->context);
+		}
+		fsm_trace(fsm->machine, fsm->state, next, event);
+		fsm->state = next;
+		return 1;
+	}
+	return 0;
+}
+
+#ifdef TRANSITION_TRACE
+//-------------------------------------------------------------------------------------
+/** \brief This function records a state transition in the trace.
+ *  \details It takes a few microseconds and prints nothing, so it can be used in 
+ *  time-critical code. It may be called from tasks and from ISRs.
+ *  @param machine The number of the machine, see FSM_MACHINE_MASTER.
+ *  @param from The state left.
+ *  @param to The state entered.
+ *  @param event The event which caused the transition, or FSM_NO_EVENT.
+ */
+void fsm_trace(uint8_t machine, uint8_t from, uint8_t to, uint8_t event){
+	taskENTER_CRITICAL();
+		fsm_trace_record *record = &fsm_ring[fsm_ring_next];
+		record->time = timestamp_now_in_ISR();
+		record->machine = machine;
+		record->from = from;
+		record->to = to;
+		record->event = event;
+		fsm_ring_next = (fsm_ring_next + 1) & (FSM_TRACE_SIZE - 1);
+		if(fsm_ring_used < FSM_TRACE_SIZE)
+		{
+			fsm_ring_used++;
+		}
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the trace, oldest record first.
+ *  \details Records are copied one at a time with interrupts off, so a transition 
+ *  traced during the copy may replace a record which hasn't been copied yet.
+ *  @param records Where to copy the records.
+ *  @param size Room in records. If the trace holds more, the newest are copied.
+ *  @return The number of records copied.
+ */
+uint8_t fsm_trace_read(fsm_trace_record *records, uint8_t size){
+	uint8_t count;
+	uint8_t index;
+	taskENTER_CRITICAL();
+		count = fsm_ring_used;
+		index = fsm_ring_next - count;
+	taskEXIT_CRITICAL();
+
+	if(count > size)
+	{
+		index += count - size;
+		count = size;
+	}
+	for(uint8_t copied = 0; copied < count; copied++, index++)
+	{
+		taskENTER_CRITICAL();
+			*records++ = fsm_ring[index & (FSM_TRACE_SIZE - 1)];
+		taskEXIT_CRITICAL();
+	}
+	return count;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sends the trace, oldest record first, as raw binary.
+ *  \details Each record is sent as 8 bytes: the time, least significant byte first,
+ *  then the machine, from, to and event bytes. A host script can unpack the dump with
+ *  the format "<IBBBB". Records are fetched one at a time, so a transition traced
+ *  during the dump may be sent in place of the oldest record.
+ *  @param put A function which sends one byte, such as usart_send().
+ */
+void fsm_trace_dump(void (*put)(uint8_t data)){
+	fsm_trace_record record;
+	uint8_t count;
+	uint8_t index;
+	taskENTER_CRITICAL();
+		count = fsm_ring_used;
+		index = fsm_ring_next - count;
+	taskEXIT_CRITICAL();
+
+	for(; count > 0; count--, index++)
+	{
+		taskENTER_CRITICAL();
+			record = fsm_ring[index & (FSM_TRACE_SIZE - 1)];
+		taskEXIT_CRITICAL();
+		for(uint8_t shift = 0; shift < 32; shift += 8)
+		{
+			put(record.time >> shift);
+		}
+		put(record.machine);
+		put(record.from);
+		put(record.to);
+		put(record.event);
+	}
+}
+#endif // TRANSITION_TRACE
@@ -0,0 +1,108 @@
+//*************************************************************************************
+/** \file fsm.h
+ *  \brief This file contains types and function declarations for the table driven
+ *  finite state machine engine and the state transition trace.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _FSM_H_
+#define _FSM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A transition table row with this as its state matches in every state but its own
+// next state, for events such as faults which lead to one state from anywhere.
+#define FSM_ANY_STATE 0xFF
+
+// Event code recorded for transitions which weren't caused by an event, such as those
+// of the frt_task classes.
+#define FSM_NO_EVENT 0xFF
+
+// Machine numbers in the trace. State machines in C pick their own number below
+// FSM_MACHINE_TASKS; frt_task objects are numbered from it in order of creation.
+#define FSM_MACHINE_MASTER 0
+#define FSM_MACHINE_TASKS 0x80
+
+// Number of records kept in the transition trace. Must be a power of two.
+#define FSM_TRACE_SIZE 32
+
+/// A guard; the transition is only taken if it returns nonzero.
+typedef uint8_t (*fsm_guard)(void *context);
+
+/// An action, run when the transition is taken, before the state changes.
+typedef void (*fsm_action)(void *context);
+
+/** This structure is one row of a transition table. Tables are kept in flash, with
+ *  PROGMEM, and searched in order, so the first row which matches wins.
+ */
+typedef struct
+{
+	uint8_t state;              ///< State the transition leaves, or FSM_ANY_STATE
+	uint8_t event;              ///< Event which causes the transition
+	uint8_t next;               ///< State the transition enters
+	fsm_guard guard;            ///< Condition for the transition, or NULL for none
+	fsm_action action;          ///< Action of the transition, or NULL for none
+} fsm_transition;
+
+/** This structure holds one state machine: its table, which is shared by all machines
+ *  of the same kind, and its present state.
+ */
+typedef struct
+{
+	const fsm_transition *table; ///< Transition table, in flash
+	uint8_t size;               ///< Number of rows in the table
+	uint8_t state;              ///< Present state
+	uint8_t machine;            ///< Number of the machine in the trace
+	void *context;              ///< Passed to the guards and actions
+} fsm_machine;
+
+/** This structure is one record of the transition trace, 8 bytes long. The time is
+ *  in time stamp counts, TIMESTAMP_HZ per second, and wraps like the time stamp.
+ */
+typedef struct
+{
+	uint32_t time;              ///< When the transition happened
+	uint8_t machine;            ///< Which machine made it
+	uint8_t from;               ///< State it left
+	uint8_t to;                 ///< State it entered
+	uint8_t event;              ///< Event which caused it, or FSM_NO_EVENT
+} fsm_trace_record;
+
+void fsm_init(fsm_machine *fsm, const fsm_transition *table, uint8_t size,
+              uint8_t initial, uint8_t machine, void *context);
+uint8_t fsm_dispatch(fsm_machine *fsm, uint8_t event);
+
+#ifdef TRANSITION_TRACE
+	void fsm_trace(uint8_t machine, uint8_t from, uint8_t to, uint8_t event);
+	uint8_t fsm_trace_read(fsm_trace_record *records, uint8_t size);
+	void fsm_trace_dump(void (*put)(uint8_t data));
+#else
+	#define fsm_trace(machine, from, to, event)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
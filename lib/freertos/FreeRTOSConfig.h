@@ -160,7 +160,7 @@
  *  RTOS tick timer interrupt. Code which does timing tasks can be put here. This
  *  functionality is seldom used.
  */
-#define configUSE_TICK_HOOK             0
+#define configUSE_TICK_HOOK             1
 
 /** When this define is set to 1, the RTOS tick counter will only be 16 bits in size.
  *  This makes the RTOS tick interrupt a little quicker and saves some memory, but
@@ -34,6 +34,7 @@
 //*************************************************************************************
 
 #include "frt_task.h"                       // Pull in the base class header file
+#include "fsm.h"                            // Transition trace, from the project directory
 
 
 /** This is a pointer to the most recently created task. Because it's static, any task
@@ -130,21 +131,24 @@ void frt_task::_call_users_run_method (frt_task* p_task)
 
 //-------------------------------------------------------------------------------------
 /** This method is called within run() to cause a state transition. It changes the 
- *  variable 'state', and if transition logging is enabled, it logs the transition to 
- *  help with debugging.
+ *  variable 'state', and if transition logging is enabled, it records the transition
+ *  in the binary transition trace (see fsm.h), which takes a few microseconds instead
+ *  of the milliseconds a printout would. Tasks are numbered in the trace from 
+ *  FSM_MACHINE_TASKS, in the order in which they were created.
+ *
+ *  Tasks code their state machines as a switch in run() which picks the next state
+ *  itself, rather than as a table of events, so this method doesn't go through 
+ *  fsm_dispatch(); it shares the trace with the table driven machines instead, and
+ *  records FSM_NO_EVENT as the event. 
  *  @param new_state The state to which we will transition
  */
 void frt_task::transition_to (uint8_t new_state)
 {
 	state = new_state;
 
-	// If transition tracing is enabled, print data about the transition
+	// If transition tracing is enabled, record the transition
 	#ifdef TRANSITION_TRACE
-		if (p_serial)
-		{
-			*p_serial << tick_res_time () << ":" << (char*)(pcTaskGetTaskName (handle))
-					<< ":" << previous_state << PMS ("->") << state << endl;
-		}
+		fsm_trace (trace_machine, previous_state, state, FSM_NO_EVENT);
 	#endif // TRANSITION_TRACE
 
 	previous_state = state;
@@ -218,6 +222,10 @@ frt_task::frt_task (const char* a_name,
 	// Initialize the finite state machine and its transition logger
 	state = 0;
 	previous_state = 0;
+	#ifdef TRANSITION_TRACE
+		trace_machine = (prev_task_pointer == NULL) ? FSM_MACHINE_TASKS 
+			: prev_task_pointer->trace_machine + 1;
+	#endif // TRANSITION_TRACE
 
 	// If stack tracing is being used, save the address of the top of the stack
 	top_of_stack = ++portStackTopForTask;
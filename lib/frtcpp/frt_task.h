@@ -259,6 +259,14 @@ class frt_task
 		 */
 		uint8_t previous_state;
 
+		#ifdef TRANSITION_TRACE
+			/** This is the number of this task's state machine in the transition 
+			 *  trace, worked out once by the constructor so that transition_to() 
+			 *  needn't walk the list of tasks.
+			 */
+			uint8_t trace_machine;
+		#endif
+
 		/** This variable keeps track of how many times the task has run through its
 		 *  loop. In order for it to work, the user must either use the \c setup() and
 		 *  \c loop() methods (activated by defining \c TASK_SETUP_AND_LOOP in the
@@ -44,6 +44,13 @@
 #include "task_motors.h"
 #include "task_safety.h"
 #include "task_master.h"
+#include "adc.h"
+#include "encoder.h"
+#include "debounce.h"
+#include "trip.h"
+#include "thermal.h"
+#include "safety_log.h"
+#include "control.h"
 #include "uart.h"
 
 
@@ -74,6 +81,15 @@ void task_heartbeat(void *pvParameters)
     }
 }
 
+//-------------------------------------------------------------------------------------
+/** \brief The RTOS calls this function from every tick interrupt, at 1 kHz.
+ */
+void vApplicationTickHook(void);
+void vApplicationTickHook(void)
+{
+    debounce_tick();
+}
+
 //-------------------------------------------------------------------------------------
 /** The main function sets up the RTOS.  Some test tasks are created. Then the 
  *  scheduler is started up; the scheduler runs until power is turned off or there's a 
@@ -90,107 +106,24 @@ int main (void)
 	
 	// Create a queue of 30 character pointers for the communications task.
     comms_queue = xQueueCreate(SIZE_COMMS_QUEUE, sizeof(char_pointer));
-    adc_mutex_semaphore = xSemaphoreCreateMutex();
+    master_queue = xQueueCreate(SIZE_MASTER_QUEUE, sizeof(master_event));
 
     xTaskCreate(task_sensors,"Sensors", STACK_SIZE_SENSORS, NULL, PRIORITY_SENSORS, NULL);
     xTaskCreate(task_comms,"Comms", STACK_SIZE_COMMS, NULL, PRIORITY_COMMS, NULL);  
     xTaskCreate(task_heartbeat,"Heartbeat", 280, NULL, PRIORITY_HEARTBEAT, NULL); 
-    xTaskCreate(task_motor1, "Motor1", STACK_SIZE_MOTORS, NULL, PRIORITY_MOTORS, NULL);
-    xTaskCreate(task_motor2, "Motor2", STACK_SIZE_MOTORS, NULL, PRIORITY_MOTORS, NULL);
     xTaskCreate(task_master, "Master", STACK_SIZE_MASTER, NULL, PRIORITY_MASTER, NULL);
     xTaskCreate(task_orient,"Orient", STACK_SIZE_ORIENT, NULL, PRIORITY_ORIENT, NULL);
     xTaskCreate(task_safety, "Safety", STACK_SIZE_SAFETY, NULL, PRIORITY_SAFETY, NULL);
     
+	adc_init();
+	debounce_init();
+	safety_log_init();
 	encoders_init();
+	control_init();
+	trip_init();
+	thermal_init();
 	sei();
 	
 	vTaskStartScheduler ();
 	while(1);
 }
-
-//-------------------------------------------------------------------------------------
-/** \brief This ISR updates the motors position when a pin change interrupt has occured
- *  as a result of a change in the encoder output waveforms.
- */
-ISR(PCINT0_vect){
-	//previous state of Motor 1 is saved via static var
-	static uint8_t previous_state_M1;
-
-	//previous state of Motor 2 is saved via static var
-	static uint8_t previous_state_M2;
-	
-	//get new encoder state
-    uint8_t state_M1 = ( (1<<ENC_A_M1)|(1<<ENC_B_M1) ) & PINA;
-    uint8_t state_M2 = ( (1<<ENC_A_M2)|(1<<ENC_B_M2) ) & PINA;
-
-    state_M2 = (state_M2>>2); // Motor 2's encoders are on PORT A, bits 2 and 3. This
-                              // line of code maps their possible states to unsigned 
-                              // integer values 0 through 3.
-	
-	//check encoder state sequence
-	const uint8_t sequence[6]={3,2,0,1,3,2};
-	
-	for (uint8_t i=1; i<5;i++)
-	{
-		if (state_M1==sequence[i])
-		{
-			//check for ccw, write to dir
-			if (previous_state_M1==sequence[i-1])
-			{
-				position_M1_SHARED = position_M1_SHARED - 1;
-				break;
-			}
-			//check for cw, write to dir
-			else if(previous_state_M1==sequence[i+1])
-			{
-				position_M1_SHARED = position_M1_SHARED + 1;
-				break;
-			}
-			//if same, pin change likely occured on M2
-			else if (previous_state_M1==sequence[i])
-			{
-			        position_M1_SHARED = position_M1_SHARED;
-				break;
-			}
-			//check for error, write to error
-			else
-			{
-				error_M1_SHARED++;
-				break;
-			}
-		}
-	}
-	for (uint8_t i=1; i<5;i++)
-	{
-		if (state_M2==sequence[i])
-		{
-			//check for ccw, write to dir
-			if (previous_state_M2==sequence[i-1])
-			{
-				position_M2_SHARED = position_M2_SHARED - 1;
-				break;
-			}
-			//check for cw, write to dir
-			else if(previous_state_M2==sequence[i+1])
-			{
-				position_M2_SHARED = position_M2_SHARED + 1;
-				break;
-			}
-			//if same, pin change likely occured on M2
-			else if (previous_state_M2==sequence[i])
-			{
-			        position_M2_SHARED = position_M2_SHARED;
-				break;
-			}
-			//check for error, write to error
-			else
-			{
-				error_M2_SHARED++;
-				break;
-			}
-		}
-	}
-	//save previous state
-	previous_state_M1 = state_M1;
-	previous_state_M2 = state_M2;
-}
\ No newline at end of file
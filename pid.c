@@ -1,6 +1,6 @@
 //*************************************************************************************
 /** \file pid.c
- *  \brief This file contains function definitions for both PID functions.
+ *  \brief This file contains function definitions for the PID controller.
  *
  *  Revisions:
  *    \li 11-27-2014 JF, ML, JR created original file
@@ -25,56 +25,130 @@
 #include <avr/io.h>
 #include "pid.h"
 
-int16_t pid_1(int16_t feedback_signal, int16_t reference_input)
-{    
-	static float int_out_prev = 0; 
-	static float error_prev = 0;
-	
-	float error;
-	float der_out;
-	float prop_out;
-	float int_out;
-		
-	
-	error = reference_input - feedback_signal;
-	///////////////////////////////////////
-	// Proportional Term Calculation
-	prop_out = K_PROP_1*error;
-	
-	
-	///////////////////////////////////////
-	// Integral Term Calculation
-	
-	int_out = K_INT_1*(float)error + int_out_prev; 
-	
-	if( int_out > INT_CLAMP_1 ) // This integrator saturation limit should be something that is specified as a parameter of the constructor
-	{
-		int_out = INT_CLAMP_1;
-	}
-	if( int_out < -INT_CLAMP_1 )
-	{
-		int_out = -INT_CLAMP_1;
-	}
-	
-	int_out_prev = int_out;
-	//////////////////////////////////////
-	// Derivative Term Calculation
-	der_out = K_DER_1*(error - error_prev );     //derivative of measurement--constant ref drops out.
-	
-	error_prev = error;
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up a PID controller and clears its state.
+ *  @param pid The controller to set up.
+ *  @param k_prop The proportional gain.
+ *  @param k_int The integral gain, per sample.
+ *  @param k_der The derivative gain, per sample.
+ *  @param int_clamp The saturation limit of the integral term.
+ *  @param out_clamp The saturation limit of the output.
+ *  @param period_us The sample period, in us, at which pid_update() will be called.
+ */
+void pid_init(pid_controller *pid, float k_prop, float k_int, float k_der,
+              float int_clamp, int16_t out_clamp, uint16_t period_us)
+{
+	pid->int_clamp = int_clamp;
+	pid->out_clamp = out_clamp;
+	pid->period_us = period_us;
+	#ifdef PID_FIXED_POINT
+		pid->int_clamp_q = q16_from_float(int_clamp);
+	#endif
+	pid_set_gains(pid, k_prop, k_int, k_der);
+	pid_reset(pid);
+}
 
-	int16_t out = prop_out + int_out + der_out;
-	
-	if( out  > OUT_CLAMP_1 ) out = OUT_CLAMP_1;
-	if( out < -OUT_CLAMP_1 ) out = -OUT_CLAMP_1;
-	return out;
+//-------------------------------------------------------------------------------------
+/** \brief This function changes the gains of a PID controller while it runs.
+ *  \details The integral term is kept, so the output doesn't jump due to a change of
+ *  the integral gain.
+ */
+void pid_set_gains(pid_controller *pid, float k_prop, float k_int, float k_der)
+{
+	pid->k_prop = k_prop;
+	pid->k_int = k_int;
+	pid->k_der = k_der;
+	#ifdef PID_FIXED_POINT
+		pid->k_prop_q = q16_from_float(k_prop);
+		pid->k_int_q = q16_from_float(k_int*256.0F);
+		pid->k_der_q = q16_from_float(k_der);
+	#endif
 }
 
-int16_t pid_2(int16_t feedback_signal, int16_t reference_input)
-{    
-	static float int_out_prev = 0; 
-	static float error_prev = 0;
-	
+//-------------------------------------------------------------------------------------
+/** \brief This function changes the sample period of a PID controller.
+ *  \details The per-sample integral and derivative gains are rescaled, so that the
+ *  controller keeps the same behavior in continuous time.
+ *  @param period_us The new sample period, in us.
+ */
+void pid_set_period(pid_controller *pid, uint16_t period_us)
+{
+	float ratio = (float)period_us/(float)pid->period_us;
+	pid->period_us = period_us;
+	pid_set_gains(pid, pid->k_prop, pid->k_int*ratio, pid->k_der/ratio);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the integral and derivative state of a controller.
+ *  \details Call this when the controller is (re)started from scratch, for example 
+ *  after a fault or a re-reference of the position.
+ */
+void pid_reset(pid_controller *pid)
+{
+	pid->int_out = 0;
+	pid->error_prev = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function prepares a controller to take over from another source.
+ *  \details The integral term is preset so that the next update, with the same 
+ *  inputs, returns the output which was applied until now, and the derivative term
+ *  sees no step. This avoids a bump in motor power when the system switches from
+ *  manual control to the controller.
+ *  @param feedback_signal The measured position at the time of the switch.
+ *  @param reference_input The position command at the time of the switch.
+ *  @param output The output which was being applied until now.
+ */
+void pid_bumpless(pid_controller *pid, int32_t feedback_signal, int32_t reference_input,
+                  int16_t output)
+{
+#ifdef PID_FIXED_POINT
+	q16_t error = q16_from_int(reference_input - feedback_signal);
+	q16_t int_out = q16_from_int(output);
+	int_out = q16_sub_sat(int_out, q16_mul_sat(pid->k_prop_q, error));
+	int_out = q16_sub_sat(int_out, q16_mul_sat(pid->k_int_q, error) >> 8);
+
+	pid->int_out = q16_clamp(int_out, pid->int_clamp_q);
+	pid->error_prev = error;
+#else
+	float error = reference_input - feedback_signal;
+	float int_out = (float)output - pid->k_prop*error - pid->k_int*error;
+	
+	if( int_out > pid->int_clamp ) int_out = pid->int_clamp;
+	if( int_out < -pid->int_clamp ) int_out = -pid->int_clamp;
+
+	pid->int_out = int_out;
+	pid->error_prev = error;
+#endif
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one sample of a PID controller.
+ *  @param feedback_signal The measured position.
+ *  @param reference_input The position command.
+ *  @return The controller output, clamped to +/- out_clamp.
+ */
+int16_t pid_update(pid_controller *pid, int32_t feedback_signal, int32_t reference_input)
+{
+#ifdef PID_FIXED_POINT
+	// Same algorithm as below, in Q16.16 with saturation at every step. The error is
+	// limited to +/-32767 counts, far beyond where the output saturates.
+	q16_t error = q16_from_int(reference_input - feedback_signal);
+	q16_t prop_out = q16_mul_sat(pid->k_prop_q, error);
+
+	// k_int is in Q8.24, so the product comes out in Q8.24 and is shifted to Q16.16.
+	q16_t int_out = q16_add_sat(q16_mul_sat(pid->k_int_q, error) >> 8, pid->int_out);
+	int_out = q16_clamp(int_out, pid->int_clamp_q);
+	pid->int_out = int_out;
+
+	q16_t der_out = q16_mul_sat(pid->k_der_q, q16_sub_sat(error, pid->error_prev));
+	pid->error_prev = error;
+
+	int16_t out = q16_to_int(q16_add_sat(q16_add_sat(prop_out, int_out), der_out));
+	if( out  > pid->out_clamp ) out = pid->out_clamp;
+	if( out < -pid->out_clamp ) out = -pid->out_clamp;
+	return out;
+#else
 	float error;
 	float der_out;
 	float prop_out;
@@ -84,33 +158,35 @@ int16_t pid_2(int16_t feedback_signal, int16_t reference_input)
 	error = reference_input - feedback_signal;
 	///////////////////////////////////////
 	// Proportional Term Calculation
-	prop_out = K_PROP_2*error;
+	prop_out = pid->k_prop*error;
 	
 	
 	///////////////////////////////////////
 	// Integral Term Calculation
 	
-	int_out = K_INT_2*(float)error + int_out_prev; 
+	int_out = pid->k_int*(float)error + pid->int_out; 
 	
-	if( int_out > INT_CLAMP_2 ) // This integrator saturation limit should be something that is specified as a parameter of the constructor
+	if( int_out > pid->int_clamp )
 	{
-		int_out = INT_CLAMP_2;
+		int_out = pid->int_clamp;
 	}
-	if( int_out < -INT_CLAMP_2 )
+	if( int_out < -pid->int_clamp )
 	{
-		int_out = -INT_CLAMP_2;
+		int_out = -pid->int_clamp;
 	}
-
-	int_out_prev = int_out;
+	
+	pid->int_out = int_out;
 	//////////////////////////////////////
 	// Derivative Term Calculation
-	der_out = K_DER_2*(error - error_prev );     //derivative of measurement--constant ref drops out.
+	der_out = pid->k_der*(error - pid->error_prev );
 	
-	error_prev = error;
+	pid->error_prev = error;
 
-	int16_t out = prop_out + int_out + der_out;
-	
-	if( out  > OUT_CLAMP_2 ) out = OUT_CLAMP_2;
-	if( out < -OUT_CLAMP_2 ) out = -OUT_CLAMP_2;
-	return out;
-}
\ No newline at end of file
+	// Clamp before converting, since a large gain times a large error can be far 
+	// beyond what an int16_t holds.
+	float out = prop_out + int_out + der_out;
+	if( out  > pid->out_clamp ) out = pid->out_clamp;
+	if( out < -pid->out_clamp ) out = -pid->out_clamp;
+	return (int16_t)out;
+#endif
+}
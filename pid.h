@@ -1,6 +1,6 @@
 //*************************************************************************************
 /** \file pid.h
- *  \brief This file contains the #defines, and function declarations for the PID 
+ *  \brief This file contains the #defines, type and function declarations for the PID
  *  functions.
  *
  *  Revisions:
@@ -24,20 +24,151 @@
 
 #ifndef PID_H_
 #define PID_H_
-int16_t pid_1(int16_t feedback_signal,int16_t reference_input);
-int16_t pid_2(int16_t feedback_signal,int16_t reference_input);
 
+#ifdef PID_FIXED_POINT
+	#include "fixed.h"
+#endif
+
+// The default output clamps below are the peak powers PWR_PEAK_Mx
+#include "task_motors.h"
+
+/** This structure holds the gains, limits and state of one PID controller, so that
+ *  any number of axes can each have their own. The integral and derivative gains are
+ *  per sample, and period_us records the sample period they were tuned for.
+ *  If PID_FIXED_POINT is defined, the gains are also kept in Q16.16 and pid_update() 
+ *  runs entirely in fixed point, so the control loop does no soft-float calls.
+ */
+typedef struct
+{
+	float k_prop;           ///< Proportional gain
+	float k_int;            ///< Integral gain, per sample
+	float k_der;            ///< Derivative gain, per sample
+	float int_clamp;        ///< Saturation limit of the integral term
+	int16_t out_clamp;      ///< Saturation limit of the output
+	uint16_t period_us;     ///< Sample period, in us, for which k_int, k_der are set
+#ifdef PID_FIXED_POINT
+	q16_t k_prop_q;         ///< k_prop in Q16.16
+	int32_t k_int_q;        ///< k_int in Q8.24, since per-sample k_int is tiny at 1 kHz
+	q16_t k_der_q;          ///< k_der in Q16.16
+	q16_t int_clamp_q;      ///< int_clamp in Q16.16
+	q16_t int_out;          ///< Integral term from the last update
+	q16_t error_prev;       ///< Error from the last update
+#else
+	float int_out;          ///< Integral term from the last update
+	float error_prev;       ///< Error from the last update
+#endif
+} pid_controller;
+
+void pid_init(pid_controller *pid, float k_prop, float k_int, float k_der,
+              float int_clamp, int16_t out_clamp, uint16_t period_us);
+void pid_set_gains(pid_controller *pid, float k_prop, float k_int, float k_der);
+void pid_set_period(pid_controller *pid, uint16_t period_us);
+void pid_reset(pid_controller *pid);
+void pid_bumpless(pid_controller *pid, int32_t feedback_signal, int32_t reference_input,
+                  int16_t output);
+int16_t pid_update(pid_controller *pid, int32_t feedback_signal, int32_t reference_input);
+
+// Sample period, in us, at which the default gains below were tuned
+#define PID_TUNED_PERIOD_US 50000U
+
+#if defined(VELOCITY_LOOP)
+
+// With VELOCITY_LOOP the position controllers set the reference of the velocity loops,
+// in counts/s times CONTROL_VEL_SCALE (control.h), instead of the motor power. The 
+// output clamp is then the velocity limit. They run every CONTROL_POSITION_DIVIDER
+// control cycles; with only a proportional term their gains don't depend on the rate.
+#define INT_CLAMP_1 0
+#define OUT_CLAMP_1 20000
+#define K_INT_1 0.0F
+#define K_PROP_1 640.0F
+#define K_DER_1 0.0F
+
+#define INT_CLAMP_2 0
+#define OUT_CLAMP_2 20000
+#define K_INT_2 0.0F
+#define K_PROP_2 640.0F
+#define K_DER_2 0.0F
+
+// Sample period, in us, at which the velocity loop gains below were tuned
+#define VELOCITY_TUNED_PERIOD_US 1024U
+
+// Default gains of the velocity loops, from velocity error in counts/s times 
+// CONTROL_VEL_SCALE to motor power. With CURRENT_LOOP as well their output is the
+// current reference instead, and they should be retuned for that.
+#define K_PROP_VEL_1 0.05F
+#define K_INT_VEL_1 0.001F
+#define K_PROP_VEL_2 0.05F
+#define K_INT_VEL_2 0.001F
+
+#elif defined(CURRENT_LOOP)
+
+// With CURRENT_LOOP the position controllers set the reference of the current loops,
+// in ADC counts of the current sense, instead of the motor power. The output clamp is
+// then the current limit. The current loop takes away the damping of the back EMF, so
+// these need a derivative term.
+#define INT_CLAMP_1 50
+#define OUT_CLAMP_1 CURRENT_LIMIT_1
+#define K_INT_1 0.05F
+#define K_PROP_1 5.0F
+#define K_DER_1 0.8F
+
+#define INT_CLAMP_2 50
+#define OUT_CLAMP_2 CURRENT_LIMIT_2
+#define K_INT_2 0.05F
+#define K_PROP_2 5.0F
+#define K_DER_2 0.8F
+
+#else
+
+// Default gains and limits for the motor 1 controller. The output clamps are the peak
+// power; motor_power() folds it back to what the thermal model allows.
 #define INT_CLAMP_1 100
-#define OUT_CLAMP_1 150
+#define OUT_CLAMP_1 PWR_PEAK_M1
 #define K_INT_1 0.001F
 #define K_PROP_1 1.0F
 #define K_DER_1 0.0F
 
+// Default gains and limits for the motor 2 controller
 #define INT_CLAMP_2 75
-#define OUT_CLAMP_2 350
+#define OUT_CLAMP_2 PWR_PEAK_M2
 #define K_INT_2 0.001F
 #define K_PROP_2 1.0F
 #define K_DER_2 0.0F
 
+#endif
+
+// Default feedforward gains, from the trajectory's rate in counts/s and acceleration in 
+// counts/s^2 to the motor power or, with CURRENT_LOOP, to the current reference. They
+// come from the motor model the controller gains were tuned on (about 10 counts/s per 
+// count of power, 50 ms mechanical time constant) and should be checked on the axis.
+#ifdef CURRENT_LOOP
+#define K_FF_VEL_1 0.0F
+#define K_FF_ACC_1 0.0034F
+#define K_FF_VEL_2 0.0F
+#define K_FF_ACC_2 0.0034F
+#else
+#define K_FF_VEL_1 0.1F
+#define K_FF_ACC_1 0.005F
+#define K_FF_VEL_2 0.1F
+#define K_FF_ACC_2 0.005F
+#endif
+
+#ifdef CURRENT_LOOP
+
+// Limits of the current references, in ADC counts of the current sense. They must stay
+// below MAX_CURRENT_Mx in task_safety.h.
+#define CURRENT_LIMIT_1 150
+#define CURRENT_LIMIT_2 150
+
+// Sample period, in us, at which the current loop gains below were tuned
+#define CURRENT_TUNED_PERIOD_US 1024U
+
+// Default gains of the current loops, from current error in ADC counts to motor power
+#define K_PROP_CUR_1 0.5F
+#define K_INT_CUR_1 0.2F
+#define K_PROP_CUR_2 0.5F
+#define K_INT_CUR_2 0.2F
+
+#endif
 
 #endif /* PID_H_ */
\ No newline at end of file
@@ -26,7 +26,6 @@
 #define PRIORITY_COMMS 1
 #define PRIORITY_HEARTBEAT 2
 #define PRIORITY_SENSORS 2
-#define PRIORITY_MOTORS 3
 #define PRIORITY_ORIENT 3
 #define PRIORITY_SAFETY 6
 #define PRIORITY_MASTER 5
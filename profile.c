@@ -0,0 +1,215 @@
+//*************************************************************************************
+/** \file profile.c
+ *  \brief This file contains the motion profile generator, which limits the velocity,
+ *  acceleration and jerk of position setpoints.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <stdint.h>
+#include <math.h>
+
+#include "fixed.h"
+#include "profile.h"
+
+//-------------------------------------------------------------------------------------
+/** \brief This function moves a split position by a Q16.16 step.
+ *  \details Positions are kept as whole counts plus a 16-bit fraction, so they have the
+ *  full 32-bit range of the encoder counts and the resolution of Q16.16.
+ */
+static inline void profile_advance(int32_t *position, uint16_t *fraction, q16_t step){
+	int32_t sum = (int32_t)*fraction + step;
+	*position += sum >> 16;
+	*fraction = sum;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns how far the trapezoid stage moves while braking.
+ *  \details It is v^2/(2a), computed with the stored reciprocal so the control cycle
+ *  needs no divide.
+ *  @param speed Speed in counts/cycle, Q16.16, not negative.
+ *  @return The braking distance in counts, Q16.16.
+ */
+static inline q16_t profile_braking(const motion_profile *prof, q16_t speed){
+	return q16_mul_sat(q16_mul_sat(speed, speed), prof->brake_factor);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets the limits of a motion profile and resets it to 0.
+ *  \details All divides and floating point are done here, once. The acceleration is 
+ *  raised if needed so that 1/(2a) fits Q16.16, and the speed is lowered if needed
+ *  so that the braking distance does, since braking from a longer distance can't be
+ *  planned. The jerk limit sets the window length, rounded up to a power of two so
+ *  that the achieved jerk is at most jerk_max, unless the window would have to be 
+ *  longer than PROFILE_WINDOW_MAX cycles.
+ *  @param prof The profile to set up.
+ *  @param vel_max The speed limit, in counts/s.
+ *  @param acc_max The acceleration limit, in counts/s^2.
+ *  @param jerk_max The jerk limit, in counts/s^3.
+ *  @param period_us The time between calls of profile_update(), in us.
+ */
+void profile_init(motion_profile *prof, float vel_max, float acc_max, float jerk_max,
+                  uint16_t period_us){
+	float period = period_us*1.0e-6F;
+	float acc = acc_max*period*period;
+	float vel = vel_max*period;
+
+	if(acc < 1.0F/(2.0F*32767.0F))
+	{
+		acc = 1.0F/(2.0F*32767.0F);
+	}
+	if(vel*vel/(2.0F*acc) > 32767.0F)
+	{
+		vel = sqrtf(2.0F*acc*32767.0F);
+	}
+	prof->vel_max = q16_from_float(vel);
+	prof->acc_max = q16_from_float(acc);
+	if(prof->acc_max < 1)
+	{
+		prof->acc_max = 1;
+	}
+	prof->brake_factor = q16_from_float(1.0F/(2.0F*acc));
+
+	// The window ramps the acceleration over its length. The trapezoid stage can
+	// swing from +acc_max to -acc_max at once on short moves, hence the factor of 2.
+	float window = 2.0F*acc_max/(jerk_max*period);
+	prof->window_shift = 0;
+	while((1U<<prof->window_shift) < window && (1U<<prof->window_shift) < PROFILE_WINDOW_MAX)
+	{
+		prof->window_shift++;
+	}
+
+	profile_reset(prof, 0);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function stops a motion profile at the given position.
+ *  \details Call when the axis starts following the profile, so that the profile
+ *  starts where the axis is, at rest.
+ *  @param prof The profile.
+ *  @param position The position to start from, in counts.
+ */
+void profile_reset(motion_profile *prof, int32_t position){
+	prof->position = position;
+	prof->fraction = 0;
+	prof->velocity = 0;
+	prof->output = position;
+	prof->output_fraction = 0;
+	for(uint8_t index = 0; index < PROFILE_WINDOW_MAX; index++)
+	{
+		prof->window[index] = 0;
+	}
+	prof->window_sum = 0;
+	prof->window_carry = 0;
+	prof->window_index = 0;
+	prof->idle_cycles = 0xFF;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function advances a motion profile by one control cycle.
+ *  \details The target may change at any time; the profile then brakes or turns as 
+ *  its limits allow. There are no divides, only multiplies by stored reciprocals and
+ *  shifts by the power of two window length.
+ *  @param prof The profile.
+ *  @param target The position the axis should end up at, in counts.
+ *  @return The setpoint for this cycle, in counts.
+ */
+int32_t profile_update(motion_profile *prof, int32_t target){
+	q16_t distance = q16_sub_sat(q16_from_int(target - prof->position), prof->fraction);
+	if(distance < -Q16_MAX)
+	{
+		distance = -Q16_MAX;            // So that it can be negated
+	}
+	int8_t direction = (distance < 0) ? -1 : 1;
+	q16_t remaining = (distance < 0) ? -distance : distance;
+	q16_t toward = (direction < 0) ? -prof->velocity : prof->velocity;
+	q16_t step;
+
+	if(toward <= prof->acc_max && remaining <= 2*prof->acc_max)
+	{
+		// Close enough to stop on the target within this cycle. From rest, anything
+		// farther than this is far enough to speed up toward.
+		step = distance;
+		prof->velocity = 0;
+	}
+	else
+	{
+		if(toward < 0)
+		{
+			// Moving away from the target, so brake first.
+			toward += prof->acc_max;
+		}
+		else
+		{
+			// Speed up if the axis could still stop on the target after this cycle's
+			// step at the higher speed, hold if it could at the present speed, else brake.
+			q16_t faster = toward + prof->acc_max;
+			if(faster > prof->vel_max)
+			{
+				faster = prof->vel_max;
+			}
+			if(remaining - faster >= profile_braking(prof, faster))
+			{
+				toward = faster;
+			}
+			else if(remaining - toward < profile_braking(prof, toward))
+			{
+				toward -= prof->acc_max;
+				if(toward < 0)
+				{
+					toward = 0;
+				}
+			}
+		}
+		prof->velocity = (direction < 0) ? -toward : toward;
+		step = prof->velocity;
+	}
+	profile_advance(&prof->position, &prof->fraction, step);
+
+	// Jerk limiting stage: move the output by the average step over the window.
+	uint8_t mask = (1U<<prof->window_shift) - 1;
+	prof->window_sum += step - prof->window[prof->window_index];
+	prof->window[prof->window_index] = step;
+	prof->window_index = (prof->window_index + 1) & mask;
+	if(step != 0)
+	{
+		prof->idle_cycles = 0;
+	}
+	else if(prof->idle_cycles < 0xFF)
+	{
+		prof->idle_cycles++;
+	}
+
+	// Carry the bits shifted out of the average into the next cycle, so the output
+	// moves by exactly as much as the trapezoid stage.
+	q16_t average = prof->window_sum + prof->window_carry;
+	prof->window_carry = average & mask;
+	profile_advance(&prof->output, &prof->output_fraction, average >> prof->window_shift);
+
+	return prof->output + (prof->output_fraction >> 15);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function tells whether a motion profile has come to rest.
+ *  @return Nonzero if neither stage has moved for a full window.
+ */
+uint8_t profile_done(const motion_profile *prof){
+	return prof->idle_cycles > ((1U<<prof->window_shift) - 1);
+}
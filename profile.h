@@ -0,0 +1,76 @@
+//*************************************************************************************
+/** \file profile.h
+ *  \brief This file contains #defines, types and function declarations for the motion
+ *  profile generator, which turns position setpoint jumps into smooth trajectories.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "fixed.h"
+
+// Longest jerk-limiting window, in control cycles. Must be a power of two. Each axis
+// keeps one 4-byte step per cycle of its window.
+#define PROFILE_WINDOW_MAX 32
+
+// Default limits for the motor 1 profile, in counts/s, counts/s^2 and counts/s^3
+#define PROFILE_VEL_MAX_1 2000.0F
+#define PROFILE_ACC_MAX_1 4000.0F
+#define PROFILE_JERK_MAX_1 400000.0F
+
+// Default limits for the motor 2 profile
+#define PROFILE_VEL_MAX_2 2000.0F
+#define PROFILE_ACC_MAX_2 4000.0F
+#define PROFILE_JERK_MAX_2 400000.0F
+
+/** This structure holds the limits and state of the motion profile of one axis. The
+ *  profile runs in two stages. The first is a trapezoid: it accelerates at the limit
+ *  toward the target, cruises at the speed limit, and brakes as late as it can 
+ *  while still stopping on the target. The second is a moving average of the first
+ *  stage's steps over the last 2^window_shift cycles, which ramps the acceleration
+ *  over the window and so turns the trapezoid into an S-curve with bounded jerk. 
+ *  Positions are in whole counts plus a fraction, speeds in counts per cycle.
+ */
+typedef struct
+{
+	q16_t vel_max;              ///< Speed limit, counts/cycle in Q16.16
+	q16_t acc_max;              ///< Acceleration limit, counts/cycle^2 in Q16.16
+	q16_t brake_factor;         ///< 1/(2*acc_max), so braking distance is v^2 times this
+	uint8_t window_shift;       ///< log2 of the jerk-limiting window length
+	int32_t position;           ///< Trapezoid stage position, whole counts
+	uint16_t fraction;          ///< and fraction of a count, in 1/65536ths
+	q16_t velocity;             ///< Trapezoid stage velocity, counts/cycle
+	int32_t output;             ///< Output position, whole counts
+	uint16_t output_fraction;   ///< and fraction of a count, in 1/65536ths
+	q16_t window[PROFILE_WINDOW_MAX]; ///< The last trapezoid steps, a ring buffer
+	q16_t window_sum;           ///< Sum of the steps in the window
+	q16_t window_carry;         ///< Remainder of the last average, carried forward
+	uint8_t window_index;       ///< Where the next step goes in the window
+	uint8_t idle_cycles;        ///< Number of cycles since the last nonzero step
+} motion_profile;
+
+void profile_init(motion_profile *prof, float vel_max, float acc_max, float jerk_max,
+                  uint16_t period_us);
+void profile_reset(motion_profile *prof, int32_t position);
+int32_t profile_update(motion_profile *prof, int32_t target);
+uint8_t profile_done(const motion_profile *prof);
+
+#endif
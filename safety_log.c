@@ -0,0 +1,190 @@
+//*************************************************************************************
+/** \file safety_log.c
+ *  \brief This file contains the safety event log. Every event is counted against its
+ *  cause, with the time of the first and the latest; events which get past the token
+ *  bucket of their cause are also put in a ring of fixed size records, which can be 
+ *  read out at any time. Posting an event costs the same whatever is in the log, and 
+ *  may be done from an ISR.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "safety_log.h"
+
+#if SAFETY_LOG_RECORDS > 128 || (SAFETY_LOG_RECORDS & (SAFETY_LOG_RECORDS - 1)) != 0
+	#error SAFETY_LOG_RECORDS must be a power of 2 up to 128
+#endif
+
+/// Counts of each cause, its tokens and the events it had since its last record.
+static safety_log_cause slg_causes[SAFETY_LOG_CAUSES];
+static uint8_t slg_tokens[SAFETY_LOG_CAUSES];
+static uint8_t slg_suppressed[SAFETY_LOG_CAUSES];
+
+/// The ring of records, and the number of records ever written, which wraps.
+static safety_log_record slg_records[SAFETY_LOG_RECORDS];
+static uint8_t slg_written;
+
+/// Calls of safety_log_tick() since the buckets were last refilled.
+static uint8_t slg_ticks;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function empties the log and fills the token buckets.
+ *  \details Call once from main(), before interrupts are enabled.
+ */
+void safety_log_init(void){
+	for(uint8_t cause = 0; cause < SAFETY_LOG_CAUSES; cause++)
+	{
+		slg_causes[cause].count = 0;
+		slg_causes[cause].suppressed = 0;
+		slg_causes[cause].first = 0;
+		slg_causes[cause].last = 0;
+		slg_tokens[cause] = SAFETY_LOG_BURST;
+		slg_suppressed[cause] = 0;
+	}
+	slg_written = 0;
+	slg_ticks = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function logs one safety event, from an ISR or with interrupts off.
+ *  @param cause One of the SAFETY_CAUSE_ codes; others are ignored.
+ *  @param time When the event happened, from xTaskGetTickCountFromISR().
+ */
+void safety_log_post_from_ISR(uint8_t cause, uint32_t time){
+	if(cause >= SAFETY_LOG_CAUSES)
+	{
+		return;
+	}
+	safety_log_cause *counts = &slg_causes[cause];
+	if(counts->count == 0)
+	{
+		counts->first = time;
+	}
+	if(counts->count < 0xFFFF)
+	{
+		counts->count++;
+	}
+	counts->last = time;
+
+	if(slg_tokens[cause] == 0)
+	{
+		if(counts->suppressed < 0xFFFF) counts->suppressed++;
+		if(slg_suppressed[cause] < 0xFF) slg_suppressed[cause]++;
+		return;
+	}
+	slg_tokens[cause]--;
+
+	safety_log_record *record = &slg_records[slg_written & (SAFETY_LOG_RECORDS - 1)];
+	record->time = time;
+	record->count = counts->count;
+	record->cause = cause;
+	record->suppressed = slg_suppressed[cause];
+	slg_suppressed[cause] = 0;
+	slg_written++;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function logs one safety event, from a task.
+ *  @param cause One of the SAFETY_CAUSE_ codes; others are ignored.
+ */
+void safety_log_post(uint8_t cause){
+	taskENTER_CRITICAL();
+		safety_log_post_from_ISR(cause, xTaskGetTickCountFromISR());
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function logs an event for each fault bit, from an ISR or with 
+ *  interrupts off.
+ *  @param faults The TRIP_ bits of trip.h which were latched.
+ *  @param time When they were, from xTaskGetTickCountFromISR().
+ */
+void safety_log_post_faults_from_ISR(uint16_t faults, uint32_t time){
+	for(uint8_t cause = 0; faults; cause++, faults >>= 1)
+	{
+		if(faults & 1)
+		{
+			safety_log_post_from_ISR(cause, time);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function refills the token buckets. Call it every 100 ms.
+ */
+void safety_log_tick(void){
+	if(++slg_ticks < SAFETY_LOG_REFILL_TICKS)
+	{
+		return;
+	}
+	slg_ticks = 0;
+	taskENTER_CRITICAL();
+		for(uint8_t cause = 0; cause < SAFETY_LOG_CAUSES; cause++)
+		{
+			if(slg_tokens[cause] < SAFETY_LOG_BURST)
+			{
+				slg_tokens[cause]++;
+			}
+		}
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the records a reader hasn't seen yet, oldest first.
+ *  \details Each reader keeps its own sequence number, starting from 0, so several 
+ *  can read the log without taking records from each other. A reader which falls 
+ *  more than SAFETY_LOG_RECORDS behind misses the ones overwritten.
+ *  @param records Where to copy the records.
+ *  @param max How many records fit there.
+ *  @param sequence The reader's sequence number, which is moved past the records 
+ *  copied.
+ *  @return The number of records copied.
+ */
+uint8_t safety_log_read(safety_log_record *records, uint8_t max, uint8_t *sequence){
+	uint8_t copied = 0;
+	taskENTER_CRITICAL();
+		uint8_t waiting = slg_written - *sequence;
+		if(waiting > SAFETY_LOG_RECORDS)
+		{
+			*sequence = slg_written - SAFETY_LOG_RECORDS;
+			waiting = SAFETY_LOG_RECORDS;
+		}
+		while(copied < waiting && copied < max)
+		{
+			records[copied++] = slg_records[(*sequence)++ & (SAFETY_LOG_RECORDS - 1)];
+		}
+	taskEXIT_CRITICAL();
+	return copied;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the counts of one cause.
+ *  @param cause One of the SAFETY_CAUSE_ codes.
+ *  @param counts The structure into which the counts are copied.
+ */
+void safety_log_get_cause(uint8_t cause, safety_log_cause *counts){
+	taskENTER_CRITICAL();
+		*counts = slg_causes[cause];
+	taskEXIT_CRITICAL();
+}
@@ -0,0 +1,86 @@
+//*************************************************************************************
+/** \file safety_log.h
+ *  \brief This file contains #defines, types and function declarations for the safety
+ *  event log, which counts every safety event by cause and keeps a short record of 
+ *  them, rate limited so a fault which repeats can't flood the serial port.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _SAFETY_LOG_H_
+#define _SAFETY_LOG_H_
+
+// Causes of safety events. The first nine are the TRIP_ bits of trip.h in order, so
+// the cause of fault bit n is n.
+#define SAFETY_CAUSE_OVERCURRENT_M1 0   ///< Motor 1 current over its limit
+#define SAFETY_CAUSE_OVERCURRENT_M2 1   ///< Motor 2 current over its limit
+#define SAFETY_CAUSE_DRIVER_M1 2        ///< Motor 1 driver fault
+#define SAFETY_CAUSE_DRIVER_M2 3        ///< Motor 2 driver fault
+#define SAFETY_CAUSE_STALL 4            ///< An axis stalled
+#define SAFETY_CAUSE_RUNAWAY 5          ///< An axis ran away
+#define SAFETY_CAUSE_ENCODER_LOSS 6     ///< An axis lost its encoder
+#define SAFETY_CAUSE_LIMIT 7            ///< A limit switch closed
+#define SAFETY_CAUSE_ESTOP 8            ///< The emergency stop was pressed
+#define SAFETY_CAUSE_STOW 9             ///< A wind stow was requested
+#define SAFETY_LOG_CAUSES 10
+
+// Number of records the log keeps, a power of 2 up to 128. Older ones are overwritten.
+#define SAFETY_LOG_RECORDS 16
+
+// Each cause has a bucket of tokens, one spent for each event which gets a record.
+// A full bucket holds SAFETY_LOG_BURST tokens, and one is added every 
+// SAFETY_LOG_REFILL_TICKS calls of safety_log_tick(), which the safety task makes 
+// every 100 ms. Events which find the bucket empty are only counted.
+#define SAFETY_LOG_BURST 3
+#define SAFETY_LOG_REFILL_TICKS 50
+
+// Events are stamped with the RTOS tick count, xTaskGetTickCount(), which counts 
+// milliseconds in 32 bits and so wraps only after 49.7 days.
+
+/** This structure is one record of the log, 8 bytes in the byte order of the AVR, 
+ *  little endian. It can be sent as it is.
+ */
+typedef struct
+{
+	uint32_t time;              ///< When the event happened, in RTOS ticks
+	uint16_t count;             ///< Events of this cause so far, this one included
+	uint8_t cause;              ///< One of the SAFETY_CAUSE_ codes
+	uint8_t suppressed;         ///< Events of this cause without a record since the
+	                            ///< last one which got one, up to 255
+} safety_log_record;
+
+/** This structure holds the counts of one cause. Times are in RTOS ticks.
+ */
+typedef struct
+{
+	uint16_t count;             ///< Events of this cause, up to 65535
+	uint16_t suppressed;        ///< Of these, how many got no record, up to 65535
+	uint32_t first;             ///< When the first one happened
+	uint32_t last;              ///< When the latest one happened
+} safety_log_cause;
+
+void safety_log_init(void);
+void safety_log_post(uint8_t cause);
+void safety_log_post_from_ISR(uint8_t cause, uint32_t time);
+void safety_log_post_faults_from_ISR(uint16_t faults, uint32_t time);
+void safety_log_tick(void);
+uint8_t safety_log_read(safety_log_record *records, uint8_t max, uint8_t *sequence);
+void safety_log_get_cause(uint8_t cause, safety_log_cause *counts);
+
+#endif
@@ -25,20 +25,16 @@
 #define _SHARES_H_
 
 extern xQueueHandle comms_queue; //Defined in task_comms.c
+extern xQueueHandle master_queue; //Defined in task_master.c
 extern xSemaphoreHandle adc_binary_semaphore;
-extern xSemaphoreHandle adc_mutex_semaphore;
 
 extern int16_t motor1_power_SHARED; //Defined, used in task_motors.c
 extern int16_t motor2_power_SHARED; //Defined, used in task_motors.c
 
-extern int16_t position_cmd_M1_SHARED; //Defined, used in task_motors.c
-extern int16_t position_cmd_M2_SHARED; //Defined, used in task_motors.c
-
-extern volatile int16_t position_M1_SHARED; //Defined, used in task_motors.c
-extern volatile int16_t position_M2_SHARED; //Defined, used in task_motors.c
-
-extern volatile uint16_t error_M1_SHARED; //Defined, used in task_motors.c
-extern volatile uint16_t error_M2_SHARED; //Defined, used in task_motors.c
+extern int32_t position_cmd_SHARED[]; //Defined in task_motors.c, one per motor axis
+extern int32_t rate_cmd_SHARED[];     //Defined in task_motors.c, counts/s in Q16.16
+extern int32_t accel_cmd_SHARED[];    //Defined in task_motors.c, counts/s^2 in Q16.16
+extern uint8_t setpoint_sequence_SHARED; //Defined in task_motors.c, bumped on each write
 
 extern uint8_t  x_h_SHARED; // Defined in task_sensors.c,
 extern uint8_t	x_l_SHARED; // protect by maxing priority before
@@ -53,8 +49,8 @@ extern uint8_t	btn_SHARED; // Defined in task_sensors.c
 
 extern uint8_t state_SHARED; // Defined in task_master.c
 
-extern int16_t position_targ_init_SHARED; // Defined in task_motors.c
+extern int32_t position_targ_init_SHARED[]; // Defined in task_motors.c, one per motor axis
 
-extern uint8_t safety_error_SHARED; // Defined in task_safety
+extern uint16_t safety_error_SHARED; // Defined in trip.c
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,153 @@
+//*************************************************************************************
+/** \file supervisor.c
+ *  \brief This file contains the axis supervisor. Each control cycle it sums the 
+ *  controller output, the motor current and the encoder's error count of an axis, 
+ *  and at the end of each window compares them with how far the axis moved. A jammed
+ *  axis, one whose motor sign is wrong or whose encoder has come off is found within
+ *  a fraction of a second, while the position controller would otherwise wind up and
+ *  heat the motor without the current ever reaching the trip.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <stdint.h>
+
+#include "supervisor.h"
+
+#if SUPERVISOR_WINDOW > 255 || (SUPERVISOR_WINDOW & (SUPERVISOR_WINDOW - 1)) != 0
+	#error SUPERVISOR_WINDOW must be a power of 2 below 256
+#endif
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up the supervisor of one axis, with no fault found.
+ *  @param power_limit The rated power of the axis, in motor power counts.
+ */
+void supervisor_init(axis_supervisor *sv, int16_t power_limit){
+	sv->drive_min = ((uint32_t)power_limit*SUPERVISOR_DRIVE_PERCENT/100)*SUPERVISOR_WINDOW;
+	sv->cause = SUPERVISOR_OK;
+	supervisor_reset(sv);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function starts the supervisor over, from the next update.
+ *  \details The window under way and the counts of windows showing a fault are 
+ *  dropped; a fault already found is kept. Call it whenever the axis starts or stops
+ *  being controlled, since what it did before says nothing about what it does now.
+ */
+void supervisor_reset(axis_supervisor *sv){
+	sv->count = 0;
+	sv->stall_windows = 0;
+	sv->runaway_windows = 0;
+	sv->encoder_windows = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function counts the windows in a row which show a fault.
+ *  @return Nonzero once SUPERVISOR_WINDOWS windows in a row have shown it.
+ */
+static uint8_t supervisor_count(uint8_t *windows, uint8_t shown){
+	if(!shown)
+	{
+		*windows = 0;
+		return 0;
+	}
+	if(*windows < SUPERVISOR_WINDOWS)
+	{
+		(*windows)++;
+	}
+	return *windows >= SUPERVISOR_WINDOWS;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the supervisor of one axis for one control cycle.
+ *  \details Within a window it only adds up, so most updates cost a few additions; 
+ *  the window is judged on the last one:
+ *  \li Stall: driven hard, moved less than SUPERVISOR_MOTION_COUNTS and drawing the
+ *      current of a locked rotor.
+ *  \li Runaway: driven hard one way and moving the other.
+ *  \li Encoder loss: driven hard, not moving and drawing the current of a motor 
+ *      which turns; or at least SUPERVISOR_ENCODER_ERRORS illegal transitions.
+ *  @param output The controller output, in motor power counts.
+ *  @param current The motor current, in ADC counts.
+ *  @param position The measured position, in counts.
+ *  @param encoder_errors The encoder's count of illegal transitions.
+ *  @return The fault found, one of the SUPERVISOR_ codes. Once one is found it is 
+ *  returned from then on, until supervisor_init() is called.
+ */
+uint8_t supervisor_update(axis_supervisor *sv, int16_t output, uint16_t current,
+                          int32_t position, uint16_t encoder_errors){
+	if(sv->cause != SUPERVISOR_OK)
+	{
+		return sv->cause;
+	}
+	if(sv->count == 0)
+	{
+		sv->output_sum = 0;
+		sv->output_abs_sum = 0;
+		sv->current_sum = 0;
+		sv->start_position = position;
+		sv->start_errors = encoder_errors;
+	}
+	sv->output_sum += output;
+	sv->output_abs_sum += (output < 0) ? -output : output;
+	sv->current_sum += current;
+	if(++sv->count < SUPERVISOR_WINDOW)
+	{
+		return SUPERVISOR_OK;
+	}
+	sv->count = 0;
+
+	int32_t moved = position - sv->start_position;
+	uint8_t forward = (moved >= SUPERVISOR_MOTION_COUNTS);
+	uint8_t reverse = (moved <= -SUPERVISOR_MOTION_COUNTS);
+	uint8_t moving = forward || reverse;
+	uint8_t driven = (sv->output_abs_sum >= sv->drive_min);
+	uint8_t locked = (sv->current_sum*256 >= SUPERVISOR_STALL_Q8*sv->output_abs_sum);
+	uint8_t miscounting = ((uint16_t)(encoder_errors - sv->start_errors) 
+	                       >= SUPERVISOR_ENCODER_ERRORS);
+
+	// A runaway is driven hard the same way all window, so the sum is as large as the 
+	// sum of magnitudes needs to be.
+	int32_t drive_min = sv->drive_min;
+	uint8_t reversed = (sv->output_sum >= drive_min && reverse)
+	                   || (sv->output_sum <= -drive_min && forward);
+
+	if(supervisor_count(&sv->stall_windows, driven && !moving && locked))
+	{
+		sv->cause = SUPERVISOR_STALL;
+	}
+	if(supervisor_count(&sv->runaway_windows, reversed))
+	{
+		sv->cause = SUPERVISOR_RUNAWAY;
+	}
+	if(supervisor_count(&sv->encoder_windows, (driven && !moving && !locked) || miscounting))
+	{
+		sv->cause = SUPERVISOR_ENCODER_LOSS;
+	}
+	return sv->cause;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the fault the supervisor of an axis has found.
+ *  @return One of the SUPERVISOR_ codes.
+ */
+uint8_t supervisor_cause(const axis_supervisor *sv){
+	return sv->cause;
+}
@@ -0,0 +1,85 @@
+//*************************************************************************************
+/** \file supervisor.h
+ *  \brief This file contains #defines, types and function declarations for the axis
+ *  supervisor, which catches an axis that is stalled, runs away or has lost its 
+ *  encoder before the current or the driver trips.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _SUPERVISOR_H_
+#define _SUPERVISOR_H_
+
+// The supervisor sums its inputs over windows of SUPERVISOR_WINDOW updates, a power of
+// 2, and judges each window as a whole. A fault is found once SUPERVISOR_WINDOWS 
+// windows in a row show it: 4 windows of 64 control cycles is 262 ms.
+#define SUPERVISOR_WINDOW 64
+#define SUPERVISOR_WINDOWS 4
+
+// An axis is driven hard in a window if the mean magnitude of its controller output
+// is at least this share of its rated power, in percent. Stall, runaway and encoder
+// loss are only looked for while it is.
+#define SUPERVISOR_DRIVE_PERCENT 50
+
+// An axis which moves less than this many counts in a window isn't moving.
+#define SUPERVISOR_MOTION_COUNTS 4
+
+// A motor which is driven hard but doesn't turn draws its locked rotor current, which
+// is much more than it draws when it turns freely. A window without motion is a stall
+// if the mean current is at least SUPERVISOR_STALL_Q8/256 ADC counts per count of 
+// power, else the motor is taken to be turning with the encoder lost. Set it to about
+// half the locked rotor current per count of power.
+#define SUPERVISOR_STALL_Q8 16
+
+// A window with this many illegal encoder transitions or more, see encoder_get_errors(),
+// is one with the encoder failing, whether the axis is driven or not.
+#define SUPERVISOR_ENCODER_ERRORS 4
+
+// Causes of a fault
+#define SUPERVISOR_OK 0                 ///< No fault
+#define SUPERVISOR_STALL 1              ///< Driven hard, drawing current, not moving
+#define SUPERVISOR_RUNAWAY 2            ///< Moving the opposite way to the drive
+#define SUPERVISOR_ENCODER_LOSS 3       ///< Driven hard without counts, or miscounting
+
+/** This structure holds the state of the supervisor of one axis. The controller 
+ *  output is in the sign convention of the controllers, so with the right motor sign
+ *  the axis moves the way it is driven.
+ */
+typedef struct
+{
+	uint32_t drive_min;         ///< Sum of |output| over a window to be driven hard
+	int32_t output_sum;         ///< Sum of the controller output in this window
+	uint32_t output_abs_sum;    ///< Sum of its magnitude
+	uint32_t current_sum;       ///< Sum of the motor current, in ADC counts
+	int32_t start_position;     ///< Position at the start of this window
+	uint16_t start_errors;      ///< Encoder error count at the start of this window
+	uint8_t count;              ///< Updates in this window, 0 to start a new one
+	uint8_t stall_windows;      ///< Windows in a row showing each fault
+	uint8_t runaway_windows;
+	uint8_t encoder_windows;
+	uint8_t cause;              ///< The fault found, one of the SUPERVISOR_ codes
+} axis_supervisor;
+
+void supervisor_init(axis_supervisor *sv, int16_t power_limit);
+void supervisor_reset(axis_supervisor *sv);
+uint8_t supervisor_update(axis_supervisor *sv, int16_t output, uint16_t current,
+                          int32_t position, uint16_t encoder_errors);
+uint8_t supervisor_cause(const axis_supervisor *sv);
+
+#endif
@@ -2,7 +2,7 @@
 /** \file task_master.c
  *  \brief This file contains function declarations for the master task. This task
  *  is an implementation of a state machine, which governs the state of the system
- *  based on the values of certain shared variables.
+ *  based on events posted by the button debouncer and the safety task.
  * 
  *  Revisions:
  *    \li 11-27-2014 JF, ML, JR created original file
@@ -25,6 +25,7 @@
 
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include "FreeRTOS.h"                       // Primary header for FreeRTOS
 #include "task.h"                           // Header for FreeRTOS task functions
 #include "queue.h"                          // FreeRTOS inter-task communication queues
@@ -33,15 +34,276 @@
 
 #include "uart.h"
 #include "shares.h"
+#include "timestamp.h"
+#include "fsm.h"
+#include "debounce.h"
+#include "trip.h"
 #include "task_master.h"
 
 uint8_t state_SHARED;
 
+xQueueHandle master_queue; // Created in main(), events for the master task
+
+/// Transition latency statistics, see master_get_latency().
+static master_latency mst_latency;
+
+/// Cause of the safety fault which led to ERROR, see master_get_fault_cause().
+static uint16_t mst_fault_cause;
+
+/// TRIP_ bits which were latched when ERROR was last reset, see master_reset().
+static uint16_t mst_reset_faults;
+
+/// TRIP_ bits of safety faults which found the queue full, and the time stamp of the
+/// first of them. The master dispatches them once it has taken the events which were
+/// in the queue; it can't block while they wait, so a fault is never lost.
+static volatile uint16_t mst_fault_pending;
+static volatile uint32_t mst_fault_pending_time;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function posts an event to the master task, from a task.
+ *  \details The event is stamped with the current time. It never blocks; if the queue
+ *  is full the event is dropped, which can only happen if the master is starved.
+ *  @param event One of the MASTER_EVENT_ codes from task_master.h.
+ */
+void master_post(uint8_t event){
+	master_event item;
+	item.type = event;
+	item.cause = 0;
+	item.time = timestamp_now();
+	xQueueSend(master_queue, &item, 0);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function posts an event to the master task, from an ISR.
+ *  @param event One of the MASTER_EVENT_ codes from task_master.h.
+ *  @return pdTRUE if the master has a higher priority than the interrupted task, in
+ *  which case the ISR should call taskYIELD() before it returns.
+ */
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){
+	return master_post_stamped_from_ISR(event, timestamp_now_in_ISR());
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function posts an event which was detected earlier, from an ISR.
+ *  \details The latency statistics then count from when the event happened, not from
+ *  when it was posted.
+ *  @param event One of the MASTER_EVENT_ codes from task_master.h.
+ *  @param time When the event happened, from timestamp_now_in_ISR().
+ *  @return pdTRUE if the master has a higher priority than the interrupted task, in
+ *  which case the ISR should call taskYIELD() before it returns.
+ */
+signed portBASE_TYPE master_post_stamped_from_ISR(uint8_t event, uint32_t time){
+	signed portBASE_TYPE woken = pdFALSE;
+	master_event item;
+	item.type = event;
+	item.cause = 0;
+	item.time = time;
+	xQueueSendFromISR(master_queue, &item, &woken);
+	return woken;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function keeps a safety fault which found the queue full, for the 
+ *  master to dispatch once it has emptied the queue. Call it with interrupts off.
+ *  @param item The fault event which could not be posted.
+ */
+static void master_pend_fault(const master_event *item){
+	if(!mst_fault_pending)
+	{
+		mst_fault_pending_time = item->time;
+	}
+	mst_fault_pending |= item->cause;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function takes the safety faults which found the queue full.
+ *  @param item Where the fault event is put, if there is one.
+ *  @return Nonzero if there was a fault waiting.
+ */
+static uint8_t master_take_pending_fault(master_event *item){
+	taskENTER_CRITICAL();
+		item->type = MASTER_EVENT_SAFETY_FAULT;
+		item->cause = mst_fault_pending;
+		item->time = mst_fault_pending_time;
+		mst_fault_pending = 0;
+	taskEXIT_CRITICAL();
+	return item->cause != 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function posts a safety fault to the master task, from a task.
+ *  \details If the queue is full the fault is kept and dispatched by the master once
+ *  it has taken the events before it, see mst_fault_pending.
+ *  @param cause The TRIP_ bits of trip.h which were latched.
+ */
+void master_post_fault(uint16_t cause){
+	master_event item;
+	item.type = MASTER_EVENT_SAFETY_FAULT;
+	item.cause = cause;
+	item.time = timestamp_now();
+	taskENTER_CRITICAL();
+		if(xQueueSend(master_queue, &item, 0) != pdPASS)
+		{
+			master_pend_fault(&item);
+		}
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function posts a safety fault to the master task, from an ISR.
+ *  \details If the queue is full the fault is kept like that of master_post_fault().
+ *  @param cause The TRIP_ bits of trip.h which were latched.
+ *  @return pdTRUE if the master has a higher priority than the interrupted task, in
+ *  which case the ISR should call taskYIELD() before it returns.
+ */
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){
+	signed portBASE_TYPE woken = pdFALSE;
+	master_event item;
+	item.type = MASTER_EVENT_SAFETY_FAULT;
+	item.cause = cause;
+	item.time = timestamp_now_in_ISR();
+	if(xQueueSendFromISR(master_queue, &item, &woken) != pdPASS)
+	{
+		master_pend_fault(&item);
+	}
+	return woken;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the cause of the safety fault which led to ERROR.
+ *  @return The TRIP_ bits of trip.h posted with the fault, 0 if there was none.
+ */
+uint16_t master_get_fault_cause(void){
+	uint16_t cause;
+	taskENTER_CRITICAL();
+		cause = mst_fault_cause;
+	taskEXIT_CRITICAL();
+	return cause;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the master's transition latency statistics.
+ *  @param latency The structure into which the statistics are copied.
+ */
+void master_get_latency(master_latency *latency){
+	taskENTER_CRITICAL();
+		*latency = mst_latency;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the guard of the transitions which start the axes moving.
+ *  \details Stow requests are passed on as edges, so one which was already on when 
+ *  the system came to await a target, or which came during calibration, is caught 
+ *  here instead.
+ *  @param context Not used.
+ *  @return Nonzero unless a wind stow is requested.
+ */
+static uint8_t master_no_stow(void *context){
+	return !debounce_active(DEBOUNCE_STOW);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the guard of the reset from ERROR.
+ *  \details A fault whose cause is still there would only trip again, so the reset
+ *  waits until the emergency stop and the limit switches are open and no driver 
+ *  reports a fault. An overcurrent can't be checked for with the motors off; it trips
+ *  again once they are driven, if it persists.
+ *  @param context Not used.
+ *  @return Nonzero if the faults can be reset.
+ */
+static uint8_t master_can_reset(void *context){
+	return !debounce_active(DEBOUNCE_ESTOP) && !debounce_active(DEBOUNCE_LIMIT_1)
+	       && !debounce_active(DEBOUNCE_LIMIT_2) && !trip_driver_faults();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the action of the reset from ERROR. It clears the latched
+ *  faults, which lets the motors be driven again, and keeps them for 
+ *  master_lost_position().
+ *  @param context Not used.
+ */
+static void master_reset(void *context){
+	mst_reset_faults = trip_reset();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the guard of the transition from IDLE to calibration.
+ *  @param context Not used.
+ *  @return Nonzero if the fault which was reset was the loss of an encoder, after
+ *  which the zero reference can't be trusted.
+ */
+static uint8_t master_lost_position(void *context){
+	return (mst_reset_faults & TRIP_ENCODER_LOSS) != 0;
+}
+
+/** The master's transitions. A safety fault leads to ERROR from any state, and ERROR
+ *  is kept until the button is pressed with the cause of the fault gone, which 
+ *  resets it to IDLE. From IDLE the next press selects the target again, or 
+ *  calibrates again if an encoder was lost. Otherwise the button steps through calibration and target selection,
+ *  and once tracking, pressing it again goes back to target selection. Autotuning is
+ *  started while awaiting a target, and ends by itself or at a press of the button.
+ *  A wind stow request stops the axes once they are calibrated; when it ends the
+ *  system awaits a target again. Neither starts while a stow is requested.
+ */
+static const fsm_transition mst_transitions[] PROGMEM =
+{
+//    state           event                        next           guard  action
+	{ FSM_ANY_STATE,  MASTER_EVENT_SAFETY_FAULT,   ERROR,         NULL,  NULL },
+	{ AWAITING_CAL,   MASTER_EVENT_BUTTON_PRESS,   CALIBRATION,   NULL,  NULL },
+	{ CALIBRATION,    MASTER_EVENT_BUTTON_RELEASE, AWAITING_TARG, NULL,  NULL },
+	{ AWAITING_TARG,  MASTER_EVENT_BUTTON_PRESS,   SELECT_TARG,   master_no_stow, NULL },
+	{ SELECT_TARG,    MASTER_EVENT_BUTTON_RELEASE, TRACK_TARG,    NULL,  NULL },
+	{ TRACK_TARG,     MASTER_EVENT_BUTTON_PRESS,   SELECT_TARG,   NULL,  NULL },
+	{ AWAITING_TARG,  MASTER_EVENT_AUTOTUNE,       AUTOTUNE,      master_no_stow, NULL },
+	{ AUTOTUNE,       MASTER_EVENT_AUTOTUNE_DONE,  AWAITING_TARG, NULL,  NULL },
+	{ AUTOTUNE,       MASTER_EVENT_BUTTON_PRESS,   AWAITING_TARG, NULL,  NULL },
+	{ AWAITING_TARG,  MASTER_EVENT_STOW,           STOW,          NULL,  NULL },
+	{ SELECT_TARG,    MASTER_EVENT_STOW,           STOW,          NULL,  NULL },
+	{ TRACK_TARG,     MASTER_EVENT_STOW,           STOW,          NULL,  NULL },
+	{ AUTOTUNE,       MASTER_EVENT_STOW,           STOW,          NULL,  NULL },
+	{ IDLE,           MASTER_EVENT_STOW,           STOW,          NULL,  NULL },
+	{ STOW,           MASTER_EVENT_STOW_END,       AWAITING_TARG, NULL,  NULL },
+	{ ERROR,          MASTER_EVENT_BUTTON_PRESS,   IDLE,          master_can_reset,
+	                                                              master_reset },
+	{ IDLE,           MASTER_EVENT_BUTTON_PRESS,   CALIBRATION,   master_lost_position,
+	                                                              NULL },
+	{ IDLE,           MASTER_EVENT_BUTTON_PRESS,   SELECT_TARG,   master_no_stow, NULL }
+};
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one event through the master's state machine, and 
+ *  publishes the state and the latency of the transition if it made one.
+ *  @param fsm The master's state machine.
+ *  @param event The event.
+ */
+static void master_dispatch(fsm_machine *fsm, const master_event *event){
+	if(!fsm_dispatch(fsm, event->type))
+	{
+		return;
+	}
+	taskENTER_CRITICAL();
+		state_SHARED = fsm->state;
+		if(event->type == MASTER_EVENT_SAFETY_FAULT)
+		{
+			mst_fault_cause = event->cause;
+		}
+		uint32_t latency = timestamp_now_in_ISR() - event->time;
+		mst_latency.transitions++;
+		mst_latency.latency_last = latency;
+		if(latency > mst_latency.latency_max)
+		{
+			mst_latency.latency_max = latency;
+		}
+	taskEXIT_CRITICAL();
+}
+
  //-------------------------------------------------------------------------------------
 /** \brief This is the task function for the master task.
  *  \details This function decides which state the system is in, based on the previous
- *  state, and the current values of certain shared variables. The seven possible
- *  system states are as follows:
+ *  state and the events posted to master_queue, using the transitions in 
+ *  mst_transitions. It blocks on the queue, so a state change follows an event 
+ *  within one scheduling latency. The nine possible system states are as follows:
  * 
  *      AWAITING_CAL - Awaiting Calibration - The system is waiting for the user to 
  *      press the target set button, to initialize the zero reference position.
@@ -66,68 +328,51 @@ uint8_t state_SHARED;
  *      Motor power: PI controller
  * 
  *      ERROR - The safety task has decided that an error has occurred, and the motors
- *      are powered down in response.
+ *      are powered down in response. master_get_fault_cause() tells what it was.
+ *      A press of the button resets the faults and leads to IDLE, once the emergency
+ *      stop and limit switches are open and the drivers report no fault.
  *      Motor power: 0
  * 
- *      IDLE - state which allows the user to reset the system from the ERROR state to
- *      the SELECT_TARG state.
+ *      IDLE - The faults were reset. The next press of the button leads to 
+ *      SELECT_TARG, or to CALIBRATION if an encoder was lost, since the zero 
+ *      reference is then gone.
+ *      Motor power: 0
+ * 
+ *      AUTOTUNE - The control executive calibrates the friction compensation of each
+ *      axis in turn and runs a relay experiment on it, and sets the gains of its
+ *      position controller from the result. Entered from
+ *      AWAITING_TARG; a press of the button aborts it.
+ *      Motor power: Relay, on one axis at a time
+ * 
+ *      STOW - A wind stow was requested. There is no stow position to drive to yet,
+ *      so the axes are left unpowered until the request ends, after which the
+ *      target has to be selected again. Unlike ERROR it needs no reset.
  *      Motor power: 0
  */
 void task_master(void* pvParameters){
-    state_SHARED = AWAITING_CAL;
-    uint8_t btn = 0;
-	uint8_t error = 0;
-    while(!btn)
-    {
-        vTaskDelay(configMS_TO_TICKS (200));
-        taskENTER_CRITICAL();
-            state_SHARED = AWAITING_CAL;
-            btn = btn_SHARED;
-        taskEXIT_CRITICAL();
-    }
-    while(btn)
-    {
-        vTaskDelay(configMS_TO_TICKS (200));
-        taskENTER_CRITICAL();
-	        state_SHARED = CALIBRATION;
-	        btn = btn_SHARED;
-        taskEXIT_CRITICAL();
-    }
-    while(!btn)
-    {
-       vTaskDelay(configMS_TO_TICKS (200));
-       taskENTER_CRITICAL();
-          state_SHARED = AWAITING_TARG;
-          btn = btn_SHARED;
-       taskEXIT_CRITICAL();
-    }
-    portTickType xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount();
+	master_event event;
+	fsm_machine fsm;
+	fsm_init(&fsm, mst_transitions, sizeof(mst_transitions)/sizeof(mst_transitions[0]),
+	         AWAITING_CAL, FSM_MACHINE_MASTER, NULL);
+
+	taskENTER_CRITICAL();
+		state_SHARED = fsm.state;
+		mst_latency.transitions = 0;
+		mst_latency.latency_last = 0;
+		mst_latency.latency_max = 0;
+		mst_fault_cause = 0;
+	taskEXIT_CRITICAL();
+
     while(1)
     {
-        taskENTER_CRITICAL();
-            btn = btn_SHARED;
-		    error = safety_error_SHARED;
-        taskEXIT_CRITICAL(); 
-	    if(!error){
-		   
-			if(btn)
-			{
-			taskENTER_CRITICAL();
-					state_SHARED = SELECT_TARG;
-			taskEXIT_CRITICAL();
-			}
-			else
-			{
-			taskENTER_CRITICAL();
-					state_SHARED = TRACK_TARG;
-				taskEXIT_CRITICAL();
-			}
-		}
-		else
+		xQueueReceive(master_queue, &event, portMAX_DELAY);
+		master_dispatch(&fsm, &event);
+
+		// A fault which found the queue full comes after the events which filled it,
+		// so it is taken once they all have been.
+		if(!uxQueueMessagesWaiting(master_queue) && master_take_pending_fault(&event))
 		{
-			state_SHARED = ERROR;
-		}	
-       vTaskDelayUntil(&xLastWakeTime, 200/portTICK_RATE_MS);
+			master_dispatch(&fsm, &event);
+		}
     }
 }
@@ -31,9 +31,54 @@
 #define TRACK_TARG 4
 #define IDLE 5
 #define ERROR 6
+#define AUTOTUNE 7
+#define STOW 8
 
 #define STACK_SIZE_MASTER 280
 
+// Number of events the master's queue holds. Events are posted on edges only, so
+// more than a few can only back up if the master is starved. Other events which find
+// it full are dropped; a safety fault is kept until the master has room, see
+// task_master.c.
+#define SIZE_MASTER_QUEUE 8
+
+// EVENTS WHICH DRIVE THE MASTER STATE MACHINE
+#define MASTER_EVENT_BUTTON_PRESS 0
+#define MASTER_EVENT_BUTTON_RELEASE 1
+#define MASTER_EVENT_SAFETY_FAULT 2
+#define MASTER_EVENT_AUTOTUNE 3
+#define MASTER_EVENT_AUTOTUNE_DONE 4
+#define MASTER_EVENT_STOW 5
+#define MASTER_EVENT_STOW_END 6
+
+/** This structure is one item in the master's event queue. The time stamp is taken
+ *  when the event is detected, so the master can measure how long it took to act.
+ */
+typedef struct
+{
+	uint8_t type;               ///< One of the MASTER_EVENT_ codes
+	uint16_t cause;             ///< For a safety fault, the TRIP_ bits of trip.h
+	uint32_t time;              ///< When it happened, from timestamp_now()
+} master_event;
+
+/** This structure holds the latency of the master's state transitions, measured 
+ *  from the time stamp of an event to the update of state_SHARED that it caused. 
+ *  Times are in time stamp counts, TIMESTAMP_HZ per second.
+ */
+typedef struct
+{
+	uint16_t transitions;       ///< Number of transitions measured
+	uint32_t latency_last;      ///< Latency of the latest transition
+	uint32_t latency_max;       ///< Longest latency seen
+} master_latency;
+
 void task_master(void* pvParameters);
+void master_post(uint8_t event);
+signed portBASE_TYPE master_post_from_ISR(uint8_t event);
+signed portBASE_TYPE master_post_stamped_from_ISR(uint8_t event, uint32_t time);
+void master_post_fault(uint16_t cause);
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause);
+uint16_t master_get_fault_cause(void);
+void master_get_latency(master_latency *latency);
 
 #endif
\ No newline at end of file
@@ -1,7 +1,7 @@
 //*************************************************************************************
 /** \file task_motors.c
- *  \brief This file contains functions for motor drivers, encoders, and the motor
- *  tasks.
+ *  \brief This file contains functions for the motor drivers. The motors are run
+ *  by the control executive in control.c.
  *
  *  Revisions:
  *    \li 11-27-2014 JF, ML, JR created original file
@@ -30,57 +30,79 @@
 #include "semphr.h"
 
 #include "uart.h"
-#include "pid.h"
 #include "shares.h"
+#include "pid.h"
+#include "profile.h"
+#include "friction.h"
+#include "encoder.h"
+#include "adc.h"
+#include "thermal.h"
+#include "task_safety.h"
+#include "trip.h"
 #include "task_motors.h"
-#include "math.h"
-#include "task_master.h"
 
-// These are shared variables used by the motor tasks.
+// These are shared variables used by the control executive.
 volatile uint8_t int_occurred;
 int16_t motor1_power_SHARED; // Set by the Joystick
 int16_t motor2_power_SHARED;
 
-volatile int16_t position_M2_SHARED; // Set by encoder ISR which is defined in main.
-volatile int16_t position_M1_SHARED;
-
-volatile uint16_t error_M1_SHARED;  // Set by encoder ISR which is defined in main.
-volatile uint16_t error_M2_SHARED;
+int32_t position_cmd_SHARED[MOTOR_NUM_AXES]; // Set by orientation algorithm
+int32_t rate_cmd_SHARED[MOTOR_NUM_AXES];     // Rate and acceleration of the trajectory at
+int32_t accel_cmd_SHARED[MOTOR_NUM_AXES];    // position_cmd_SHARED, in Q16.16
+uint8_t setpoint_sequence_SHARED;            // Changed each time the three are written
 
-int16_t position_cmd_M1_SHARED; // Set by orientation algorithm
-int16_t position_cmd_M2_SHARED;
+int32_t position_targ_init_SHARED[MOTOR_NUM_AXES]; // Set by the control executive in SELECT_TARG
 
-int16_t position_targ_init_SHARED; // This will get by user in task_motors
-
-//-------------------------------------------------------------------------------------
-/** \brief This function initializes both motor encoders.
- *  \details This function initializes all of the required pins, variables, and
- *  interrupts necessary to use the quadrature encoders.
+/** The hardware and tuning of every motor axis, in flash. Adding an axis means adding
+ *  an entry here and raising MOTOR_NUM_AXES; the drivers, the fast trip, the thermal 
+ *  model and the control executive loop over this table. Motor 1 turns the opposite
+ *  way to motor 2 for the same controller output.
  */
-void encoders_init(void){	// Set encoder pins as inputs.
-	DDRA &= ~((1<<ENC_A_M1)|(1<<ENC_B_M1)|(1<<ENC_A_M2)|(1<<ENC_B_M2));
-
-    //Global variables, defined in task_motors.c. Only access in critical
-    //sections, or in tasks with priority : configMAX_PRIORITIES.
-    //Initialization is the only exception to this rule.
-    position_M1_SHARED = 0;
-    position_M2_SHARED = 0;
-
-    //Global variables, defined in task_motors.c. Only access in critical
-    //sections, or in tasks with priority : configMAX_PRIORITIES.
-    //Initialization is the only exception to this rule.
-    error_M1_SHARED = 0;
-    error_M2_SHARED = 0;
+const motor_axis motor_axes[] PROGMEM =
+{
+	{ // Motor 1
+		&PINB, (1<<IN_A_M1), (1<<IN_B_M1), &PINB, (1<<EN_AB_M1), &PIND, (1<<PWM_M1),
+		&OCR1A, (1<<COM1A1), PWR_LIMIT_M1, PWR_PEAK_M1, ENC_AXIS_M1, ADC_CURRENT_M1,
+		0, -1,
+		K_PROP_1, K_INT_1, K_DER_1, INT_CLAMP_1, OUT_CLAMP_1,
+		PROFILE_VEL_MAX_1, PROFILE_ACC_MAX_1, PROFILE_JERK_MAX_1,
+		K_FF_VEL_1, K_FF_ACC_1,
+		FRICTION_BREAKAWAY_1, FRICTION_DITHER_1,
+		THERMAL_CURRENT_M1, TRIP_CURRENT_M1, TRIP_OVERCURRENT_M1, TRIP_DRIVER_M1
+#ifdef VELOCITY_LOOP
+		, K_PROP_VEL_1, K_INT_VEL_1
+#endif
+#ifdef CURRENT_LOOP
+		, CURRENT_LIMIT_1, K_PROP_CUR_1, K_INT_CUR_1
+#endif
+	},
+	{ // Motor 2
+		&PINC, (1<<IN_A_M2), (1<<IN_B_M2), &PINC, (1<<EN_AB_M2), &PIND, (1<<PWM_M2),
+		&OCR1B, (1<<COM1B1), PWR_LIMIT_M2, PWR_PEAK_M2, ENC_AXIS_M2, ADC_CURRENT_M2,
+		1, +1,
+		K_PROP_2, K_INT_2, K_DER_2, INT_CLAMP_2, OUT_CLAMP_2,
+		PROFILE_VEL_MAX_2, PROFILE_ACC_MAX_2, PROFILE_JERK_MAX_2,
+		K_FF_VEL_2, K_FF_ACC_2,
+		FRICTION_BREAKAWAY_2, FRICTION_DITHER_2,
+		THERMAL_CURRENT_M2, TRIP_CURRENT_M2, TRIP_OVERCURRENT_M2, TRIP_DRIVER_M2
+#ifdef VELOCITY_LOOP
+		, K_PROP_VEL_2, K_INT_VEL_2
+#endif
+#ifdef CURRENT_LOOP
+		, CURRENT_LIMIT_2, K_PROP_CUR_2, K_INT_CUR_2
+#endif
+	}
+};
 
-	// Set encoder inputs as Pin Change interrupts.
-	PCICR |= (1<<PCIE0);
-    PCMSK0 |= (1<<PCINT0)|(1<<PCINT1)|(1<<PCINT2)|(1<<PCINT3);
-}
+// The table must have an entry for each axis; an axis without one would drive 
+// through a NULL register pointer. This fails to compile if the counts differ.
+typedef char motor_axes_count_check
+	[(sizeof(motor_axes)/sizeof(motor_axes[0]) == MOTOR_NUM_AXES) ? 1 : -1];
 
 //-------------------------------------------------------------------------------------
-/** \brief This function initializes both motors.
+/** \brief This function initializes all motors.
  *  \details This function initializes all required pins and variables for the motors,
- *  and also initializes timer 1 to generate an output pwm signal for both motor 
+ *  and also initializes timer 1 to generate an output pwm signal for the motor 
  *  controllers.
  */
 void motors_init(void){
@@ -89,251 +111,130 @@ void motors_init(void){
 	TCCR1A |= (1<<WGM11) | (1<<WGM10) | (1<<COM1A1) | (1<<COM1B1);
 	TCCR1A &= ~( (1<<COM1A0) | (1<<COM1B0) ) ;
 	TCCR1B = (1<<WGM12) | (1<<CS11);
-	OCR1A = 0x00;
-	OCR1B = 0x00;
 
-	// SET IN A/B pins as output for both motors
-	DDRB |= (1<<IN_A_M1) | (1<<IN_B_M1); 
-	DDRB |= (1<<IN_A_M2) | (1<<IN_B_M2);
-
-	// SET PWM signals for motors as outputs
-	DDRD |= (1<<PWM_M1) | (1<<PWM_M2);
-	
-	// Configure Motor 1 Enable A/B as an input with a pullup resistor.
-	DDRB &= ~(1<<EN_AB_M1);
-	PORTB |= (1<<EN_AB_M1);
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		motor_axis motor;
+		motor_get_axis(axis, &motor);
+		*motor.ocr = 0;
+
+		// SET IN A/B pins and the PWM signal as outputs. The PWM pin is low whenever
+		// motor_sleep() disconnects it from the timer.
+		MOTOR_DDR(motor.dir_pin) |= motor.in_a | motor.in_b;
+		MOTOR_DDR(motor.pwm_pin) |= motor.pwm;
+		MOTOR_PORT(motor.pwm_pin) &= ~motor.pwm;
+
+		// Configure Enable A/B as an input with a pullup resistor.
+		MOTOR_DDR(motor.en_pin) &= ~motor.en_ab;
+		MOTOR_PORT(motor.en_pin) |= motor.en_ab;
+
+		position_cmd_SHARED[axis] = 0;
+		rate_cmd_SHARED[axis] = 0;
+		accel_cmd_SHARED[axis] = 0;
+		position_targ_init_SHARED[axis] = 0;
+	}
+	setpoint_sequence_SHARED = 0;
 
-	// Configure Motor 2 Enable A/B as an input with a pullup resistor.
-	DDRC &= ~(1<<EN_AB_M2);
-	PORTC |= (1<<EN_AB_M2);
-	
 	//Global variables, defined in task_motors.c. Only access in critical
     //sections, or in tasks with priority : configMAX_PRIORITIES.
     //Initialization is the only exception to this rule.
     motor1_power_SHARED = 0;
     motor2_power_SHARED = 0;
-    position_cmd_M1_SHARED = 0;
-    position_cmd_M2_SHARED = 0;
-	position_targ_init_SHARED = 0;
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This function sets the power level for motor 1.
+/** \brief This function sets the power level for one motor.
  *  \details This function converts a signed integer into a pwm signal and direction
- *  command for the vnh5019 motor driver chips.
+ *  command for the vnh5019 motor driver chips. The power is clamped to what the
+ *  thermal model allows, between the peak limit of the axis and 0.
+ *  \param axis The motor, an index into motor_axes[].
  *  \param power The signed 16-bit integer corresponding to the magnitude and direction
- *  of power applied to the motors. 
+ *  of power applied to the motor. 
  */
-void motor1_power(int16_t power){
+void motor_power(uint8_t axis, int16_t power){
+	if(safety_error_SHARED)
+	{
+		// Tripped, see trip.c; the motors stay off until reset.
+		motor_sleep(axis);
+		return;
+	}
+	int16_t power_limit = thermal_power_limit(axis);
+	volatile uint8_t *dir_pin = MOTOR_AXIS_PTR(axis, dir_pin);
+	uint8_t in_a = MOTOR_AXIS_BYTE(axis, in_a);
+	uint8_t in_b = MOTOR_AXIS_BYTE(axis, in_b);
+	volatile uint16_t *ocr = MOTOR_AXIS_PTR(axis, ocr);
+	TCCR1A |= MOTOR_AXIS_BYTE(axis, pwm_com);
     if(power > 0)
     {
 		// Impose a saturation limitation on the motor power value. 
-        if(power>PWR_LIMIT_M1)
+        if(power > power_limit)
 		{
-    		power = PWR_LIMIT_M1;
+    		power = power_limit;
 		}
 		// Set direction to forward, through motor control pins.
-		PORTB |= (1<<IN_A_M1);
-    	PORTB &= ~(1<<IN_B_M1);
-    	OCR1A = power;
+		MOTOR_PORT(dir_pin) |= in_a;
+    	MOTOR_PORT(dir_pin) &= ~in_b;
+    	*ocr = power;
     }
     else
     {
 		// Impose a saturation limitation on the motor power value. 
-    	if(power<-PWR_LIMIT_M1)
+    	if(power < -power_limit)
 		{
-    		power = -PWR_LIMIT_M1;
+    		power = -power_limit;
 		}
 		// Set direction to reverse, through motor control pins.
-		PORTB |= (1<<IN_B_M1);
-    	PORTB &= ~(1<<IN_A_M1);
-        OCR1A = abs(power);
+		MOTOR_PORT(dir_pin) |= in_b;
+    	MOTOR_PORT(dir_pin) &= ~in_a;
+        *ocr = -power;
     }
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This function sets the power level for motor 2.
- *  \details This function converts a signed integer into a pwm signal and direction
- *  command for the vnh5019 motor driver chips.
- *  \param power The signed 16-bit integer corresponding to the magnitude and direction
- *  of power applied to the motors. 
+/** \brief This function turns the PWM output of one motor off.
+ *  \details The output is disconnected from the timer, so it stays low rather than 
+ *  putting out the one-count pulse a duty cycle of 0 leaves in fast PWM mode. The next
+ *  call of motor_power() connects it again.
+ *  \param axis The motor, an index into motor_axes[].
  */
-void motor2_power(int16_t power){
-    if(power > 0)
-    {
-		// Impose a saturation limitation on the motor power value. 
-        if(power>PWR_LIMIT_M2)
-		{
-    		power = PWR_LIMIT_M2;
-		}
-		// Set direction to forward, through motor control pins.
-		PORTC |= (1<<IN_A_M2);
-    	PORTC &= ~(1<<IN_B_M2);
-    	OCR1B = power;
-    }
-    else
-    {
-		// Impose a saturation limitation on the motor power value. 
-    	if(power<-PWR_LIMIT_M2)
-		{
-    		power = -PWR_LIMIT_M2;
-		}
-		// Set direction to reverse, through motor control pins.
-		PORTC |= (1<<IN_B_M2);
-    	PORTC &= ~(1<<IN_A_M2);
-        OCR1B  = abs( power);
-    }
+void motor_sleep(uint8_t axis){
+	TCCR1A &= ~MOTOR_AXIS_BYTE(axis, pwm_com);
+	*(volatile uint16_t *)MOTOR_AXIS_PTR(axis, ocr) = 0;
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This is the task function for motor 1.
- *  \details This function decides, based on the system state, which control signal gets
- *  to set the power level of motor 1. System state is decided/updated in task_master.
+/** \brief This function turns the PWM outputs of all motors off at once.
+ *  \details It is the fast trip's way to stop the motors, so it does only what has to
+ *  be done: disconnect the outputs from Timer 1, which drives them low, and clear the
+ *  duty cycles.
  */
-void task_motor1(void *pvParameters){
-    portTickType xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount();
-    motors_init();
-    int16_t motor1_power_cmd = 0;
-	int16_t motor1_joystick_cmd = 0;
-    int16_t motor1_position_cmd = 0;
-    int16_t motor1_position = 0;
-	int16_t state = 0;
-    while(1){
-    	taskENTER_CRITICAL();
-		    // Motor1_power_shared is updated by the joystick adc reading
-		    motor1_joystick_cmd = motor1_power_SHARED; 
-			
-			// Position_cmd_M1_SHARED is updated by task_orient
-     	    motor1_position_cmd = position_cmd_M1_SHARED; 
-			
-			// Motor1_position is updated by the encoders.
-	        motor1_position = position_M1_SHARED;
-			
-			// State_shared is updated by task_master
-			state = state_SHARED;
-        taskEXIT_CRITICAL();
-
-	    switch(state){
-			case  AWAITING_CAL : //Note: states are defined/described in task_master.h/.c
-		        motor1_power(0);
-		    	break; 
-			
-		    case CALIBRATION  :
-				// map 0-1023 ADC reading to (-1024,+1023)
-		    	motor1_power_cmd = motor1_joystick_cmd*2-1023;
-		     	motor1_power(motor1_power_cmd);
-		    	taskENTER_CRITICAL();
-			        position_M1_SHARED = 0;
-				taskEXIT_CRITICAL();
-				break;
-				
-			case AWAITING_TARG  :
-				motor1_power(0);
-				break;
-				
-			case SELECT_TARG  :
-				// map 0-1023 ADC reading to (-1024,+1023)
-				motor1_power_cmd = motor1_joystick_cmd*2-1023;
-				motor1_power(motor1_power_cmd);
-				taskENTER_CRITICAL();
-				    position_targ_init_SHARED = motor1_position;
-				taskEXIT_CRITICAL();
-				break;
-				
-			case TRACK_TARG  :// Position_cmd_M1_SHARED(aka motor1_position_cmd) is updated by task_orient
-				motor1_power_cmd = -pid_1(motor1_position, motor1_position_cmd);
-				motor1_power(motor1_power_cmd);
-				break;
-				
-			case ERROR  :
-				motor1_power(0);
-				break;
-				
-			case IDLE  :
-				motor1_power(0);
-				break;
-				
-			default : 
-				motor1_power(0);
-		}
-        vTaskDelayUntil(&xLastWakeTime, 50/portTICK_RATE_MS);
-    }
+void motors_trip(void){
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		motor_sleep(axis);
+	}
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This is the task function for motor 2.
- *  \details This function decides, based on the system state, which control signal gets
- *  to set the power level of motor 2. System state is decided in task_master.
+/** \brief This function copies the entry of one axis from motor_axes[] in flash.
+ *  \param axis The motor, an index into motor_axes[].
+ *  \param copy Where to copy it.
  */
-void task_motor2(void *pvParameters){
-    portTickType xLastWakeTime;
-    xLastWakeTime = xTaskGetTickCount();
-    motors_init();
-    int16_t motor2_power_cmd = 0;
-	int16_t motor2_joystick_cmd = 0;
-    int16_t motor2_position_cmd = 0;
-    int16_t motor2_position = 0;
-	int16_t state = 0;
-    while(1){
-    	taskENTER_CRITICAL();
-		    // Motor2_power_shared is updated by the joystick adc reading.
-		    motor2_joystick_cmd = motor2_power_SHARED;
-			
-			// Position_cmd_M2_SHARED is updated by task_orient.
-     	    motor2_position_cmd = position_cmd_M2_SHARED;
-			
-			// Motor2_position is updated by the encoders.
-	        motor2_position = position_M2_SHARED;
-			
-			// State_shared is updated by task_master.
-			state = state_SHARED;
-        taskEXIT_CRITICAL();
+void motor_get_axis(uint8_t axis, motor_axis *copy){
+	memcpy_P(copy, &motor_axes[axis], sizeof(motor_axis));
+}
 
-	switch(state){
-		case  AWAITING_CAL : //Note: states are defined/described in task_master.h/.c
-		    motor2_power(0);
-			break; 
-			
-		case CALIBRATION  :
-			// map 0-1023 ADC reading to (-1024,+1023)
-			motor2_power_cmd = motor2_joystick_cmd*2-1023; 
-			motor2_power(motor2_power_cmd);
-			taskENTER_CRITICAL();
-			    position_M2_SHARED = 0;
-			taskEXIT_CRITICAL();
-			break;
-			
-		case AWAITING_TARG  :
-			motor2_power(0);
-			break;
-			
-		case SELECT_TARG  :
-			// map 0-1023 ADC reading to (-1024,+1023)
-			motor2_power_cmd = motor2_joystick_cmd*2-1023;
-			motor2_power(motor2_power_cmd);
-			taskENTER_CRITICAL();
-			    position_targ_init_SHARED = motor2_position;
-			taskEXIT_CRITICAL();
-			break;
-			
-		case TRACK_TARG  : // Position_cmd_M1_SHARED(aka motor1_position_cmd) is updated by task_orient
-			motor2_power_cmd = pid_2(motor2_position, motor2_position_cmd);
-            motor2_power(motor2_power_cmd);
-			break;
-			
-		case ERROR  :
-			motor2_power(0);
-			break;
-				
-		case IDLE  :
-			motor2_power(0);
-			break;
-				
-		default : 
-			motor2_power(0);
-		
+//-------------------------------------------------------------------------------------
+/** \brief This function finds the axis whose current sense an ADC channel reads.
+ *  \param adc_channel One of the ADC_ channel #defines of adc.h.
+ *  
+eturn The axis, an index into motor_axes[], or MOTOR_NUM_AXES if it is none.
+ */
+uint8_t motor_axis_of_current(uint8_t adc_channel){
+	uint8_t axis = 0;
+	while(axis < MOTOR_NUM_AXES && MOTOR_AXIS_BYTE(axis, current) != adc_channel)
+	{
+		axis++;
 	}
-        vTaskDelayUntil(&xLastWakeTime, 50/portTICK_RATE_MS);
-    }
+	return axis;
 }
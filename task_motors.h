@@ -1,6 +1,6 @@
 //*************************************************************************************
 /** \file task_motors.h
- *  \brief This file contains #defines and function declarations for motor tasks.
+ *  \brief This file contains #defines and function declarations for motor drivers.
  *
  *  Revisions:
  *    \li 11-27-2014 JF, ML, JR created original file
@@ -24,7 +24,18 @@
 #ifndef _TASK_MOTORS_H_
 #define _TASK_MOTORS_H_
 
-#define STACK_SIZE_MOTORS 280
+#include <avr/pgmspace.h>
+
+// Number of motor axes. Each one needs an entry in motor_axes[] in task_motors.c,
+// an encoder channel (ENC_NUM_AXES in encoder.h must match) and a PWM output. The
+// host tests set it on the command line to measure how the cost grows per axis. The
+// fast trip, the thermal model and the supervisor keep their state per axis.
+#ifndef MOTOR_NUM_AXES
+#define MOTOR_NUM_AXES 2
+#endif
+
+// Number of joysticks, which the axes pick from by their joystick channel
+#define MOTOR_NUM_JOYSTICKS 2
 
 // MOTOR 1 CONTROL SIGNALS
 #define IN_A_M1 PB0
@@ -38,25 +49,82 @@
 #define EN_AB_M2 PC6
 #define PWM_M2 PD4
 
-// ENCODER CONTROL SIGNALS
-#define ENC_A_M1 PA0
-#define ENC_B_M1 PA1
-#define ENC_A_M2 PA2
-#define ENC_B_M2 PA3
-
-// MOTOR POWER SATURATION LIMIT
+// MOTOR POWER SATURATION LIMIT, which the motors can be run at for good
 #define PWR_LIMIT_M1 150
 #define PWR_LIMIT_M2 350
 
+// Peak power limit, allowed for short bursts while the thermal model in thermal.c
+// says the motor is cool enough
+#define PWR_PEAK_M1 300
+#define PWR_PEAK_M2 700
 
-void encoders_init(void);
+/** This structure describes the hardware and default tuning of one motor axis. Ports
+ *  are given by their PINx register; on the AVR the DDRx and PORTx registers of the
+ *  same port follow it at +1 and +2, see MOTOR_DDR() and MOTOR_PORT(). The PWM 
+ *  register must be a 16-bit output compare of Timer 1 running in the mode set up
+ *  by motors_init().
+ */
+typedef struct
+{
+	volatile uint8_t *dir_pin;  ///< PINx of the port with the IN_A and IN_B pins
+	uint8_t in_a;               ///< Bit mask of the IN_A pin
+	uint8_t in_b;               ///< Bit mask of the IN_B pin
+	volatile uint8_t *en_pin;   ///< PINx of the port with the EN_AB fault pin
+	uint8_t en_ab;              ///< Bit mask of the EN_AB pin, low on a driver fault
+	volatile uint8_t *pwm_pin;  ///< PINx of the port with the PWM output
+	uint8_t pwm;                ///< Bit mask of the PWM output pin
+	volatile uint16_t *ocr;     ///< Output compare register which sets the duty cycle
+	uint8_t pwm_com;            ///< Bit of TCCR1A which connects the PWM to its pin
+	int16_t power_limit;        ///< Largest magnitude of power for good, in OCR counts
+	int16_t peak_limit;         ///< Largest magnitude of power for short bursts
+	uint8_t encoder;            ///< Encoder channel, one of the ENC_AXIS_ numbers
+	uint8_t current;            ///< ADC channel of the current sense, see adc.h
+	uint8_t joystick;           ///< Joystick channel which drives the axis by hand
+	int8_t sign;                ///< Sign from controller output to motor power, +1 or -1
+	float k_prop;               ///< Position controller gains, at PID_TUNED_PERIOD_US
+	float k_int;
+	float k_der;
+	float int_clamp;            ///< Position controller integral and output limits
+	int16_t out_clamp;
+	float vel_max;              ///< Motion profile limits, in counts/s, counts/s^2
+	float acc_max;              ///< and counts/s^3
+	float jerk_max;
+	float k_ff_vel;             ///< Feedforward gains, per count/s and count/s^2 of the
+	float k_ff_acc;             ///< trajectory
+	int16_t breakaway;          ///< Static friction compensation, power at which the
+	int16_t dither;             ///< axis breaks away until calibrated, and dither
+	uint16_t rated_current;     ///< Current it carries for good, see thermal.h
+	uint16_t trip_current;      ///< Current the fast trip acts on, see trip.h
+	uint16_t overcurrent_fault; ///< TRIP_ bit latched when its current trips
+	uint16_t driver_fault;      ///< TRIP_ bit latched when its driver reports a fault
+#ifdef VELOCITY_LOOP
+	float k_prop_vel;           ///< Velocity loop gains, at VELOCITY_TUNED_PERIOD_US
+	float k_int_vel;
+#endif
+#ifdef CURRENT_LOOP
+	int16_t current_limit;      ///< Limit of the current reference, in ADC counts
+	float k_prop_cur;           ///< Current loop gains, at CURRENT_TUNED_PERIOD_US
+	float k_int_cur;
+#endif
+} motor_axis;
 
-void motors_init(void);
+#define MOTOR_DDR(pin_register)  ( *((pin_register) + 1) )
+#define MOTOR_PORT(pin_register) ( *((pin_register) + 2) )
 
-void motor1_power(int16_t power);
-void motor2_power(int16_t power);
+// The table of axes is in flash. Read single fields of it with these, or copy a 
+// whole entry with motor_get_axis() where many fields are needed.
+#define MOTOR_AXIS_BYTE(axis, field) pgm_read_byte(&motor_axes[axis].field)
+#define MOTOR_AXIS_WORD(axis, field) pgm_read_word(&motor_axes[axis].field)
+#define MOTOR_AXIS_PTR(axis, field)  pgm_read_ptr(&motor_axes[axis].field)
+
+extern const motor_axis motor_axes[] PROGMEM;
+
+void motors_init(void);
+void motor_get_axis(uint8_t axis, motor_axis *copy);
+uint8_t motor_axis_of_current(uint8_t adc_channel);
 
-void task_motor1(void *pvParameters);
-void task_motor2(void *pvParameters);
+void motor_power(uint8_t axis, int16_t power);
+void motor_sleep(uint8_t axis);
+void motors_trip(void);
 
 #endif
\ No newline at end of file
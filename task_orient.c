@@ -35,6 +35,7 @@
 
 #include "shares.h"
 #include "task_orient.h"
+#include "task_motors.h"
 #include "twi.h"
 
 /// These are the magnetometer position variables
@@ -105,8 +106,17 @@ void task_orient(void* pvParameters){
      	vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
      	    HMC5883_read();
     	vTaskPrioritySet(NULL, default_orient_prio);
-		position_cmd_M1_SHARED = 0; // To be changed as soon as the orientation algorithm
-	    position_cmd_M2_SHARED = 0; // is implemented.
+		// The control executive follows the trajectory between updates from its rate
+		// and acceleration, so publish all three, in the same critical section.
+		taskENTER_CRITICAL();
+		    for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+		    {
+		        position_cmd_SHARED[axis] = 0; // To be changed as soon as the orientation
+		        rate_cmd_SHARED[axis] = 0;     // algorithm is implemented.
+		        accel_cmd_SHARED[axis] = 0;
+		    }
+		    setpoint_sequence_SHARED++;
+		taskEXIT_CRITICAL();
     	vTaskDelayUntil(&xLastWakeTime, 600000/portTICK_RATE_MS);
     }
 }
\ No newline at end of file
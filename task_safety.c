@@ -32,62 +32,74 @@
 
 #include "shares.h"
 #include "task_sensors.h"
+#include "adc.h"
 #include "twi.h"
 #include "task_motors.h"
 #include "task_safety.h"
+#include "task_master.h"
+#include "trip.h"
+#include "safety_log.h"
 
-uint8_t safety_error_SHARED;
+/// Message sent to the serial port for a record of each cause, see safety_log.h.
+static const char *sft_messages[SAFETY_LOG_CAUSES] =
+{
+	"Error: Excess current in Motor 1!",
+	"Error: Excess current in Motor 2!",
+	"Error: Fault on Motor 1!",
+	"Error: Fault on Motor 2!",
+	"Error: Axis stalled!",
+	"Error: Axis ran away!",
+	"Error: Encoder lost!",
+	"Error: Limit switch!",
+	"Error: Emergency stop!",
+	"Wind stow requested!"
+};
 
 //-------------------------------------------------------------------------------------
 /** \brief This task function for the safety task.
  *  \details monitors the the motor diag_enable A/B pins, and the
- *  current, and shuts the motors off if any problems are detected.
+ *  current, and shuts the motors off if any problems are detected, by latching a 
+ *  fault, see trip.c, which also wakes the master and logs it. The fast trip catches
+ *  the same faults from interrupt level much sooner; this task is the backup, and 
+ *  checks the filtered currents, which a short burst of noise can't trip. It also 
+ *  sends a message to the serial port for each new record in the safety log, so a
+ *  fault which persists is reported once rather than every time it is checked.
  */
 void task_safety(void* pvParameters){
 	uint8_t default_safety_prio = uxTaskPriorityGet(NULL);
 	portTickType xLastWakeTime;
     xLastWakeTime = xTaskGetTickCount();
-	uint8_t safety_error_SHARED = 0;
-    uint16_t current_val_M1 = 0;
-    uint16_t current_val_M2 = 0;
-    const char *over_current_m1 = "Error: Excess current in Motor 1!";
-    const char *over_current_m2 = "Error: Excess current in Motor 2!";
-    const char *fault_m1 = "Error: Fault on Motor 1!";
-    const char *fault_m2 = "Effor: Fault on Motor 2!";
+	uint16_t faults;
+    adc_filtered current;
+    safety_log_record record;
+    uint8_t log_sequence = 0;
 
     while(1)
     {   
-		// Check for over current in motor 1.
-    	current_val_M1 = adc_read(ADC_CURRENT_M1); 
-    	if(current_val_M1>MAX_CURRENT_M1)
+		// Check each motor for over current. The low passed current is used, so a
+		// single noisy reading can't trip the check.
+    	faults = 0;
+    	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
     	{
-			// Critical section unnecessary for accessing the shared var,
-			// since the safety task has the top priority :D
-			// (also no ISR touches this var)
-			safety_error_SHARED = 1; //Flag an error!
-            xQueueSend(comms_queue,&over_current_m1,0);
-    	}          
-    	
-    	// Check for over current in motor 2.
-    	current_val_M2 = adc_read(ADC_CURRENT_M2);
-    	if(current_val_M2>MAX_CURRENT_M2)
-    	{
-			safety_error_SHARED = 1;//Flag an error!
-            xQueueSend(comms_queue,&over_current_m2,0);
+    		adc_read_filtered(MOTOR_AXIS_BYTE(axis, current), &current);
+    		if(current.value > MOTOR_AXIS_WORD(axis, trip_current)*ADC_FILTER_SCALE)
+    		{
+    			faults |= MOTOR_AXIS_WORD(axis, overcurrent_fault); //Flag an error!
+    		}
     	}
         
-        // Check for fault on motor 1.
-    	if( !(PINC & (1<<EN_AB_M1)) )
-    	{
-			safety_error_SHARED = 1;//Flag an error!
-    		xQueueSend(comms_queue,&fault_m1,0);
-    	}
+        // Check for faults on the drivers, which pull their EN_AB pins low.
+    	faults |= trip_driver_faults();
+
+    	// Latch the faults, which turns the motors off and, on the first fault, wakes 
+    	// the master. The error stays latched until the master resets it.
+    	trip_fault(faults);
 
-    	// Check for fault on motor 2.
-    	if( !(PINC & (1<<EN_AB_M2)) )
+    	// Report what was logged since the last time, from here or from interrupts.
+    	safety_log_tick();
+    	while(safety_log_read(&record, 1, &log_sequence))
     	{
-			safety_error_SHARED = 1;//Flag an error!
-    		xQueueSend(comms_queue,&fault_m2,0);
+    		xQueueSend(comms_queue, &sft_messages[record.cause], 0);
     	}
     	
     	vTaskDelayUntil(&xLastWakeTime, 100/portTICK_RATE_MS);
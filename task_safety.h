@@ -25,8 +25,6 @@
 #define _TASK_SAFETY_H_
 
 #define STACK_SIZE_SAFETY 280
-#define ADC_CURRENT_M1 4 /// CHECK THESE VALUES!!!!!!!!!
-#define ADC_CURRENT_M2 5
 #define MAX_CURRENT_M1 512 // CALCULATE AMPS!!!!
 #define MAX_CURRENT_M2 512
 void task_safety(void* pvParameters);
@@ -32,9 +32,13 @@
 
 #include "shares.h"
 #include "task_sensors.h"
+#include "adc.h"
+#include "debounce.h"
+#include "task_master.h"
+#include "safety_log.h"
+#include "trip.h"
 #include "twi.h"
 
-xSemaphoreHandle adc_mutex_semaphore;
 uint8_t btn_SHARED;
 //-------------------------------------------------------------------------------------
 /** \brief This Function prompts the AVR I2C device to read one or more bytes.
@@ -51,114 +55,70 @@ uint8_t btn_SHARED;
  */
 
 //-------------------------------------------------------------------------------------
-/** \brief This function initializes the ADC on the ATMEGA 1284p.
+/** \brief This function passes the edges of the switch inputs on to the master.
+ *  \details It runs in the RTOS tick interrupt, as a subscriber of the debouncer, so an
+ *  edge reaches the master within a tick of being accepted, stamped with the time it
+ *  was. A limit switch or the emergency stop latches a fault, which turns the motors 
+ *  off here and now, logs it and tells the master the cause. A wind stow request is
+ *  not a fault: it is logged, and its start and end are passed on as events.
+ *  @param event The edge.
  */
-void adc_init(void){
-	// Set the "ADC Enable" bit within the ADC Status Register A,
-	// and set the ADC clock prescaler to divide by 32. Enable
-	// interrupt on conversion complete. 
-	ADCSRA = (1<<ADIE) | (1<<ADEN) | (1<<ADPS2) | (1<<ADPS0);
-	ADMUX |= 1<<REFS0;// Set the analog reference voltage to AVCC.
+static void sensors_input(const debounce_event *event){
+	uint8_t post = 0xFF;
+	switch(event->input){
+		case DEBOUNCE_BUTTON :
+			btn_SHARED = event->active;
+			post = event->active ? MASTER_EVENT_BUTTON_PRESS 
+			                             : MASTER_EVENT_BUTTON_RELEASE;
+			break;
 
-}
-
-//-------------------------------------------------------------------------------------
-/** \brief This Function reads a byte from the selected ADC channel.
- *  @param adc_channel Takes one of the #define macros from task_sensors.h as a
- *  parameter, for the purpose of selecting one of the ADC channels.
- *  @return Returns and unsigned 16bit data value.
- */
-uint16_t adc_read(uint8_t adc_channel){
-	/// Use a mutex to control access to the ADC.
-    xSemaphoreTake(adc_mutex_semaphore, portMAX_DELAY);
-        
-	    // Clear the ADC Multiplexor Selection bits, and the set them to
-        // the appropriate ADC channel.
-        ADMUX &= ~( (1<<MUX2)|(1<<MUX1)|(1<<MUX0) ); 
-	    ADMUX |= adc_channel; 
-		
-		// Set the "ADC start conversion" bit, initiating a conversion.
-		ADCSRA |= 1<<ADSC;
-	    const uint16_t maxWaitCycles = 60000;
-	    uint16_t counter = 0;
-	    while(ADCSRA & (1<<ADSC) && maxWaitCycles > counter++);
-        uint16_t temp = ADC;
+		case DEBOUNCE_AUTOTUNE : // The only way to ask for an autotune
+			if(event->active)
+			{
+				post = MASTER_EVENT_AUTOTUNE;
+			}
+			break;
 
-	xSemaphoreGive(adc_mutex_semaphore);
-	return temp;
+		case DEBOUNCE_STOW :
+			if(event->active)
+			{
+				safety_log_post_from_ISR(SAFETY_CAUSE_STOW, xTaskGetTickCountFromISR());
+			}
+			post = event->active ? MASTER_EVENT_STOW : MASTER_EVENT_STOW_END;
+			break;
 
+		default : // The limit switches and the emergency stop
+			if(event->active)
+			{
+				trip_fault_from_ISR((event->input == DEBOUNCE_ESTOP) ? TRIP_ESTOP 
+				                                                     : TRIP_LIMIT);
+			}
+	}
+	if(post != 0xFF)
+	{
+		master_post_stamped_from_ISR(post, event->time);
+	}
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This Function detects whether or not a button has been pressed.
- *  \details This function performs a software debounce, and updates a shared 
- *  variable(btn_SHARED) when a level change is detected, indicating that 
- *  the button has been pressed.
- *  @return Returns the status of the button level.
+/** \brief This function tells whether the "Target Set" button is pressed.
+ *  @return Nonzero if it is, as debounced.
  */
 uint8_t button_pressed(void){
-	static uint16_t count = 0;
-	static uint8_t btn_on = 0;
-	
-	if( PINC & (1<<PC3) ) // This indicates that the button is NOT pressed, since
-	{                     // a pullup resistor, and a switch to ground are used
-	  
-		if (count >= BTN_OFF_THRESHHOLD) //If button has been released for a  
-		{                               // certain number of cycles, consider
-		                                // it to be "off".
-		  
-			
-			
-			if(btn_on)        // If the button was previously ON, update the
-			{                 // shared button variable.
-			  taskENTER_CRITICAL();
-			      btn_SHARED = 0;
-			  taskEXIT_CRITICAL();
-			}
-			btn_on = 0; // update the local button variable.
-			count = count;    //clamp the count variable to the threshhold.
-		}
-		else // Button pin reading is low, but the button can't be certainly
-		{    // said to be released, yet. Increment "count" variable until the 
-		     // "Button OFF threshhold" has been met.
-			count++;
-		}
-	}
-
-	else // This indicates that  PINC & (1<<PC3) evaluates false, so the button pin is reading
-	     // a signal indicating that the button is pressed. 
-	{
-		if (count <= 0) // IF button has been pressed for long enough for the
-		                // count variable to decrement all the way to zero, 
-		{               // The button is definitely being pressed.
-			count = 0; // clamp the count to zero.
-			
-			if(!btn_on) // IF the button was previously OFF, update the shared
-			{           // button variable.
-			  taskENTER_CRITICAL();
-			      btn_SHARED = 1;
-			  taskEXIT_CRITICAL();
-			}
-			btn_on = 1; // update the local button variable.
-		}
-		
-		
-		else // The button pin is reading that the button is being pressed, but the 
-		     // button can't be certainly said to be pressed yet. Continue decrementing
-		     // count, until it hits zero, indicating a definite press of the button.
-	        {    
-	         	count--;
-	        }
-	}
-	return btn_on;
+	return debounce_active(DEBOUNCE_BUTTON);
 }
 
 //-------------------------------------------------------------------------------------
-/** \brief This function initializes the "Target Set" button.
+/** \brief This function subscribes to the "Target Set" button and the other switches.
  */
 void button_init(void){
-    btn_SHARED = 0;
-    DDRC &= ~(1<<PC3);
+	taskENTER_CRITICAL();
+		btn_SHARED = 0;
+	taskEXIT_CRITICAL();
+	debounce_subscribe((1U << DEBOUNCE_BUTTON) | (1U << DEBOUNCE_LIMIT_1)
+	                   | (1U << DEBOUNCE_LIMIT_2) | (1U << DEBOUNCE_ESTOP)
+	                   | (1U << DEBOUNCE_STOW) | (1U << DEBOUNCE_AUTOTUNE),
+	                   sensors_input);
 }
 
 //-------------------------------------------------------------------------------------
@@ -170,10 +130,8 @@ void button_init(void){
  *  full reverse(0);
  */
 void task_sensors(void* pvParameters){
-	uint8_t default_sensor_prio = uxTaskPriorityGet(NULL);
 	portTickType xLastWakeTime;
     xLastWakeTime = xTaskGetTickCount();
-    adc_init();
     uint16_t joystick_y;
     uint16_t joystick_x;
     button_init();
@@ -183,16 +141,17 @@ void task_sensors(void* pvParameters){
         if(button_pressed()){
             joystick_y = adc_read(ADC_JOYSTICK_Y);
             joystick_x = adc_read(ADC_JOYSTICK_X);
-            vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+            // The control ISR reads these, so raising priority isn't enough.
+            taskENTER_CRITICAL();
     	        motor1_power_SHARED = joystick_y;
     	        motor2_power_SHARED = joystick_x;
-    	    vTaskPrioritySet(NULL, default_sensor_prio);
+    	    taskEXIT_CRITICAL();
     	}
     	else{
-	    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+	    taskENTER_CRITICAL();
     	        motor1_power_SHARED = 512;
     	        motor2_power_SHARED = 512;
-    	    vTaskPrioritySet(NULL, default_sensor_prio);
+    	    taskEXIT_CRITICAL();
 	    }
     	vTaskDelayUntil(&xLastWakeTime, 100/portTICK_RATE_MS);
     }
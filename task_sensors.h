@@ -27,13 +27,8 @@
 
 #define SIZE_SENSORS_QUEUE 30
 #define STACK_SIZE_SENSORS 280
-#define ADC_JOYSTICK_X 0x07
-#define ADC_JOYSTICK_Y 0x06
-#define BTN_ON_THRESHHOLD 5
 
 void task_sensors(void* pvParameters);
-void adc_init(void);
-uint16_t adc_read(uint8_t adc_channel);
 uint8_t button_pressed(void);
 void button_init(void);
 
@@ -0,0 +1,56 @@
+//*************************************************************************************
+/** \file FreeRTOS.h
+ *  \brief This file stands in for the FreeRTOS headers when the firmware modules are
+ *  compiled on the host. Critical sections do nothing, since the tests are single
+ *  threaded, and the tick count is a variable the test advances, see stub.c.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _STUB_FREERTOS_H_
+#define _STUB_FREERTOS_H_
+
+#include <stdint.h>
+
+// Types and constants as in the ATmega port, with 32-bit ticks
+typedef uint32_t portTickType;
+#define portBASE_TYPE         char
+#define portMAX_DELAY         ( (portTickType)0xFFFFFFFF )
+#define portCLOCK_PRESCALER   ( (unsigned long)8 )
+#define pdTRUE                1
+#define pdFALSE               0
+#define pdPASS                1
+#define pdFAIL                0
+
+#define configCPU_CLOCK_HZ    ( (unsigned long)F_CPU )
+#define configTICK_RATE_HZ    ( (portTickType)1000 )
+#define configMAX_PRIORITIES  ( 5 )
+#define configMS_TO_TICKS(x)  ((((x) * configTICK_RATE_HZ / 1000) > 0) \
+                              ? ((x) * configTICK_RATE_HZ / 1000) : 1)
+#define portTICK_RATE_MS      ( (portTickType)1000/configTICK_RATE_HZ )
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskYIELD()
+#define portYIELD_FROM_ISR()
+
+/// The RTOS tick count, advanced by the tests.
+extern volatile portTickType stub_tick_count;
+
+#endif // _STUB_FREERTOS_H_
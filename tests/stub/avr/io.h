@@ -0,0 +1,292 @@
+//*************************************************************************************
+/** \file avr/io.h
+ *  \brief This file stands in for the avr-libc register definitions when the firmware
+ *  modules are compiled on the host for the tests in this directory.
+ *  \details Every I/O register is a location in avr_io[], at its data memory address 
+ *  on the ATmega1284P, so a PINx pointer plus one is still DDRx as task_motors.h 
+ *  expects. Only the registers and bits used by the firmware are defined.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _STUB_AVR_IO_H_
+#define _STUB_AVR_IO_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/// The I/O and extended I/O space of the simulated ATmega1284P, see stub.c.
+extern volatile uint8_t avr_io[0x100];
+
+#define _SFR_MEM8(address)  ( *(volatile uint8_t *)&avr_io[(address)] )
+#define _SFR_MEM16(address) ( *(volatile uint16_t *)&avr_io[(address)] )
+#define _BV(bit) ( 1<<(bit) )
+
+// 8-bit registers
+#define PINA     _SFR_MEM8(0x20)
+#define DDRA     _SFR_MEM8(0x21)
+#define PORTA    _SFR_MEM8(0x22)
+#define PINB     _SFR_MEM8(0x23)
+#define DDRB     _SFR_MEM8(0x24)
+#define PORTB    _SFR_MEM8(0x25)
+#define PINC     _SFR_MEM8(0x26)
+#define DDRC     _SFR_MEM8(0x27)
+#define PORTC    _SFR_MEM8(0x28)
+#define PIND     _SFR_MEM8(0x29)
+#define DDRD     _SFR_MEM8(0x2A)
+#define PORTD    _SFR_MEM8(0x2B)
+#define TIFR0    _SFR_MEM8(0x35)
+#define TIFR1    _SFR_MEM8(0x36)
+#define TIFR2    _SFR_MEM8(0x37)
+#define TIFR3    _SFR_MEM8(0x38)
+#define PCIFR    _SFR_MEM8(0x3B)
+#define EIFR     _SFR_MEM8(0x3C)
+#define EIMSK    _SFR_MEM8(0x3D)
+#define GPIOR0   _SFR_MEM8(0x3E)
+#define EECR     _SFR_MEM8(0x3F)
+#define GTCCR    _SFR_MEM8(0x43)
+#define TCCR0A   _SFR_MEM8(0x44)
+#define TCCR0B   _SFR_MEM8(0x45)
+#define TCNT0    _SFR_MEM8(0x46)
+#define OCR0A    _SFR_MEM8(0x47)
+#define OCR0B    _SFR_MEM8(0x48)
+#define ACSR     _SFR_MEM8(0x50)
+#define SMCR     _SFR_MEM8(0x53)
+#define MCUSR    _SFR_MEM8(0x54)
+#define MCUCR    _SFR_MEM8(0x55)
+#define SREG     _SFR_MEM8(0x5F)
+#define WDTCSR   _SFR_MEM8(0x60)
+#define PRR0     _SFR_MEM8(0x64)
+#define PCICR    _SFR_MEM8(0x68)
+#define EICRA    _SFR_MEM8(0x69)
+#define PCMSK0   _SFR_MEM8(0x6B)
+#define PCMSK1   _SFR_MEM8(0x6C)
+#define PCMSK2   _SFR_MEM8(0x6D)
+#define TIMSK0   _SFR_MEM8(0x6E)
+#define TIMSK1   _SFR_MEM8(0x6F)
+#define TIMSK2   _SFR_MEM8(0x70)
+#define TIMSK3   _SFR_MEM8(0x71)
+#define PCMSK3   _SFR_MEM8(0x73)
+#define ADCL     _SFR_MEM8(0x78)
+#define ADCH     _SFR_MEM8(0x79)
+#define ADCSRA   _SFR_MEM8(0x7A)
+#define ADCSRB   _SFR_MEM8(0x7B)
+#define ADMUX    _SFR_MEM8(0x7C)
+#define DIDR0    _SFR_MEM8(0x7E)
+#define DIDR1    _SFR_MEM8(0x7F)
+#define TCCR1A   _SFR_MEM8(0x80)
+#define TCCR1B   _SFR_MEM8(0x81)
+#define TCCR1C   _SFR_MEM8(0x82)
+#define TCCR3A   _SFR_MEM8(0x90)
+#define TCCR3B   _SFR_MEM8(0x91)
+#define TCCR3C   _SFR_MEM8(0x92)
+#define OCR3AL   _SFR_MEM8(0x98)
+#define OCR3AH   _SFR_MEM8(0x99)
+#define TCCR2A   _SFR_MEM8(0xB0)
+#define TCCR2B   _SFR_MEM8(0xB1)
+#define TCNT2    _SFR_MEM8(0xB2)
+#define OCR2A    _SFR_MEM8(0xB3)
+#define OCR2B    _SFR_MEM8(0xB4)
+#define ASSR     _SFR_MEM8(0xB6)
+#define TWBR     _SFR_MEM8(0xB8)
+#define TWSR     _SFR_MEM8(0xB9)
+#define TWAR     _SFR_MEM8(0xBA)
+#define TWDR     _SFR_MEM8(0xBB)
+#define TWCR     _SFR_MEM8(0xBC)
+#define UCSR0A   _SFR_MEM8(0xC0)
+#define UCSR0B   _SFR_MEM8(0xC1)
+#define UCSR0C   _SFR_MEM8(0xC2)
+#define UBRR0L   _SFR_MEM8(0xC4)
+#define UBRR0H   _SFR_MEM8(0xC5)
+#define UDR0     _SFR_MEM8(0xC6)
+
+// 16-bit registers
+#define ADC      _SFR_MEM16(0x78)
+#define ADCW     _SFR_MEM16(0x78)
+#define TCNT1    _SFR_MEM16(0x84)
+#define ICR1     _SFR_MEM16(0x86)
+#define OCR1A    _SFR_MEM16(0x88)
+#define OCR1B    _SFR_MEM16(0x8A)
+#define TCNT3    _SFR_MEM16(0x94)
+#define ICR3     _SFR_MEM16(0x96)
+#define OCR3A    _SFR_MEM16(0x98)
+#define OCR3B    _SFR_MEM16(0x9A)
+
+// Register bits
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define PINA0 0
+#define PINA1 1
+#define PINA2 2
+#define PINA3 3
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+#define MUX4 4
+#define MUX3 3
+#define MUX2 2
+#define MUX1 1
+#define MUX0 0
+#define ADTS2 2
+#define ADTS1 1
+#define ADTS0 0
+#define ACME 6
+#define ACD 7
+#define ACBG 6
+#define ACO 5
+#define ACI 4
+#define ACIE 3
+#define ACIC 2
+#define ACIS1 1
+#define ACIS0 0
+#define COM1A1 7
+#define COM1A0 6
+#define COM1B1 5
+#define COM1B0 4
+#define WGM11 1
+#define WGM10 0
+#define ICNC1 7
+#define ICES1 6
+#define WGM13 4
+#define WGM12 3
+#define CS12 2
+#define CS11 1
+#define CS10 0
+#define ICIE1 5
+#define OCIE1B 2
+#define OCIE1A 1
+#define TOIE1 0
+#define ICF1 5
+#define OCF1B 2
+#define OCF1A 1
+#define TOV1 0
+#define COM0A1 7
+#define COM0A0 6
+#define WGM01 1
+#define WGM00 0
+#define WGM02 3
+#define CS02 2
+#define CS01 1
+#define CS00 0
+#define OCIE0B 2
+#define OCIE0A 1
+#define TOIE0 0
+#define OCF0A 1
+#define COM2A1 7
+#define WGM21 1
+#define WGM20 0
+#define WGM22 3
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2B 2
+#define OCIE2A 1
+#define TOIE2 0
+#define OCF2A 1
+#define CS31 1
+#define WGM32 3
+#define OCIE3A 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIE3 3
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCIF3 3
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT10 2
+#define PCINT18 2
+#define PCINT19 3
+#define PCINT20 4
+#define PCINT21 5
+#define PCINT22 6
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define U2X0 1
+#define RXEN0 4
+#define TXEN0 3
+#define RXCIE0 7
+#define UDRIE0 5
+#define USBS0 3
+#define UCSZ00 1
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWEN 2
+#define ADC0D 0
+#define ADC4D 4
+#define ADC5D 5
+#define TWPS1 1
+#define TWPS0 0
+#define OCF3A 1
+
+// Interrupt vectors, which the ISR() stub turns into plain functions
+#define ADC_vect           ADC_vect
+#define PCINT0_vect        PCINT0_vect
+#define PCINT1_vect        PCINT1_vect
+#define PCINT2_vect        PCINT2_vect
+#define TIMER1_OVF_vect    TIMER1_OVF_vect
+#define TIMER2_COMPA_vect  TIMER2_COMPA_vect
+#define TIMER3_COMPA_vect  TIMER3_COMPA_vect
+
+#endif // _STUB_AVR_IO_H_
@@ -0,0 +1,37 @@
+//*************************************************************************************
+/** \file queue.h
+ *  \brief This file stands in for the FreeRTOS queue API on the host. Tests which
+ *  link a module that uses queues define the functions they need.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _STUB_QUEUE_H_
+#define _STUB_QUEUE_H_
+
+typedef void *xQueueHandle;
+
+xQueueHandle xQueueCreate(unsigned portBASE_TYPE length, unsigned portBASE_TYPE size);
+signed portBASE_TYPE xQueueSend(xQueueHandle queue, const void *item, portTickType wait);
+signed portBASE_TYPE xQueueSendFromISR(xQueueHandle queue, const void *item, 
+                                       signed portBASE_TYPE *woken);
+signed portBASE_TYPE xQueueReceive(xQueueHandle queue, void *item, portTickType wait);
+unsigned portBASE_TYPE uxQueueMessagesWaiting(xQueueHandle queue);
+
+#endif // _STUB_QUEUE_H_
@@ -0,0 +1,58 @@
+//*************************************************************************************
+/** \file test.h
+ *  \brief This file contains the checking and timing helpers shared by the host tests.
+ *  \details Each test is a program which prints what it measured, reports every 
+ *  failed check with its file and line, and exits with a nonzero status if any
+ *  check failed, see the Makefile in this directory.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdio.h>
+#include <time.h>
+
+/// Number of failed checks in this test program.
+static int test_failures;
+
+/// Counts and reports a failure, with a printf() style message, unless the condition holds.
+#define CHECK(condition, ...) \
+	do { if(!(condition)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); \
+		test_failures++; } } while(0)
+
+/// Prints the verdict of the test program; return its value from main().
+#define TEST_RESULT(name) \
+	( printf("%s: %s\n", (name), test_failures ? "FAILED" : "passed"), test_failures != 0 )
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns a monotonic host time, for timing the code under test.
+ *  \details Host times only compare two versions of the same code with each other.
+ *  Cycle counts on the ATmega1284P have to be taken on the target or in a simulator.
+ *  @return The time in seconds from an arbitrary start.
+ */
+static inline double test_seconds(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+#endif // _TEST_H_
@@ -0,0 +1,336 @@
+//*************************************************************************************
+/** \file test_adc.c
+ *  \brief This file tests the ADC scan in adc.c: the control register values, the
+ *  timing of the triggered current samples against the PWM pulse, and the filters 
+ *  against a reference written in floating point.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "adc.h"
+#include "task_motors.h"
+#include "test.h"
+
+ISR(ADC_vect);
+
+/// The channel of each slot of the scan, and how the Makefile set each one's filters.
+static const uint8_t channels[ADC_SCAN_LENGTH] = ADC_SCAN_LIST;
+static const adc_filter_config configs[ADC_SCAN_LENGTH] = ADC_FILTER_LIST;
+
+// The ADC ISR feeds the trips and the thermal model, which aren't tested here.
+uint16_t trip_current(uint8_t adc_channel, uint16_t reading){ return 0; }
+void thermal_current(uint8_t adc_channel, uint16_t reading){}
+
+/// The motors whose duty cycles the current samples are checked against.
+const motor_axis motor_axes[MOTOR_NUM_AXES] PROGMEM =
+{
+	{ .ocr = &OCR1A, .current = ADC_CURRENT_M1 },
+	{ .ocr = &OCR1B, .current = ADC_CURRENT_M2 }
+};
+
+/// Current sense readings in the on-time and the off-time of the PWM pulse, of motor
+/// 1 and 2, and the joystick readings.
+#define ON_M1 600
+#define OFF_M1 100
+#define ON_M2 800
+#define OFF_M2 150
+#define JOYSTICK_X 300
+#define JOYSTICK_Y 700
+
+/// Phase of the ADC clock against the PWM period, in us; it runs on its own prescaler.
+#define ADC_CLOCK_PHASE 5
+
+//-------------------------------------------------------------------------------------
+/** \brief This function gives the voltage on an ADC input at a time.
+ *  @param channel The ADC channel.
+ *  @param time The time in us from the start of the first PWM period.
+ *  @return The reading the ADC would give.
+ */
+static uint16_t input(uint8_t channel, uint32_t time){
+	uint16_t phase = time % 512;
+	switch(channel)
+	{
+		case ADC_CURRENT_M1:
+			return (phase < OCR1A/2) ? ON_M1 : OFF_M1;
+		case ADC_CURRENT_M2:
+			return (phase < OCR1B/2) ? ON_M2 : OFF_M2;
+		case ADC_JOYSTICK_X:
+			return JOYSTICK_X;
+		default:
+			return JOYSTICK_Y;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the ADC as the ATmega1284P datasheet times it, in steps 
+ *  of 1 us, over whole PWM periods. A conversion starts on the ADC clock after its
+ *  start bit is set or, in auto trigger mode, after the Timer 1 overflow. It samples 
+ *  1.5 ADC clocks later when started by its bit and 2 when triggered, and the ISR 
+ *  runs when it is done, 13 or 13.5 ADC clocks after the start.
+ *  @param periods The number of PWM periods to run.
+ *  @param off_time Set to the number of current samples taken after the PWM pulse.
+ *  @return The number of conversions.
+ */
+static uint32_t run_adc(uint16_t periods, uint32_t *off_time){
+	static uint32_t time = 0;
+	uint32_t done = 0;
+	uint32_t sample = 0;
+	uint8_t busy = 0;
+	uint8_t pending = 0;
+	uint8_t channel = 0;
+	uint32_t conversions = 0;
+	*off_time = 0;
+	for(uint32_t end = time + 512UL*periods; time < end; time++)
+	{
+		// An overflow or the start bit asks for a conversion, which waits for the 
+		// next edge of the ADC clock.
+		if(!busy && !pending 
+		   && ((time % 512 == 0 && (ADCSRA & (1<<ADATE))) || (ADCSRA & (1<<ADSC))))
+		{
+			pending = 1 + !(ADCSRA & (1<<ADSC));
+			ADCSRA |= (1<<ADSC);
+		}
+		if(pending && (time - ADC_CLOCK_PHASE) % 8 == 0)
+		{
+			channel = ADMUX & 0x07;
+			sample = time + ((pending == 2) ? 16 : 12);
+			done = time + ((pending == 2) ? 108 : 104);
+			busy = 1;
+			pending = 0;
+		}
+		if(busy && time == done)
+		{
+			ADC = input(channel, sample);
+			if((channel == ADC_CURRENT_M1 || channel == ADC_CURRENT_M2) 
+			   && (ADC == OFF_M1 || ADC == OFF_M2))
+			{
+				(*off_time)++;
+			}
+			busy = 0;
+			ADCSRA &= ~(1<<ADSC);
+			conversions++;
+			ADC_vect();
+		}
+	}
+	return conversions;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the ADC with both motors at one duty cycle, and checks
+ *  what the triggered current samples hold.
+ *  @param duty The duty cycle, in Timer 1 counts of 1023.
+ *  @param expect_m1 The reading every sample of motor 1 should hold.
+ *  @param expect_m2 The reading every sample of motor 2 should hold.
+ */
+static void check_duty(uint16_t duty, uint16_t expect_m1, uint16_t expect_m2){
+	OCR1A = OCR1B = duty;
+	adc_reset_stats();
+	uint32_t off_time;
+	uint32_t conversions = run_adc(200, &off_time);
+	adc_stats stats;
+	adc_get_stats(&stats);
+
+	uint16_t samples[ADC_SAMPLE_BUFFER_SIZE];
+	uint16_t wrong = 0;
+	uint8_t count = adc_read_samples(ADC_CURRENT_M1, samples, ADC_SAMPLE_BUFFER_SIZE);
+	for(uint8_t sample = 0; sample < count; sample++)
+	{
+		wrong += (samples[sample] != expect_m1);
+	}
+	count = adc_read_samples(ADC_CURRENT_M2, samples, ADC_SAMPLE_BUFFER_SIZE);
+	for(uint8_t sample = 0; sample < count; sample++)
+	{
+		wrong += (samples[sample] != expect_m2);
+	}
+	printf("  duty %4u counts, %5.1f us: %lu conversions, %3lu of 200 current samples "
+	       "in the off-time, %3lu held, %u of the last %u wrong\n", duty, duty/2.0,
+	       (unsigned long)conversions, (unsigned long)off_time, 
+	       (unsigned long)stats.held, wrong, 2*ADC_SAMPLE_BUFFER_SIZE);
+	CHECK(conversions == 400, "duty %u: %lu conversions in 200 periods", duty,
+	      (unsigned long)conversions);
+	CHECK(wrong == 0, "duty %u: %u current samples wrong", duty, wrong);
+	CHECK(adc_read(ADC_JOYSTICK_X) == JOYSTICK_X && adc_read(ADC_JOYSTICK_Y) == JOYSTICK_Y,
+	      "duty %u: joystick read %u, %u", duty, adc_read(ADC_JOYSTICK_X), 
+	      adc_read(ADC_JOYSTICK_Y));
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one pass of the scan through the ADC ISR, giving one 
+ *  slot a reading and the others 0.
+ *  @param slot The slot to give the reading.
+ *  @param reading The 10-bit reading.
+ */
+static void convert(uint8_t slot, uint16_t reading){
+	for(uint8_t next = 0; next < ADC_SCAN_LENGTH; next++)
+	{
+		ADC = (next == slot) ? reading : 0;
+		ADC_vect();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function checks that oversampling a slot resolves every fraction of a
+ *  count it should. Each decimated reading is made of readings of v and v + 1 whose 
+ *  mean is v + j/2^n, which 2^n*4^n readings would need to show with n extra bits.
+ *  @param slot The slot to test.
+ *  @param base The reading v.
+ *  @return The number of fractions which came out wrong.
+ */
+static uint16_t check_bits(uint8_t slot, uint16_t base){
+	const adc_filter_config *config = &configs[slot];
+	uint16_t readings = 1U << (2*config->oversample);
+	uint16_t steps = 1U << config->oversample;
+	uint16_t wrong = 0;
+	for(uint16_t step = 0; step < steps; step++)
+	{
+		adc_init();
+		for(uint16_t window = 0; window < (1U << config->window); window++)
+		{
+			for(uint16_t reading = 0; reading < readings; reading++)
+			{
+				convert(slot, base + (reading < step*steps));
+			}
+		}
+		adc_filtered out;
+		adc_read_filtered(channels[slot], &out);
+		uint16_t expect = (uint16_t)((base + (double)step/steps)*ADC_FILTER_SCALE);
+		if(out.mean != expect || out.min != expect || out.max != expect)
+		{
+			wrong++;
+		}
+		if(config->iir == 0 && out.value != expect)
+		{
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function steps the input of a slot and compares the low pass with 
+ *  y += (x - y)/2^k worked out in floating point on the same decimated readings.
+ *  @param slot The slot to test.
+ *  @param from The reading before the step, which the filter starts from.
+ *  @param to The reading after it.
+ *  @param rise Set to the number of decimated readings the output took to cover 63%
+ *  of the step, which should be 2^k.
+ *  @return The largest difference from the reference, in 1/ADC_FILTER_SCALE counts.
+ */
+static double check_step(uint8_t slot, uint16_t from, uint16_t to, uint16_t *rise){
+	const adc_filter_config *config = &configs[slot];
+	uint16_t readings = 1U << (2*config->oversample);
+	adc_init();
+	double reference = from*(double)ADC_FILTER_SCALE;
+	double error = 0;
+	*rise = 0;
+	for(uint16_t output = 0; output < 40U << config->iir; output++)
+	{
+		uint16_t input = (output < 8) ? from : to;
+		for(uint16_t reading = 0; reading < readings; reading++)
+		{
+			convert(slot, input);
+		}
+		reference += (input*(double)ADC_FILTER_SCALE - reference)/(1U << config->iir);
+		adc_filtered out;
+		adc_read_filtered(channels[slot], &out);
+		error = fmax(error, fabs(out.value - reference));
+		if(*rise == 0 && fabs(out.value - from*(double)ADC_FILTER_SCALE) 
+		   >= 0.632*fabs((double)to - from)*ADC_FILTER_SCALE)
+		{
+			*rise = output - 7;
+		}
+	}
+	return error;
+}
+
+int main(void){
+	// The register values, and what adc_init() writes
+	adc_registers regs;
+	adc_make_registers(&regs, ADC_CURRENT_M1, 1);
+	CHECK(regs.admux == 0x44 && regs.adcsra == 0xAF && regs.adcsrb == 0x06,
+	      "triggered: ADMUX %02X ADCSRA %02X ADCSRB %02X", regs.admux, regs.adcsra,
+	      regs.adcsrb);
+	adc_make_registers(&regs, ADC_JOYSTICK_X, 0);
+	CHECK(regs.admux == 0x47 && regs.adcsra == 0xEF && regs.adcsrb == 0x06,
+	      "started: ADMUX %02X ADCSRA %02X ADCSRB %02X", regs.admux, regs.adcsra,
+	      regs.adcsrb);
+	ADCSRB = 0xF8;
+	adc_init();
+	CHECK(ADMUX == 0x44 && ADCSRA == 0xAF && ADCSRB == 0xFE, 
+	      "adc_init: ADMUX %02X ADCSRA %02X ADCSRB %02X", ADMUX, ADCSRA, ADCSRB);
+	ADCSRB = 0;
+
+	// Current samples against the PWM pulse, from long pulses down to none. Pulses
+	// shorter than ADC_SAMPLE_MIN_OCR keep the last reading from a longer one.
+	printf("current samples, triggered at the Timer 1 overflow, %u counts needed:\n",
+	       ADC_SAMPLE_MIN_OCR);
+	check_duty(800, ON_M1, ON_M2);
+	check_duty(ADC_SAMPLE_MIN_OCR, ON_M1, ON_M2);
+	check_duty(40, ON_M1, ON_M2);
+	check_duty(ADC_SAMPLE_MIN_OCR - 1, ON_M1, ON_M2);
+	check_duty(1, ON_M1, ON_M2);
+	check_duty(0, 0, 0);
+
+	// The filters, with the motors on for the whole period
+	OCR1A = OCR1B = 1023;
+	for(uint8_t slot = 0; slot < ADC_SCAN_LENGTH; slot++)
+	{
+		const adc_filter_config *config = &configs[slot];
+		printf("slot %u, oversample %u, low pass 2^%u, window 2^%u:\n", slot, 
+		       config->oversample, config->iir, config->window);
+
+		// Extra bits, in the middle and at both ends of the range
+		uint16_t wrong = check_bits(slot, 0) + check_bits(slot, 511) 
+		                 + check_bits(slot, 1022);
+		printf("  %u extra bits: %u fractions of a count resolved, %u wrong\n",
+		       config->oversample, 3U << config->oversample, wrong);
+		CHECK(wrong == 0, "slot %u: %u fractions wrong", slot, wrong);
+
+		// A full scale reading must not overflow the 16-bit outputs.
+		adc_init();
+		for(uint16_t reading = 0; reading < (64U << config->oversample); reading++)
+		{
+			convert(slot, 1023);
+		}
+		adc_filtered out;
+		adc_read_filtered(channels[slot], &out);
+		CHECK(out.value == 1023*ADC_FILTER_SCALE && out.max == 1023*ADC_FILTER_SCALE,
+		      "slot %u: full scale gave %u", slot, out.value);
+
+		// Steps up and down the whole range, and a small one
+		uint16_t rise_up, rise_down, rise_small;
+		double error = fmax(check_step(slot, 0, 1023, &rise_up), 
+		                    check_step(slot, 1023, 0, &rise_down));
+		error = fmax(error, check_step(slot, 500, 510, &rise_small));
+		printf("  step response: 63%% after %u, %u, %u decimated readings, "
+		       "at most %.2f/%u counts from the reference\n", rise_up, rise_down, 
+		       rise_small, error, ADC_FILTER_SCALE);
+		CHECK(error < 1.0, "slot %u: %.2f/%u counts from the reference", slot, error,
+		      ADC_FILTER_SCALE);
+		CHECK(abs(rise_up - (1 << config->iir)) <= 1 || config->iir == 0, 
+		      "slot %u: rise took %u readings", slot, rise_up);
+	}
+
+	return TEST_RESULT("test_adc");
+}
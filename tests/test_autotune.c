@@ -0,0 +1,256 @@
+//*************************************************************************************
+/** \file test_autotune.c
+ *  \brief This file runs the relay autotuner in autotune.c against simulated motors:
+ *  whether it measures each of them, how the gains it works out settle a step, and
+ *  how it stops on an axis which does not move or runs away.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <string.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "pid.h"
+#include "autotune.h"
+#include "test.h"
+
+/// The control period the autotuner runs at, in us.
+#define PERIOD_US 1024
+
+/// Integration substeps of the simulated motor per control period.
+#define PLANT_SUBSTEPS 20
+
+/// Longest delay of the simulated motor's power, in control periods, plus one.
+#define DELAY_MAX 8
+
+/// Size of the step the tuned controller is tested with, and its settling band.
+#define STEP 300
+#define SETTLE_BAND 2
+
+/// A simulated motor: speed gain, speed time constant, delay and power limit.
+typedef struct
+{
+	const char *name;           ///< Printed with the results
+	double gain;                ///< Speed per unit of power, in counts/s
+	double tau;                 ///< Time constant of the speed, in s
+	uint8_t delay;              ///< Periods before the power takes effect
+	int16_t limit;              ///< Power limit of the axis
+} plant;
+
+/// The state of a simulated motor.
+typedef struct
+{
+	double position;            ///< In counts
+	double speed;               ///< In counts/s
+	int16_t pending[DELAY_MAX]; ///< Power waiting for the delay
+	uint32_t cycle;             ///< Control periods run
+} plant_state;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs a simulated motor for one control period.
+ *  @param p The motor.
+ *  @param s Its state.
+ *  @param power The power the controller put out this period.
+ */
+static void plant_step(const plant *p, plant_state *s, int16_t power){
+	const double dt = PERIOD_US*1e-6/PLANT_SUBSTEPS;
+	s->pending[(s->cycle + p->delay) % DELAY_MAX] = power;
+	int16_t applied = s->pending[s->cycle % DELAY_MAX];
+	for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+	{
+		s->speed += (p->gain*applied - s->speed)*dt/p->tau;
+		s->position += s->speed*dt;
+	}
+	s->cycle++;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns what the encoder of a simulated motor reads.
+ *  @param s The motor's state.
+ *  @return Its position in whole counts.
+ */
+static int32_t plant_encoder(const plant_state *s){
+	return (int32_t)floor(s->position);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs a relay experiment on a simulated motor until it stops.
+ *  @param p The motor.
+ *  @param at The experiment.
+ *  @param s Set to the motor's state at the end.
+ *  @return The time the experiment ran, in s.
+ */
+static double run_autotune(const plant *p, relay_autotune *at, plant_state *s){
+	memset(s, 0, sizeof(*s));
+	autotune_start(at, plant_encoder(s), p->limit >> AUTOTUNE_RELAY_SHIFT, PERIOD_US);
+	while(autotune_status(at) == AUTOTUNE_RUNNING)
+	{
+		plant_step(p, s, autotune_update(at, plant_encoder(s)));
+	}
+	return s->cycle*PERIOD_US*1e-6;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function tells whether proportional control with a given gain makes a
+ *  simulated motor oscillate without dying out, starting 50 counts off target.
+ *  @param p The motor.
+ *  @param gain The proportional gain, in power per count.
+ *  @return Nonzero if the oscillation late in the run is as large as early in it.
+ */
+static uint8_t unstable(const plant *p, double gain){
+	plant_state s;
+	memset(&s, 0, sizeof(s));
+	s.position = 50;
+	double early = 0;
+	double late = 0;
+	for(uint16_t cycle = 0; cycle < 30000; cycle++)
+	{
+		double power = fmax(fmin(-gain*plant_encoder(&s), p->limit), -p->limit);
+		plant_step(p, &s, (int16_t)power);
+		if(cycle > 2000 && cycle < 6000)
+		{
+			early = fmax(early, fabs(s.position));
+		}
+		if(cycle >= 26000)
+		{
+			late = fmax(late, fabs(s.position));
+		}
+	}
+	return late > 3 && late >= 0.9*early;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function finds the proportional gain at which a simulated motor starts
+ *  to oscillate, by bisection, to compare the ultimate gain of the experiment with.
+ *  @param p The motor.
+ *  @return The highest gain found stable, up to 1000.
+ */
+static double marginal_gain(const plant *p){
+	double low = 0.01;
+	double high = 1000;
+	for(uint8_t step = 0; step < 30; step++)
+	{
+		double middle = sqrt(low*high);
+		if(unstable(p, middle))
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle;
+		}
+	}
+	return low;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs a PI(D) controller with tuned gains on a simulated motor
+ *  after a step in its setpoint.
+ *  @param p The motor.
+ *  @param gains The gains from an experiment at the same period.
+ *  @param overshoot Set to the largest distance past the setpoint, in counts.
+ *  @param settle Set to the time after which the motor stays in the settling band.
+ *  @return The position at the end, in counts.
+ */
+static double run_step(const plant *p, const autotune_gains *gains, double *overshoot,
+                       double *settle){
+	pid_controller pid;
+	plant_state s;
+	pid_init(&pid, gains->k_prop, gains->k_int, gains->k_der, p->limit, p->limit,
+	         PERIOD_US);
+	memset(&s, 0, sizeof(s));
+	*overshoot = 0;
+	*settle = 0;
+	for(uint16_t cycle = 0; cycle < 10000; cycle++)
+	{
+		plant_step(p, &s, pid_update(&pid, plant_encoder(&s), STEP));
+		*overshoot = fmax(*overshoot, s.position - STEP);
+		if(fabs(s.position - STEP) > SETTLE_BAND)
+		{
+			*settle = (cycle + 1)*PERIOD_US*1e-6;
+		}
+	}
+	return s.position;
+}
+
+int main(void){
+	const plant plants[] = {
+		{"slow", 5, 0.05, 1, 350},
+		{"nominal", 10, 0.05, 1, 350},
+		{"fast", 20, 0.02, 1, 350},
+		{"heavy, 3 period delay", 10, 0.1, 3, 350},
+		{"motor 1 limit", 10, 0.05, 1, 150},
+		{"geared", 2, 0.2, 2, 350}};
+	relay_autotune at;
+	plant_state s;
+	autotune_gains gains;
+
+	printf("relay experiment, then a %d count step with the tuned PI gains:\n"
+	       "  plant                  time s      Ku  marginal     Tu s      kp       ki"
+	       "  overshoot settle s\n", STEP);
+	for(uint8_t n = 0; n < sizeof(plants)/sizeof(plants[0]); n++)
+	{
+		const plant *p = &plants[n];
+		double time = run_autotune(p, &at, &s);
+		uint8_t status = autotune_gains_get(&at, &gains);
+		double marginal = marginal_gain(p);
+		CHECK(status == AUTOTUNE_DONE, "%s: status %u", p->name, status);
+		if(status != AUTOTUNE_DONE)
+		{
+			continue;
+		}
+		double overshoot, settle;
+		double final = run_step(p, &gains, &overshoot, &settle);
+		printf("  %-22s %6.2f %7.2f %9.2f %8.3f %7.3f %8.5f %10.1f %8.2f\n", p->name,
+		       time, gains.k_ultimate, marginal, gains.t_ultimate, gains.k_prop, 
+		       gains.k_int, overshoot, settle);
+
+		// The relay's hysteresis adds lag, so the ultimate gain it measures is below
+		// the gain at which the motor really goes unstable, and the gains are safe.
+		CHECK(gains.k_ultimate > 0 && gains.k_ultimate < marginal,
+		      "%s: Ku %.2f, unstable above %.2f", p->name, gains.k_ultimate, marginal);
+		CHECK(gains.k_prop < marginal, "%s: kp %.2f", p->name, gains.k_prop);
+		CHECK(settle < 4.0 && fabs(final - STEP) <= SETTLE_BAND,
+		      "%s: settled after %.2f s at %.1f", p->name, settle, final);
+	}
+
+	// An axis which doesn't move never completes a cycle, and is left unpowered
+	const plant stuck = {"stuck", 0, 0.05, 1, 350};
+	double time = run_autotune(&stuck, &at, &s);
+	int16_t output = autotune_update(&at, plant_encoder(&s));
+	printf("stuck axis: status %u after %.2f s, output then %d\n", autotune_status(&at),
+	       time, output);
+	CHECK(autotune_status(&at) == AUTOTUNE_TIMED_OUT && output == 0,
+	      "stuck axis: status %u, output %d", autotune_status(&at), output);
+	CHECK(fabs(time - AUTOTUNE_TIMEOUT_S) < 0.01, "stuck axis: stopped after %.2f s", time);
+
+	// An axis wired with the wrong sign runs away from the relay, and is stopped
+	const plant reversed = {"wrong sign", -10, 0.05, 1, 350};
+	time = run_autotune(&reversed, &at, &s);
+	output = autotune_update(&at, plant_encoder(&s));
+	printf("wrong-sign axis: status %u after %.2f s at %.0f counts, output then %d\n",
+	       autotune_status(&at), time, s.position, output);
+	CHECK(autotune_status(&at) == AUTOTUNE_RUNAWAY && output == 0,
+	      "wrong-sign axis: status %u, output %d", autotune_status(&at), output);
+	CHECK(fabs(s.position) < AUTOTUNE_EXCURSION_MAX + 10, 
+	      "wrong-sign axis: stopped at %.0f counts", s.position);
+
+	return TEST_RESULT("test_autotune");
+}
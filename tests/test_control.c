@@ -0,0 +1,161 @@
+//*************************************************************************************
+/** \file test_control.c
+ *  \brief This file tests the control executive in control.c: its divider, its 
+ *  timing statistics, and the interrupt masks it holds while the axes update.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "thermal.h"
+#include "trip.h"
+#include "friction.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "control.h"
+#include "test.h"
+
+ISR(TIMER1_OVF_vect);
+
+uint8_t state_SHARED;
+static uint16_t fault_posts;
+
+void master_post_fault(uint16_t cause){ fault_posts++; }
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){ fault_posts++; return 0; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// What the interrupt masks were while the axis updates ran, seen from adc_read().
+static uint8_t seen_sreg, seen_timsk1, seen_timsk3;
+
+/// A nested interrupt to simulate during the next axis update, if set.
+static void (*nested)(void);
+
+//-------------------------------------------------------------------------------------
+/** \brief This function stands in for the ADC driver. The supervisor reads the motor
+ *  current each cycle from the middle of the axis updates, so this also records the
+ *  interrupt masks there and runs the simulated nested interrupt.
+ */
+uint16_t adc_read(uint8_t adc_channel){
+	seen_sreg = SREG;
+	seen_timsk1 = TIMSK1;
+	seen_timsk3 = TIMSK3;
+	if(nested)
+	{
+		nested();
+		nested = 0;
+	}
+	return 0;
+}
+
+/// An overflow of Timer 1 while the cycle runs, which stays pending.
+static void overflow(void){
+	TIFR1 |= (1<<TOV1);
+}
+
+/// An overcurrent trip from the ADC ISR while the cycle runs.
+static void overcurrent(void){
+	for(uint8_t sample = 0; sample < TRIP_CURRENT_SAMPLES; sample++)
+	{
+		trip_current(ADC_CURRENT_M1, 1023);
+	}
+}
+
+int main(void){
+	motors_init();
+	PINB = 0xFF;
+	PINC = 0xFF;
+	trip_init();
+	thermal_init();
+	control_init();
+	TIMSK3 = (1<<OCIE3A);
+	SREG = 0;
+	state_SHARED = TRACK_TARG;
+
+	// One cycle per CONTROL_PWM_DIVIDER overflows
+	control_stats stats;
+	for(uint8_t overflows = 0; overflows < 10*CONTROL_PWM_DIVIDER; overflows++)
+	{
+		TIMER1_OVF_vect();
+	}
+	control_get_stats(&stats);
+	CHECK(stats.cycles == 10, "%lu cycles in %u overflows", (unsigned long)stats.cycles,
+	      10*CONTROL_PWM_DIVIDER);
+	printf("control cycle every %u PWM periods: %lu us, %.1f Hz\n", CONTROL_PWM_DIVIDER,
+	       (unsigned long)CONTROL_PERIOD_US, 1e6/CONTROL_PERIOD_US);
+
+	// While the axes update, interrupts are on but this overflow and the RTOS tick
+	// are masked; afterwards both are unmasked and interrupts are off for the return.
+	CHECK(seen_sreg & 0x80, "interrupts were off during the axis updates");
+	CHECK(!(seen_timsk1 & (1<<TOIE1)), "the overflow was unmasked during the updates");
+	CHECK(!(seen_timsk3 & (1<<OCIE3A)), "the RTOS tick was unmasked during the updates");
+	CHECK(TIMSK1 & (1<<TOIE1), "the overflow was left masked");
+	CHECK(TIMSK3 & (1<<OCIE3A), "the RTOS tick was left masked");
+	CHECK(!(SREG & 0x80), "the ISR returned with interrupts on");
+
+	// A cycle long enough for the next overflow to come adds a PWM period to the run
+	// time, which would otherwise wrap at 0x3FF.
+	control_reset_stats();
+	nested = overflow;
+	for(uint8_t overflows = 0; overflows < CONTROL_PWM_DIVIDER; overflows++)
+	{
+		TIMER1_OVF_vect();
+	}
+	TIFR1 = 0;
+	control_get_stats(&stats);
+	CHECK(stats.run_time_max >= 0x0400, "an overrun gave run_time_max %u", 
+	      stats.run_time_max);
+
+	// A trip by the ADC ISR in the middle of the updates leaves the PWM off.
+	nested = overcurrent;
+	for(uint8_t overflows = 0; overflows < CONTROL_PWM_DIVIDER; overflows++)
+	{
+		TIMER1_OVF_vect();
+	}
+	CHECK(safety_error_SHARED & TRIP_OVERCURRENT_M1, "the nested trip was not latched");
+	CHECK(!(TCCR1A & ((1<<COM1A1)|(1<<COM1B1))) && OCR1A == 0 && OCR1B == 0,
+	      "the cycle turned the PWM back on after a nested trip");
+
+	// The outcome of the breakaway calibration outlives the autotune which ran it. The
+	// axes here never move, so each ramps to its power limit and is found stuck.
+	state_SHARED = AUTOTUNE;
+	int16_t breakaway_pos, breakaway_neg;
+	for(uint32_t overflows = 0; overflows < 40000UL*CONTROL_PWM_DIVIDER; overflows++)
+	{
+		TIMER1_OVF_vect();
+	}
+	state_SHARED = TRACK_TARG;
+	for(uint8_t overflows = 0; overflows < CONTROL_PWM_DIVIDER; overflows++)
+	{
+		TIMER1_OVF_vect();
+	}
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		uint8_t status = control_get_friction(axis, &breakaway_pos, &breakaway_neg);
+		CHECK(status == FRICTION_CAL_STUCK, "axis %u: calibration status %u after the "
+		      "autotune", axis, status);
+	}
+
+	return TEST_RESULT("test_control");
+}
@@ -0,0 +1,231 @@
+//*************************************************************************************
+/** \file test_debounce.c
+ *  \brief This file tests the switch debouncer in debounce.c, and how task_sensors.c
+ *  passes the edges on: the button, the stow request and the autotune request as 
+ *  events to the master, the limit switches and the emergency stop as latched faults.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "timestamp.h"
+#include "debounce.h"
+#include "task_sensors.h"
+#include "task_master.h"
+#include "safety_log.h"
+#include "trip.h"
+#include "test.h"
+
+/// Number of presses and releases with random bounce, and the longest bounce, in ticks.
+#define TRIALS 1000
+#define BOUNCE_TICKS_MAX 5
+
+/// Ticks it takes to accept an edge: 4 samples in a row, one every DEBOUNCE_TICK_DIVIDER.
+#define ACCEPT_TICKS (4*DEBOUNCE_TICK_DIVIDER)
+
+// The state and joystick readings which task_master.c and task_motors.c own.
+uint8_t state_SHARED;
+int16_t motor1_power_SHARED;
+int16_t motor2_power_SHARED;
+
+/// What the spies below were last called with, and how often.
+static uint8_t posted_event;
+static uint32_t posted_time;
+static uint16_t posts;
+static uint16_t tripped_faults;
+static uint32_t tripped_tick;
+static uint16_t trips;
+static uint8_t logged_cause;
+static uint16_t logs;
+
+void master_post(uint8_t event){ posted_event = event; posts++; }
+signed portBASE_TYPE master_post_stamped_from_ISR(uint8_t event, uint32_t time)
+{
+	posted_event = event;
+	posted_time = time;
+	posts++;
+	return pdFALSE;
+}
+uint8_t trip_fault_from_ISR(uint16_t faults)
+{
+	tripped_faults = faults;
+	tripped_tick = stub_tick_count;
+	trips++;
+	return 1;
+}
+void safety_log_post_from_ISR(uint8_t cause, uint32_t time){ logged_cause = cause; logs++; }
+uint16_t adc_read(uint8_t adc_channel){ return 512; }
+void vTaskDelayUntil(portTickType *previous_wake, portTickType period){}
+
+/// The edges the test's own subscriber saw.
+static debounce_event seen[8];
+static uint8_t seen_count;
+
+static void record(const debounce_event *event){
+	if(seen_count < 8)
+	{
+		seen[seen_count] = *event;
+	}
+	seen_count++;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one RTOS tick, with the time stamp at its start.
+ */
+static void tick(void){
+	stub_tick_count++;
+	TCNT3 = 0;
+	debounce_tick();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets one switch input and runs the ticks it takes to accept it.
+ *  @param pin The PINx register of the input.
+ *  @param bit Its bit.
+ *  @param closed Nonzero to close the switch, which pulls the pin low.
+ */
+static void set_switch(volatile uint8_t *pin, uint8_t bit, uint8_t closed){
+	*pin = closed ? (*pin & ~(1 << bit)) : (*pin | (1 << bit));
+	for(uint8_t ticks = 0; ticks < 2*ACCEPT_TICKS; ticks++)
+	{
+		tick();
+	}
+}
+
+int main(void){
+	PINC = 0xFF;
+	PIND = 0xFF;
+	debounce_init();
+	debounce_subscribe(1U << DEBOUNCE_BUTTON, record);
+
+	// The button closes at a random point in a tick, bounces for up to 5 ms, and gives
+	// exactly one edge, accepted ACCEPT_TICKS after the bouncing stops at the latest.
+	srand(1);
+	uint16_t wrong = 0;
+	double latency_sum = 0;
+	uint32_t latency_max = 0;
+	uint32_t settle_max = 0;
+	for(uint16_t trial = 0; trial < TRIALS; trial++)
+	{
+		uint8_t closing = !(trial & 1);
+		uint32_t contact = stub_tick_count + 1 + rand() % 4;
+		uint32_t settled = contact + rand() % (BOUNCE_TICKS_MAX + 1);
+		seen_count = 0;
+		for(uint8_t ticks = 0; ticks < 40; ticks++)
+		{
+			uint32_t now = stub_tick_count + 1;
+			uint8_t closed = (now < contact) ? !closing 
+			                 : (now >= settled) ? closing 
+			                 : (rand() & 1);
+			PINC = closed ? (0xFF & ~(1 << PC3)) : 0xFF;
+			tick();
+		}
+		if(seen_count != 1 || seen[0].active != closing)
+		{
+			wrong++;
+			continue;
+		}
+		uint32_t accepted = seen[0].time/TIMESTAMP_COUNTS_PER_TICK;
+		latency_sum += accepted - contact;
+		latency_max = (accepted - contact > latency_max) ? accepted - contact : latency_max;
+		settle_max = (accepted - settled > settle_max) ? accepted - settled : settle_max;
+	}
+	printf("%u presses and releases with up to %u ms of bounce: %u with wrong edges, "
+	       "accepted %.2f ms after first contact on average, %lu ms at most, %lu ms "
+	       "after the bouncing stopped\n", TRIALS, BOUNCE_TICKS_MAX, wrong, 
+	       latency_sum/(TRIALS - wrong), (unsigned long)latency_max, 
+	       (unsigned long)settle_max);
+	CHECK(wrong == 0, "%u trials gave the wrong edges", wrong);
+	CHECK(settle_max <= ACCEPT_TICKS, "accepted %lu ms after the bouncing stopped",
+	      (unsigned long)settle_max);
+
+	// A glitch shorter than 4 samples is no edge.
+	seen_count = 0;
+	for(uint8_t samples = 1; samples < 4; samples++)
+	{
+		PINC = 0xFF & ~(1 << PC3);
+		for(uint8_t ticks = 0; ticks < samples*DEBOUNCE_TICK_DIVIDER; ticks++)
+		{
+			tick();
+		}
+		set_switch(&PINC, PC3, 0);
+	}
+	CHECK(seen_count == 0, "glitches of 1 to 3 samples gave %u edges", seen_count);
+
+	// Through task_sensors: the button, stow request and autotune request are posted
+	// as events...
+	debounce_init();
+	button_init();
+	set_switch(&PINC, PC3, 1);
+	CHECK(posts == 1 && posted_event == MASTER_EVENT_BUTTON_PRESS && btn_SHARED,
+	      "button press: %u posts, event %u", posts, posted_event);
+	set_switch(&PINC, PC3, 0);
+	CHECK(posts == 2 && posted_event == MASTER_EVENT_BUTTON_RELEASE && !btn_SHARED,
+	      "button release: %u posts, event %u", posts, posted_event);
+	set_switch(&PIND, PD3, 1);
+	CHECK(posts == 3 && posted_event == MASTER_EVENT_STOW && trips == 0,
+	      "stow request: %u posts, event %u, %u trips", posts, posted_event, trips);
+	CHECK(logs == 1 && logged_cause == SAFETY_CAUSE_STOW, "stow request: %u logged, "
+	      "cause %u", logs, logged_cause);
+	set_switch(&PIND, PD3, 0);
+	CHECK(posts == 4 && posted_event == MASTER_EVENT_STOW_END && logs == 1,
+	      "end of the stow request: %u posts, event %u, %u logged", posts, posted_event,
+	      logs);
+	set_switch(&PIND, PD6, 1);
+	CHECK(posts == 5 && posted_event == MASTER_EVENT_AUTOTUNE,
+	      "autotune request: %u posts, event %u", posts, posted_event);
+	set_switch(&PIND, PD6, 0);
+	CHECK(posts == 5, "end of the autotune request was posted");
+
+	// ...while the limit switches and the emergency stop latch faults, within the 
+	// ticks it takes to accept them; trip.c posts and logs those.
+	const struct { volatile uint8_t *pin; uint8_t bit; uint16_t fault; const char *name; }
+	faults[] = 
+	{
+		{ &PINC, PC2, TRIP_LIMIT, "limit switch 1" },
+		{ &PINC, PC7, TRIP_LIMIT, "limit switch 2" },
+		{ &PIND, PD2, TRIP_ESTOP, "emergency stop" }
+	};
+	for(uint8_t input = 0; input < 3; input++)
+	{
+		uint16_t posts_before = posts;
+		uint16_t trips_before = trips;
+		uint32_t closed = stub_tick_count;
+		set_switch(faults[input].pin, faults[input].bit, 1);
+		printf("%s: fault %03X latched %lu ms after it closed\n", faults[input].name,
+		       tripped_faults, (unsigned long)(tripped_tick - closed));
+		CHECK(trips == trips_before + 1 && tripped_faults == faults[input].fault,
+		      "%s: %u trips, faults %03X", faults[input].name, trips - trips_before,
+		      tripped_faults);
+		CHECK(tripped_tick - closed <= ACCEPT_TICKS, "%s: latched after %lu ms", 
+		      faults[input].name, (unsigned long)(tripped_tick - closed));
+		CHECK(posts == posts_before && logs == 1, "%s: posted or logged by itself",
+		      faults[input].name);
+		set_switch(faults[input].pin, faults[input].bit, 0);
+		CHECK(trips == trips_before + 1, "%s: opening it tripped", faults[input].name);
+	}
+
+	return TEST_RESULT("test_debounce");
+}
@@ -0,0 +1,239 @@
+//*************************************************************************************
+/** \file test_encoder.c
+ *  \brief This file tests the quadrature decoder in encoder.c against the decoder it
+ *  replaced, for every pair of line states, and compares their run times. It also
+ *  reads the positions while a timer signal runs the encoder ISR, as the tasks do.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "encoder.h"
+#include "test.h"
+
+ISR(PCINT0_vect);
+
+/// Positions and error counts kept by the reference decoder, as in the old main.c.
+static volatile int16_t ref_position[ENC_NUM_AXES];
+static volatile uint16_t ref_errors[ENC_NUM_AXES];
+static uint8_t ref_previous[ENC_NUM_AXES];
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the encoder ISR which encoder.c replaced, for one axis.
+ *  \details It searches the Gray sequence for the new state, then compares the 
+ *  previous state with its neighbours.
+ *  @param axis The axis to decode.
+ *  @param state The two lines of the axis, (B<<1)|A.
+ */
+static void ref_decode(uint8_t axis, uint8_t state){
+	const uint8_t sequence[6] = {3,2,0,1,3,2};
+	for (uint8_t i = 1; i < 5; i++)
+	{
+		if (state == sequence[i])
+		{
+			if (ref_previous[axis] == sequence[i-1])
+			{
+				ref_position[axis] = ref_position[axis] - 1;
+			}
+			else if (ref_previous[axis] == sequence[i+1])
+			{
+				ref_position[axis] = ref_position[axis] + 1;
+			}
+			else if (ref_previous[axis] != sequence[i])
+			{
+				ref_errors[axis]++;
+			}
+			break;
+		}
+	}
+	ref_previous[axis] = state;
+}
+
+/// Runs the reference decoder on a reading of port A, like the old ISR.
+static void ref_isr(uint8_t pins){
+	for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+	{
+		ref_decode(axis, (pins >> (2*axis)) & 0x03);
+	}
+}
+
+/// Steps run by the signal handler, and the one to stop at. Each step moves axis 0 
+/// down one count and axis 1 up one; more than 32768 wrap the 16-bit sequence counter.
+#define SNAPSHOT_STEPS 40000UL
+static volatile uint32_t snapshot_steps;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the timer signal handler, which stands in for encoder 
+ *  edges: each run it moves the lines one step and runs the encoder ISR, which can
+ *  so interrupt a reader anywhere.
+ *  @param signal Not used.
+ */
+static void snapshot_edge(int signal){
+	static const uint8_t gray[4] = {0, 1, 3, 2};
+	if(snapshot_steps < SNAPSHOT_STEPS)
+	{
+		uint32_t step = snapshot_steps + 1;
+		PINA = gray[step & 3] | (gray[-step & 3] << 2);
+		PCINT0_vect();
+		snapshot_steps = step;
+	}
+}
+
+int main(void){
+	// Every previous and current state of the lines, 256 pairs with two axes.
+	uint16_t pairs = 0;
+	for(uint8_t previous = 0; previous <= ENC_PIN_MASK; previous++)
+	{
+		for(uint8_t current = 0; current <= ENC_PIN_MASK; current++)
+		{
+			PINA = previous;
+			encoders_init();
+			PINA = current;
+			PCINT0_vect();
+			uint8_t overspeed = encoder_get_overspeed();
+
+			for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+			{
+				ref_position[axis] = 0;
+				ref_errors[axis] = 0;
+				ref_previous[axis] = (previous >> (2*axis)) & 0x03;
+			}
+			ref_isr(current);
+
+			for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+			{
+				CHECK(encoder_get_position(axis) == ref_position[axis], 
+				      "%x->%x axis %u: position %ld, reference %d", previous, current,
+				      axis, (long)encoder_get_position(axis), ref_position[axis]);
+				CHECK(encoder_get_errors(axis) == ref_errors[axis], 
+				      "%x->%x axis %u: errors %u, reference %u", previous, current,
+				      axis, encoder_get_errors(axis), ref_errors[axis]);
+				CHECK(((overspeed >> axis) & 1) == ref_errors[axis], 
+				      "%x->%x axis %u: overspeed flag %u", previous, current, axis,
+				      (overspeed >> axis) & 1);
+			}
+			pairs++;
+		}
+	}
+	printf("decode: %u line state pairs agree with the old decoder\n", pairs);
+
+	// A long random walk through legal and illegal transitions.
+	srand(1);
+	PINA = 0;
+	encoders_init();
+	for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+	{
+		ref_position[axis] = 0;
+		ref_errors[axis] = 0;
+		ref_previous[axis] = 0;
+	}
+	static uint8_t walk[1<<20];
+	uint8_t lines = 0;
+	for(uint32_t n = 0; n < sizeof(walk); n++)
+	{
+		uint8_t axis = rand() % ENC_NUM_AXES;
+		uint8_t r = rand() % 64;
+		uint8_t change = (r == 0) ? 3 : ((r & 1) ? 1 : 2);
+		lines ^= change << (2*axis);
+		walk[n] = lines;
+	}
+	for(uint32_t n = 0; n < sizeof(walk); n++)
+	{
+		PINA = walk[n];
+		PCINT0_vect();
+		ref_isr(walk[n]);
+	}
+	for(uint8_t axis = 0; axis < ENC_NUM_AXES; axis++)
+	{
+		CHECK(encoder_get_position(axis) == (int16_t)ref_position[axis], 
+		      "walk axis %u: position %ld, reference %d", axis, 
+		      (long)encoder_get_position(axis), ref_position[axis]);
+		CHECK(encoder_get_errors(axis) == ref_errors[axis], 
+		      "walk axis %u: errors %u, reference %u", axis, encoder_get_errors(axis),
+		      ref_errors[axis]);
+	}
+
+	// Snapshots taken while the ISR runs from a timer signal. Each must be the position
+	// after one of the steps run between the start and the end of the read, on both
+	// axes, all through the wrap of the sequence counter.
+	PINA = 0;
+	encoders_init();
+	snapshot_steps = 0;
+	signal(SIGALRM, snapshot_edge);
+	struct itimerval interval = { {0, 20}, {0, 20} };
+	setitimer(ITIMER_REAL, &interval, NULL);
+	uint32_t reads = 0;
+	uint32_t wrong = 0;
+	while(snapshot_steps < SNAPSHOT_STEPS)
+	{
+		uint32_t before = snapshot_steps;
+		int32_t down = encoder_get_position(0);
+		int32_t up = encoder_get_position(1);
+		uint32_t after = snapshot_steps;
+		if(down > -(int32_t)before || down < -(int32_t)after 
+		   || up < (int32_t)before || up > (int32_t)after)
+		{
+			wrong++;
+		}
+		reads++;
+	}
+	struct itimerval stop = { {0, 0}, {0, 0} };
+	setitimer(ITIMER_REAL, &stop, NULL);
+	printf("snapshot: %lu reads during %lu ISR runs, %lu out of range, final %ld %ld\n",
+	       (unsigned long)reads, SNAPSHOT_STEPS, (unsigned long)wrong,
+	       (long)encoder_get_position(0), (long)encoder_get_position(1));
+	CHECK(wrong == 0, "%lu snapshots were not a position the ISR wrote", 
+	      (unsigned long)wrong);
+	CHECK(encoder_get_position(0) == -(int32_t)SNAPSHOT_STEPS 
+	      && encoder_get_position(1) == (int32_t)SNAPSHOT_STEPS, "positions %ld %ld",
+	      (long)encoder_get_position(0), (long)encoder_get_position(1));
+
+	// Run times of both decoders over the same walk. These are host times and only
+	// rank the two; the target cost is encoder_get_isr_count() times the cycles of
+	// one ISR run, taken on the ATmega1284P.
+	const int passes = 20;
+	double start = test_seconds();
+	for(int pass = 0; pass < passes; pass++)
+	{
+		for(uint32_t n = 0; n < sizeof(walk); n++)
+		{
+			PINA = walk[n];
+			PCINT0_vect();
+		}
+	}
+	double table_ns = (test_seconds() - start)*1e9/(passes*(double)sizeof(walk));
+	start = test_seconds();
+	for(int pass = 0; pass < passes; pass++)
+	{
+		for(uint32_t n = 0; n < sizeof(walk); n++)
+		{
+			ref_isr(walk[n]);
+		}
+	}
+	double search_ns = (test_seconds() - start)*1e9/(passes*(double)sizeof(walk));
+	printf("host time per ISR run: table %.1f ns, old sequence search %.1f ns\n", 
+	       table_ns, search_ns);
+
+	return TEST_RESULT("test_encoder");
+}
@@ -0,0 +1,296 @@
+//*************************************************************************************
+/** \file test_feedforward.c
+ *  \brief This file replays a full day of sun tracking on two simulated stick-slip axes,
+ *  one with the trajectory feedforward of control.c and one without, and reports the
+ *  tracking error of each.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "pid.h"
+#include "profile.h"
+#include "friction.h"
+#include "encoder.h"
+#include "timestamp.h"
+#include "task_motors.h"
+#include "task_safety.h"
+#include "thermal.h"
+#include "trip.h"
+#include "task_master.h"
+#include "control.h"
+#include "test.h"
+
+ISR(TIMER1_OVF_vect);
+ISR(PCINT0_vect);
+
+/// The replay: its start in hours after midnight, how long it runs and how long the
+/// axes take to lock on before the error counts, in s, and the command interval of 
+/// the orientation task, in s. The day runs from 6:00 to 18:00.
+#define REPLAY_START_H 6
+#define REPLAY_SECONDS ( 12*3600UL )
+#define REPLAY_SETTLE_SECONDS 600
+#define COMMAND_SECONDS 600
+
+/// Encoder counts per degree of azimuth, and the site's latitude and the sun's
+/// declination, in degrees.
+#define COUNTS_PER_DEGREE 200.0
+#define LATITUDE 35.0
+#define DECLINATION 20.0
+
+/// The simulated motors: speed per unit of power, in counts/s, time constant of the
+/// speed, in s, and the static and sliding friction of the stick-slip ones, in power
+/// counts. Axes 0 and 1 stick and slip, axes 2 and 3 have no friction; axes 0 and 2 
+/// have the feedforward, 1 and 3 don't.
+#define PLANT_GAIN 10.0
+#define PLANT_TAU 0.05
+#define PLANT_STATIC 40.0
+#define PLANT_SLIDING 30.0
+
+/// Substeps of the plant per PWM period, which set how finely edges are timed.
+#define PLANT_SUBSTEPS 2
+
+/// The breakaway power the stick-slip axes are compensated with.
+#define COMPENSATION 45
+
+#if MOTOR_NUM_AXES != 4
+	#error test_feedforward must be built with MOTOR_NUM_AXES=4
+#endif
+
+// The commands and joystick readings which task_motors.c and task_master.c own.
+uint8_t state_SHARED;
+int16_t motor1_power_SHARED;
+int16_t motor2_power_SHARED;
+int32_t position_cmd_SHARED[MOTOR_NUM_AXES];
+int32_t rate_cmd_SHARED[MOTOR_NUM_AXES];
+int32_t accel_cmd_SHARED[MOTOR_NUM_AXES];
+uint8_t setpoint_sequence_SHARED;
+int32_t position_targ_init_SHARED[MOTOR_NUM_AXES];
+
+/// An entry of motor_axes[] with the tuning of motor 2, its feedforward gains and its
+/// breakaway power.
+#define TEST_AXIS(n, k_ff_vel, k_ff_acc, breakaway) \
+	{ \
+		&PINB, 0, 0, &PINB, 0, &PIND, 0, &plant_ocr[n], 0, \
+		PWR_LIMIT_M2, PWR_PEAK_M2, n, ADC_CURRENT_M2, 0, +1, \
+		K_PROP_2, K_INT_2, K_DER_2, INT_CLAMP_2, OUT_CLAMP_2, \
+		PROFILE_VEL_MAX_2, PROFILE_ACC_MAX_2, PROFILE_JERK_MAX_2, \
+		k_ff_vel, k_ff_acc, \
+		breakaway, 0, \
+		THERMAL_CURRENT_M2, TRIP_CURRENT_M2, TRIP_OVERCURRENT_M2, TRIP_DRIVER_M2 \
+	}
+
+static volatile uint16_t plant_ocr[MOTOR_NUM_AXES];
+
+const motor_axis motor_axes[MOTOR_NUM_AXES] PROGMEM =
+{
+	TEST_AXIS(0, K_FF_VEL_2, K_FF_ACC_2, COMPENSATION),
+	TEST_AXIS(1, 0.0F, 0.0F, COMPENSATION),
+	TEST_AXIS(2, K_FF_VEL_2, K_FF_ACC_2, 0),
+	TEST_AXIS(3, 0.0F, 0.0F, 0)
+};
+
+/** This structure holds the state of one simulated motor, which stays put until the 
+ *  power is past its static friction, and then slows against its sliding friction 
+ *  until it stops again.
+ */
+typedef struct
+{
+	double static_friction;     ///< In power counts
+	double sliding_friction;    ///< In power counts
+	double position;            ///< In counts
+	double speed;               ///< In counts/s
+	uint8_t stuck;              ///< Nonzero while at rest
+	int32_t counts;             ///< Counts put out so far on the encoder lines
+	int16_t power;              ///< Power the driver was last given
+	uint8_t asleep;             ///< Nonzero while the driver's PWM is off
+} plant;
+
+static plant plants[MOTOR_NUM_AXES];
+static uint16_t trips;
+
+void motors_init(void){}
+void motor_get_axis(uint8_t axis, motor_axis *copy){ *copy = motor_axes[axis]; }
+void motor_power(uint8_t axis, int16_t power){ plants[axis].power = power; plants[axis].asleep = 0; }
+void motor_sleep(uint8_t axis){ plants[axis].power = 0; plants[axis].asleep = 1; }
+uint16_t adc_read(uint8_t adc_channel){ return 0; }
+uint8_t trip_fault_from_ISR(uint16_t faults){ trips++; return faults; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// The quadrature states in the order which counts up, (B<<1)|A.
+static const uint8_t up_sequence[4] = {0, 2, 3, 1};
+
+/// Sets the simulated clock which timestamp_now() reads, in time stamp counts.
+static void set_time(uint64_t counts){
+	stub_tick_count = counts/TIMESTAMP_COUNTS_PER_TICK;
+	TCNT3 = counts%TIMESTAMP_COUNTS_PER_TICK;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the azimuth of the sun, in degrees from south.
+ *  @param seconds The time, in s after midnight.
+ */
+static double azimuth(double seconds){
+	double latitude = LATITUDE*M_PI/180;
+	double declination = DECLINATION*M_PI/180;
+	double hour_angle = (seconds/3600 - 12)*15*M_PI/180;
+	return atan2(sin(hour_angle), cos(hour_angle)*sin(latitude) 
+	             - tan(declination)*cos(latitude))*180/M_PI;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs a simulated motor for one substep, and puts its turning
+ *  out on the encoder lines.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param dt The substep, in s.
+ */
+static void plant_step(uint8_t axis, double dt){
+	plant *p = &plants[axis];
+	int16_t power = p->power;
+	if(p->stuck && abs(power) > p->static_friction)
+	{
+		p->stuck = 0;
+	}
+	if(!p->stuck)
+	{
+		double drive = power - ((p->speed > 0) ? p->sliding_friction 
+		                                       : -p->sliding_friction);
+		double speed = p->speed + (PLANT_GAIN*drive - p->speed)*dt/PLANT_TAU;
+		if(speed*p->speed <= 0 && abs(power) <= p->static_friction)
+		{
+			p->stuck = 1;
+			p->speed = 0;
+		}
+		else
+		{
+			p->speed = speed;
+			p->position += speed*dt;
+		}
+	}
+	while(p->counts != (int32_t)floor(p->position))
+	{
+		p->counts += (p->counts < p->position) ? 1 : -1;
+		uint8_t shift = 2*axis;
+		PINA = (PINA & ~(3 << shift)) | (up_sequence[p->counts & 3] << shift);
+		PCINT0_vect();
+	}
+}
+
+int main(void){
+	const double dt = 512e-6/PLANT_SUBSTEPS;
+	const double start = REPLAY_START_H*3600.0;
+	const uint32_t periods = REPLAY_SECONDS/512e-6;
+
+	// Both axes start on the sun, at rest.
+	PINA = 0;
+	set_time(0);
+	encoders_init();
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		int32_t position = lround(azimuth(start)*COUNTS_PER_DEGREE);
+		double friction = (axis < 2);
+		plants[axis] = (plant){ .position = position, .counts = position, .stuck = 1,
+		                        .static_friction = friction*PLANT_STATIC,
+		                        .sliding_friction = friction*PLANT_SLIDING };
+		encoder_set_position(axis, position);
+	}
+	control_init();
+	state_SHARED = TRACK_TARG;
+
+	uint64_t now = 0;
+	double next_command = 0;
+	double sum_squares[MOTOR_NUM_AXES] = {0};
+	double sum_errors[MOTOR_NUM_AXES] = {0};
+	double worst[MOTOR_NUM_AXES] = {0};
+	uint32_t measured = 0;
+	for(uint32_t period = 0; period < periods; period++)
+	{
+		double seconds = period*512e-6;
+
+		// The orientation task sends the position, rate and acceleration of the sun.
+		if(seconds >= next_command)
+		{
+			double t = start + seconds;
+			double rate = (azimuth(t + 1) - azimuth(t - 1))/2*COUNTS_PER_DEGREE;
+			double accel = (azimuth(t + 1) - 2*azimuth(t) + azimuth(t - 1))
+			               *COUNTS_PER_DEGREE;
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				position_cmd_SHARED[axis] = lround(azimuth(t)*COUNTS_PER_DEGREE);
+				rate_cmd_SHARED[axis] = lround(rate*65536);
+				accel_cmd_SHARED[axis] = lround(accel*65536);
+			}
+			setpoint_sequence_SHARED++;
+			next_command += COMMAND_SECONDS;
+		}
+
+		for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+		{
+			now += 1024/PLANT_SUBSTEPS;
+			set_time(now);
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				plant_step(axis, dt);
+			}
+		}
+		TIMER1_OVF_vect();
+
+		if(seconds >= REPLAY_SETTLE_SECONDS)
+		{
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				double error = plants[axis].position 
+				               - azimuth(start + seconds)*COUNTS_PER_DEGREE;
+				sum_squares[axis] += error*error;
+				sum_errors[axis] += error;
+				worst[axis] = fmax(worst[axis], fabs(error));
+			}
+			measured++;
+		}
+	}
+
+	printf("%lu h of sun tracking from %u:00 at %.0f counts/degree, rates %.1f to %.1f "
+	       "counts/s:\n", REPLAY_SECONDS/3600, REPLAY_START_H, COUNTS_PER_DEGREE,
+	       (azimuth(start + 1) - azimuth(start - 1))/2*COUNTS_PER_DEGREE,
+	       (azimuth(12*3600.0 + 1) - azimuth(12*3600.0 - 1))/2*COUNTS_PER_DEGREE);
+	double rms[MOTOR_NUM_AXES];
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		rms[axis] = sqrt(sum_squares[axis]/measured);
+		printf("  %s, feedforward %.3f, %.4f: error mean %+.2f, RMS %.2f counts, worst "
+		       "%.1f\n", (axis < 2) ? "stick-slip" : "no friction", 
+		       motor_axes[axis].k_ff_vel, motor_axes[axis].k_ff_acc, 
+		       sum_errors[axis]/measured, rms[axis], worst[axis]);
+	}
+	CHECK(trips == 0, "%u trips", trips);
+	CHECK(rms[2] < rms[3], "the feedforward made the RMS error %.2f, not %.2f", rms[2],
+	      rms[3]);
+	CHECK(rms[0] < rms[1] + 0.05, "the feedforward made the RMS error %.2f, not %.2f",
+	      rms[0], rms[1]);
+
+	return TEST_RESULT("test_feedforward");
+}
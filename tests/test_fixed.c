@@ -0,0 +1,177 @@
+//*************************************************************************************
+/** \file test_fixed.c
+ *  \brief This file tests the fixed-point math in fixed.h against 64-bit references,
+ *  and the PID_FIXED_POINT build of pid.c against the float controller.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>
+#include <math.h>
+#include <avr/io.h>
+#include "pid.h"
+#include "test.h"
+
+/// Saturates a 64-bit result to the Q16.16 range.
+static int64_t saturate(int64_t value){
+	if(value > INT32_MAX) return INT32_MAX;
+	if(value < INT32_MIN) return INT32_MIN;
+	return value;
+}
+
+/// A random 32-bit operand, often shortened so products stay in range.
+static int32_t operand(uint32_t n, uint8_t shift){
+	int32_t value = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+	return (n % 3) ? value >> shift : value;
+}
+
+/// The float controller of pid.c, which the fixed-point build must follow.
+typedef struct
+{
+	float k_prop, k_int, k_der, int_clamp;
+	int16_t out_clamp;
+	float int_out, error_prev;
+} ref_pid;
+
+static int16_t ref_pid_update(ref_pid *pid, int32_t feedback_signal, int32_t reference_input){
+	float error = reference_input - feedback_signal;
+	float prop_out = pid->k_prop*error;
+	float int_out = pid->k_int*(float)error + pid->int_out;
+	if( int_out > pid->int_clamp ) int_out = pid->int_clamp;
+	if( int_out < -pid->int_clamp ) int_out = -pid->int_clamp;
+	pid->int_out = int_out;
+	float der_out = pid->k_der*(error - pid->error_prev);
+	pid->error_prev = error;
+	int16_t out = prop_out + int_out + der_out;
+	if( out  > pid->out_clamp ) out = pid->out_clamp;
+	if( out < -pid->out_clamp ) out = -pid->out_clamp;
+	return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the float controller around a motor model and the fixed
+ *  one alongside it on the same inputs, and returns the largest output difference.
+ *  \details The model is the one the gains were tuned on: 10 counts/s per count of
+ *  power and a 50 ms mechanical time constant, sampled every 1024 us. The setpoint
+ *  steps by up to 2000 counts every 2 s and ramps in between.
+ *  @param differ Set to the number of samples whose outputs differ.
+ *  @param host_ns Set to the host nanoseconds per update of the float and the 
+ *  fixed controller.
+ */
+static int16_t compare_loop(float k_prop, float k_int, float k_der, float int_clamp,
+                            int16_t out_clamp, uint32_t steps, uint32_t *differ, 
+                            double host_ns[2]){
+	ref_pid reference = {k_prop, k_int, k_der, int_clamp, out_clamp, 0, 0};
+	pid_controller fixed;
+	pid_init(&fixed, k_prop, k_int, k_der, int_clamp, out_clamp, 1024);
+
+	static int32_t feedbacks[400000], references[400000];
+	double position = 0, velocity = 0;
+	const double dt = 1024e-6;
+	int32_t setpoint = 0;
+	int16_t worst = 0;
+	*differ = 0;
+	srand(7);
+	for(uint32_t n = 0; n < steps; n++)
+	{
+		if(n % 2000 == 0)
+		{
+			setpoint += rand()%4001 - 2000;
+		}
+		int32_t target = setpoint + (int32_t)((n % 2000)*0.25);
+		int32_t feedback = (int32_t)floor(position);
+		int16_t out_float = ref_pid_update(&reference, feedback, target);
+		int16_t out_fixed = pid_update(&fixed, feedback, target);
+		int16_t difference = abs(out_fixed - out_float);
+		*differ += (difference != 0);
+		if(difference > worst)
+		{
+			worst = difference;
+		}
+		feedbacks[n] = feedback;
+		references[n] = target;
+		velocity += (10.0*out_float - velocity)*dt/0.05;
+		position += velocity*dt;
+	}
+
+	// Time both on the recorded inputs
+	volatile int16_t sink;
+	double start = test_seconds();
+	for(uint32_t n = 0; n < steps; n++)
+	{
+		sink = ref_pid_update(&reference, feedbacks[n], references[n]);
+	}
+	host_ns[0] = (test_seconds() - start)*1e9/steps;
+	start = test_seconds();
+	for(uint32_t n = 0; n < steps; n++)
+	{
+		sink = pid_update(&fixed, feedbacks[n], references[n]);
+	}
+	host_ns[1] = (test_seconds() - start)*1e9/steps;
+	(void)sink;
+	return worst;
+}
+
+int main(void){
+	// Edge cases, then random operands, against exact 64-bit arithmetic
+	static const int32_t edges[] = {0, 1, -1, 65536, -65536, INT32_MAX, INT32_MIN, 
+		0x7FFF0000, -0x7FFF0000, 0x10000000, -0x10000000, 12345678, -98765};
+	const uint8_t num_edges = sizeof(edges)/sizeof(edges[0]);
+	uint32_t wrong = 0;
+	const uint32_t operations = 5000000;
+	srand(3);
+	for(uint32_t n = 0; n < operations; n++)
+	{
+		int32_t a, b;
+		if(n < (uint32_t)num_edges*num_edges)
+		{
+			a = edges[n % num_edges];
+			b = edges[n / num_edges];
+		}
+		else
+		{
+			a = operand(n, 14);
+			b = operand(n/3, 12);
+		}
+		int64_t product = (int64_t)a*b;
+		int64_t truncated = (product >= 0) ? product >> 16 : -((-product) >> 16);
+		wrong += q16_mul_sat(a, b) != saturate(truncated);
+		wrong += q16_add_sat(a, b) != saturate((int64_t)a + b);
+		wrong += q16_sub_sat(a, b) != saturate((int64_t)a - b);
+		wrong += q16_to_int(a) != (int16_t)(int32_t)((double)a/65536.0);
+	}
+	printf("fixed.h: %lu multiplies, adds, subtracts and conversions, %lu wrong\n",
+	       (unsigned long)operations, (unsigned long)wrong);
+	CHECK(wrong == 0, "%lu results differ from the 64-bit reference", (unsigned long)wrong);
+
+	// The fixed-point controller against the float one, in a closed loop
+	uint32_t differ;
+	double host_ns[2];
+	int16_t worst = compare_loop(1.0F, 0.001F, 0.0F, 100, 300, 400000, &differ, host_ns);
+	printf("PI, default gains: 400000 samples, %lu outputs differ, by at most %d counts\n",
+	       (unsigned long)differ, worst);
+	CHECK(worst <= 2, "PI outputs differ by %d counts", worst);
+	worst = compare_loop(5.0F, 0.05F, 0.8F, 50, 150, 400000, &differ, host_ns);
+	printf("PID, current loop gains: 400000 samples, %lu outputs differ, by at most %d "
+	       "counts\n", (unsigned long)differ, worst);
+	CHECK(worst <= 2, "PID outputs differ by %d counts", worst);
+	printf("host time per update: float %.1f ns, fixed %.1f ns\n", host_ns[0], host_ns[1]);
+
+	return TEST_RESULT("test_fixed");
+}
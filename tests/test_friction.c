@@ -0,0 +1,225 @@
+//*************************************************************************************
+/** \file test_friction.c
+ *  \brief This file tests the static friction compensation in friction.c against a
+ *  simulated motor which sticks: what its calibration measures, which status it 
+ *  keeps, and how the compensation changes the tracking of a slow ramp.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "pid.h"
+#include "friction.h"
+#include "task_motors.h"
+#include "test.h"
+
+/// The control period, in us.
+#define PERIOD_US 1024
+
+/// Integration substeps of the simulated motor per control period.
+#define PLANT_SUBSTEPS 10
+
+/// The simulated motor: speed per unit of power, in counts/s, time constant of the 
+/// speed, in s, and the static and sliding friction, in power counts.
+#define PLANT_GAIN 10.0
+#define PLANT_TAU 0.05
+#define PLANT_STATIC 40.0
+#define PLANT_SLIDING 30.0
+
+/// The ramp the tracking test follows, in counts/s, how long it runs, in control 
+/// periods, and after how many periods its error is measured.
+#define RAMP_RATE 1.0
+#define RAMP_CYCLES 120000
+#define RAMP_START_CYCLES 10000
+
+/** This structure holds the state of the simulated motor, which stays put until the 
+ *  power is past its static friction, and then slows against its sliding friction 
+ *  until it stops again.
+ */
+typedef struct
+{
+	double position;            ///< In counts
+	double speed;               ///< In counts/s
+	double static_friction;     ///< Power it takes to break away
+	uint8_t stuck;              ///< Nonzero while at rest
+	uint32_t breakaways;        ///< Times it broke away
+} plant;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets a simulated motor at rest at 0.
+ *  @param p The motor.
+ *  @param static_friction The power it takes to break away.
+ */
+static void plant_init(plant *p, double static_friction){
+	*p = (plant){0};
+	p->static_friction = static_friction;
+	p->stuck = 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs a simulated motor for one control period.
+ *  @param p The motor.
+ *  @param power The power applied, in power counts.
+ */
+static void plant_step(plant *p, int16_t power){
+	const double dt = PERIOD_US*1e-6/PLANT_SUBSTEPS;
+	for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+	{
+		if(p->stuck)
+		{
+			if(abs(power) <= p->static_friction)
+			{
+				continue;
+			}
+			p->stuck = 0;
+			p->breakaways++;
+		}
+		double drive = power - ((p->speed > 0) ? PLANT_SLIDING : -PLANT_SLIDING);
+		double speed = p->speed + (PLANT_GAIN*drive - p->speed)*dt/PLANT_TAU;
+		if(speed*p->speed <= 0 && abs(power) <= p->static_friction)
+		{
+			p->stuck = 1;
+			p->speed = 0;
+			continue;
+		}
+		p->speed = speed;
+		p->position += speed*dt;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the breakaway calibration on a simulated motor until it
+ *  is over.
+ *  @param fc The compensation of the axis.
+ *  @param p The motor.
+ *  @return The time the calibration took, in s.
+ */
+static double run_calibration(friction_comp *fc, plant *p){
+	uint32_t cycle;
+	friction_calibrate_start(fc, lround(p->position));
+	for(cycle = 0; friction_calibrate_status(fc) < FRICTION_CAL_DONE; cycle++)
+	{
+		plant_step(p, friction_calibrate_update(fc, lround(p->position)));
+	}
+	return cycle*PERIOD_US*1e-6;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function tracks a slow ramp with motor 2's position controller on a 
+ *  simulated motor, with its output through the compensation.
+ *  @param fc The compensation of the axis.
+ *  @param breakaways Set to the times the motor broke away while the error was measured.
+ *  @return The RMS tracking error, in counts.
+ */
+static double run_ramp(friction_comp *fc, uint32_t *breakaways){
+	pid_controller pid;
+	plant p;
+	pid_init(&pid, K_PROP_2, K_INT_2, K_DER_2, INT_CLAMP_2, OUT_CLAMP_2, 
+	         PID_TUNED_PERIOD_US);
+	pid_set_period(&pid, PERIOD_US);
+	plant_init(&p, PLANT_STATIC);
+	friction_reset(fc);
+	double sum = 0;
+	for(uint32_t cycle = 0; cycle < RAMP_CYCLES; cycle++)
+	{
+		double target = RAMP_RATE*cycle*PERIOD_US*1e-6;
+		int16_t power = pid_update(&pid, lround(p.position), lround(target));
+		plant_step(&p, friction_update(fc, power));
+		if(cycle == RAMP_START_CYCLES)
+		{
+			p.breakaways = 0;
+		}
+		if(cycle >= RAMP_START_CYCLES)
+		{
+			sum += (p.position - target)*(p.position - target);
+		}
+	}
+	*breakaways = p.breakaways;
+	return sqrt(sum/(RAMP_CYCLES - RAMP_START_CYCLES));
+}
+
+int main(void){
+	friction_comp fc;
+	plant p;
+
+	// The ramp steps one count every FRICTION_RAMP_CYCLES, and goes on while the axis
+	// covers FRICTION_MOTION_COUNTS, so each breakaway is found a few counts high.
+	friction_init(&fc, 0, 0, PWR_LIMIT_M2);
+	plant_init(&p, PLANT_STATIC);
+	double time = run_calibration(&fc, &p);
+	printf("calibration: status %u after %.2f s, breakaway +%d -%d, static friction "
+	       "%.0f\n", friction_calibrate_status(&fc), time, fc.breakaway_pos, 
+	       fc.breakaway_neg, PLANT_STATIC);
+	CHECK(friction_calibrate_status(&fc) == FRICTION_CAL_DONE, "status %u",
+	      friction_calibrate_status(&fc));
+	CHECK(fc.breakaway_pos > PLANT_STATIC && fc.breakaway_pos <= PLANT_STATIC + 5,
+	      "breakaway +%d", fc.breakaway_pos);
+	CHECK(fc.breakaway_neg > PLANT_STATIC && fc.breakaway_neg <= PLANT_STATIC + 5,
+	      "breakaway -%d", fc.breakaway_neg);
+
+	// The outcome stays readable after the controllers restart, until the next
+	// calibration starts; one stopped part way leaves the powers as they were.
+	int16_t breakaway = fc.breakaway_pos;
+	friction_reset(&fc);
+	CHECK(friction_calibrate_status(&fc) == FRICTION_CAL_DONE && fc.breakaway_pos == breakaway,
+	      "a reset changed the outcome to status %u, +%d", friction_calibrate_status(&fc),
+	      fc.breakaway_pos);
+	friction_calibrate_start(&fc, 0);
+	CHECK(friction_calibrate_status(&fc) == FRICTION_CAL_POSITIVE,
+	      "a new calibration started as status %u", friction_calibrate_status(&fc));
+	for(uint16_t cycle = 0; cycle < 100; cycle++)
+	{
+		friction_calibrate_update(&fc, 0);
+	}
+	friction_reset(&fc);
+	CHECK(friction_calibrate_status(&fc) == FRICTION_CAL_IDLE && fc.breakaway_pos == breakaway,
+	      "a stopped calibration left status %u, +%d", friction_calibrate_status(&fc),
+	      fc.breakaway_pos);
+
+	// An axis which doesn't move up to the power limit keeps its old powers
+	friction_init(&fc, 25, 0, PWR_LIMIT_M2);
+	plant_init(&p, 2*PWR_LIMIT_M2);
+	time = run_calibration(&fc, &p);
+	friction_reset(&fc);
+	printf("stuck axis: status %u after %.2f s, breakaway +%d -%d\n", 
+	       friction_calibrate_status(&fc), time, fc.breakaway_pos, fc.breakaway_neg);
+	CHECK(friction_calibrate_status(&fc) == FRICTION_CAL_STUCK && fc.breakaway_pos == 25 
+	      && fc.breakaway_neg == 25, "stuck axis: status %u, +%d -%d",
+	      friction_calibrate_status(&fc), fc.breakaway_pos, fc.breakaway_neg);
+
+	// A slow ramp makes an uncompensated axis stick and slip
+	uint32_t breakaways, compensated_breakaways;
+	friction_init(&fc, 0, 0, PWR_LIMIT_M2);
+	double error = run_ramp(&fc, &breakaways);
+	friction_init(&fc, 0, 0, PWR_LIMIT_M2);
+	plant_init(&p, PLANT_STATIC);
+	run_calibration(&fc, &p);
+	double compensated = run_ramp(&fc, &compensated_breakaways);
+	printf("%.1f counts/s ramp for %.0f s: RMS error %.2f counts with %lu breakaways, "
+	       "compensated %.2f counts with %lu\n", RAMP_RATE, 
+	       (RAMP_CYCLES - RAMP_START_CYCLES)*PERIOD_US*1e-6, error, 
+	       (unsigned long)breakaways, compensated, (unsigned long)compensated_breakaways);
+	CHECK(compensated < error, "the compensation made the RMS error %.2f from %.2f",
+	      compensated, error);
+
+	return TEST_RESULT("test_friction");
+}
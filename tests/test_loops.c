@@ -0,0 +1,346 @@
+//*************************************************************************************
+/** \file test_loops.c
+ *  \brief This file runs the control executive in control.c, built with the loops
+ *  chosen on the command line, against a simulated DC motor: its winding, back EMF,
+ *  inertia, encoder and current sense. It reports how the axis settles after a step
+ *  how closely it tracks a ramp, and how far a load pushes it off the ramp.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "pid.h"
+#include "encoder.h"
+#include "timestamp.h"
+#include "thermal.h"
+#include "task_safety.h"
+#include "trip.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "control.h"
+#include "test.h"
+
+ISR(TIMER1_OVF_vect);
+ISR(PCINT0_vect);
+
+// The motor: supply in V, winding resistance in ohm and inductance in H, back EMF in
+// V per count/s, and mechanical time constant in s. At full power it runs at about
+// 10 counts/s per count of power, the model the default gains were tuned on.
+#define MOTOR_SUPPLY 12.0
+#define MOTOR_R 0.5
+#define MOTOR_L 0.5e-3
+#define MOTOR_KE 1.17e-3
+#define MOTOR_TAU 0.05
+
+/// ADC counts of the current sense per A.
+#define SENSE_COUNTS_PER_A 28.7
+
+/// Substeps of the motor model per PWM period; each is 5.12 us, well under L/R.
+#define PLANT_SUBSTEPS 100
+
+/// The load torque applied once the axis has settled, as the current which holds it.
+#define LOAD_AMPS 3.0
+
+/// The axis which is stepped, motor 2, and the band it must settle in, in counts.
+#define AXIS 1
+#define SETTLE_COUNTS 2
+
+/// How long each step runs, in PWM periods of 512 us: 4 s.
+#define STEP_PERIODS 7813
+
+/// A ramp is commanded anew every 100 ms, and the error measured from 2 s on for 4 s,
+/// after which the load is applied for 1 s.
+#define RAMP_UPDATE_PERIODS 195
+#define RAMP_START_PERIODS 3906
+#define RAMP_LOAD_PERIODS 7813
+#define LOAD_PERIODS 1953
+
+uint8_t state_SHARED;
+void master_post_fault(uint16_t cause){}
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){ return 0; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/** This structure holds the state of one simulated motor, in its own sense of turning,
+ *  which the encoder sees times the sign of the axis.
+ */
+typedef struct
+{
+	double position;            ///< Shaft angle, in encoder counts
+	double speed;               ///< counts/s
+	double current;             ///< Winding current, A
+	double load;                ///< Load torque, as the current which holds it
+	int32_t counts;             ///< Counts put out so far on the encoder lines
+	uint16_t sense;             ///< Last current sense reading, ADC counts
+} motor_model;
+
+static motor_model motors[MOTOR_NUM_AXES];
+
+/// The quadrature states in the order which counts up, (B<<1)|A.
+static const uint8_t up_sequence[4] = {0, 2, 3, 1};
+
+/// Time of the simulation, in time stamp counts.
+static uint64_t now;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function stands in for the ADC driver, with the reading the current 
+ *  sense gave at the start of the last PWM period.
+ */
+uint16_t adc_read(uint8_t adc_channel){
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		if(MOTOR_AXIS_BYTE(axis, current) == adc_channel)
+		{
+			return motors[axis].sense;
+		}
+	}
+	return 0;
+}
+
+/// Sets the simulated clock which timestamp_now() reads, in time stamp counts.
+static void set_time(uint64_t counts){
+	stub_tick_count = counts/TIMESTAMP_COUNTS_PER_TICK;
+	TCNT3 = counts%TIMESTAMP_COUNTS_PER_TICK;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the motors over one PWM period, from the outputs the 
+ *  drivers set, and puts their turning out on the encoder lines. The H-bridge applies
+ *  the supply in the direction of the IN_A and IN_B pins for the duty cycle, averaged
+ *  over the period, and brakes when its PWM output is disconnected. Its current sense
+ *  reads only the current it supplies, not what the motor feeds back while braking.
+ */
+static void run_motors(void){
+	const double dt = 512e-6/PLANT_SUBSTEPS;
+	const double inertia = MOTOR_TAU*MOTOR_KE*MOTOR_KE/MOTOR_R;
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		motor_axis copy;
+		motor_get_axis(axis, &copy);
+		const motor_axis *motor_axis = &copy;
+		motor_model *motor = &motors[axis];
+		double drive = 0;
+		if(TCCR1A & motor_axis->pwm_com)
+		{
+			drive = (MOTOR_PORT(motor_axis->dir_pin) & motor_axis->in_a) ? 1.0 : -1.0;
+			drive *= *motor_axis->ocr/1023.0;
+		}
+		for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+		{
+			now += TIMESTAMP_HZ/1000000.0*512/PLANT_SUBSTEPS;
+			motor->current += (drive*MOTOR_SUPPLY - MOTOR_R*motor->current 
+			                   - MOTOR_KE*motor->speed)/MOTOR_L*dt;
+			motor->speed += MOTOR_KE*(motor->current - motor->load)/inertia*dt;
+			motor->position += motor->speed*dt;
+			int32_t counts = (int32_t)floor(motor_axis->sign*motor->position);
+			while(motor->counts != counts)
+			{
+				motor->counts += (motor->counts < counts) ? 1 : -1;
+				uint8_t shift = 2*motor_axis->encoder;
+				PINA = (PINA & ~(3 << shift)) | (up_sequence[motor->counts & 3] << shift);
+				set_time(now);
+				PCINT0_vect();
+			}
+		}
+		double supplied = (drive > 0) ? motor->current : -motor->current;
+		double sense = (drive != 0 && supplied > 0) ? supplied*SENSE_COUNTS_PER_A : 0;
+		motor->sense = (sense > 1023) ? 1023 : (uint16_t)sense;
+	}
+	set_time(now);
+}
+
+/// Resets the motors, the encoders and the control executive, with the axes at 0.
+static void start(void){
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		motors[axis] = (motor_model){0};
+		position_cmd_SHARED[axis] = 0;
+		rate_cmd_SHARED[axis] = 0;
+		accel_cmd_SHARED[axis] = 0;
+	}
+	PINA = 0;
+	now = 0;
+	set_time(now);
+	encoders_init();
+	motors_init();
+	PINB = PINC = 0xFF;
+	trip_init();
+	thermal_init();
+	control_init();
+	state_SHARED = TRACK_TARG;
+}
+
+/// Runs the motors, the current samples the ADC ISR would take, and the control ISR
+/// for one PWM period. The two currents are sampled in turn, as the scan does.
+static void run_period(uint32_t period){
+	run_motors();
+	trip_current(MOTOR_AXIS_BYTE(period & 1, current), motors[period & 1].sense);
+	thermal_current(MOTOR_AXIS_BYTE(period & 1, current), motors[period & 1].sense);
+	TIMER1_OVF_vect();
+}
+
+/** This structure holds what one run showed.
+ */
+typedef struct
+{
+	double peak_amps;           ///< Largest current of the motor
+	double settle;              ///< Time after which it stayed in the band, s
+	double overshoot;           ///< Farthest past the target, counts
+	double mean_error;          ///< Mean of the error while tracking, counts
+	double rms_error;           ///< and its RMS
+	double deflection;          ///< Farthest from the target under the load, counts
+	uint16_t trips;             ///< The trips latched
+} run_result;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function steps the command of the axis from rest.
+ *  @param step The size of the step, in counts.
+ *  @param result Where to put what the step showed.
+ */
+static void run_step(int32_t step, run_result *result){
+	start();
+	*result = (run_result){0};
+	position_cmd_SHARED[AXIS] = step;
+	setpoint_sequence_SHARED++;
+	for(uint32_t period = 0; period < STEP_PERIODS; period++)
+	{
+		run_period(period);
+		double error = encoder_get_position(AXIS) - step;
+		result->peak_amps = fmax(result->peak_amps, fabs(motors[AXIS].current));
+		result->overshoot = fmax(result->overshoot, (step > 0) ? error : -error);
+		if(fabs(error) > SETTLE_COUNTS)
+		{
+			result->settle = (period + 1)*512e-6;
+		}
+	}
+	result->trips = safety_error_SHARED;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function has the axis track a ramp, as task_orient commands it: a new 
+ *  position and rate every RAMP_UPDATE_PERIODS, extrapolated by the control executive
+ *  in between. Once it has had RAMP_START_PERIODS to catch up the error is measured,
+ *  and after RAMP_LOAD_PERIODS more, if asked, the load is applied.
+ *  @param rate The rate of the ramp, in counts/s.
+ *  @param load The load to apply, as the current which holds it, in A.
+ *  @param result Where to put what the run showed.
+ */
+static void run_ramp(double rate, double load, run_result *result){
+	start();
+	*result = (run_result){0};
+	uint32_t samples = 0;
+	uint32_t end = RAMP_START_PERIODS + RAMP_LOAD_PERIODS + (load ? LOAD_PERIODS : 0);
+	for(uint32_t period = 0; period < end; period++)
+	{
+		if(period % RAMP_UPDATE_PERIODS == 0)
+		{
+			position_cmd_SHARED[AXIS] = lround(rate*period*512e-6);
+			rate_cmd_SHARED[AXIS] = lround(rate*65536.0);
+			setpoint_sequence_SHARED++;
+		}
+		motors[AXIS].load = (period < RAMP_START_PERIODS + RAMP_LOAD_PERIODS) ? 0 : load;
+		run_period(period);
+		double error = encoder_get_position(AXIS) - rate*(period + 1)*512e-6;
+		result->peak_amps = fmax(result->peak_amps, fabs(motors[AXIS].current));
+		if(period >= RAMP_START_PERIODS + RAMP_LOAD_PERIODS)
+		{
+			result->deflection = fmax(result->deflection, fabs(error));
+		}
+		else if(period >= RAMP_START_PERIODS)
+		{
+			result->mean_error += error;
+			result->rms_error += error*error;
+			samples++;
+		}
+	}
+	result->mean_error /= samples;
+	result->rms_error = sqrt(result->rms_error/samples);
+	result->trips = safety_error_SHARED;
+}
+
+int main(void){
+#if defined(VELOCITY_LOOP) && defined(CURRENT_LOOP)
+	const char *loops = "position, velocity and current loops";
+#elif defined(VELOCITY_LOOP)
+	const char *loops = "position and velocity loops";
+#elif defined(CURRENT_LOOP)
+	const char *loops = "position and current loops";
+#else
+	const char *loops = "position loop to power";
+#endif
+	printf("%s, motor 2:\n"
+	       "   step  peak current  settle to %u counts  overshoot\n", loops, 
+	       SETTLE_COUNTS);
+	const int32_t steps[] = {200, 1000, 4000};
+	for(uint8_t step = 0; step < 3; step++)
+	{
+		run_result result;
+		run_step(steps[step], &result);
+		if(result.settle < STEP_PERIODS*512e-6)
+		{
+			printf("  %5ld  %9.2f A  %13.3f s  %13.1f\n", (long)steps[step],
+			       result.peak_amps, result.settle, result.overshoot);
+		}
+		else
+		{
+			printf("  %5ld  %9.2f A  %15s  %13.1f\n", (long)steps[step],
+			       result.peak_amps, "not in 4 s", result.overshoot);
+		}
+		CHECK(result.trips == 0, "step %ld: tripped, %02X", (long)steps[step], 
+		      result.trips);
+		CHECK(result.peak_amps*SENSE_COUNTS_PER_A < TRIP_CURRENT_M2, 
+		      "step %ld: %.2f A is over the trip level", (long)steps[step], 
+		      result.peak_amps);
+		CHECK(result.overshoot < 0.01*steps[step] + 10, "step %ld: overshot by %.0f",
+		      (long)steps[step], result.overshoot);
+#ifdef CURRENT_LOOP
+		// The loop holds the current reference to the limit, though braking current 
+		// can't be sensed, so allow a little over it.
+		CHECK(result.peak_amps*SENSE_COUNTS_PER_A < 1.2*CURRENT_LIMIT_2,
+		      "step %ld: %.2f A is over the current limit", (long)steps[step], 
+		      result.peak_amps);
+#endif
+	}
+
+	// Ramps from well below to well above the sun's rate on the axis, then a load 
+	// while tracking, when the axis is awake
+	run_result result;
+	const double rates[] = {0.5, 5.0, 50.0};
+	for(uint8_t rate = 0; rate < 3; rate++)
+	{
+		run_ramp(rates[rate], 0, &result);
+		printf("  tracking %4.1f counts/s: error mean %5.2f, RMS %4.2f counts\n",
+		       rates[rate], result.mean_error, result.rms_error);
+		CHECK(result.trips == 0, "ramp: tripped, %02X", result.trips);
+		CHECK(fabs(result.mean_error) < 5, "ramp %.1f: mean error %.2f", rates[rate],
+		      result.mean_error);
+	}
+	run_ramp(5.0, LOAD_AMPS, &result);
+	printf("  tracking 5 counts/s: mean error %.2f counts, %.0f counts at most under a "
+	       "%.1f A load\n", result.mean_error, result.deflection, LOAD_AMPS);
+	CHECK(result.trips == 0, "load: tripped, %02X", result.trips);
+
+	return TEST_RESULT("test_loops");
+}
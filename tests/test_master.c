@@ -0,0 +1,222 @@
+//*************************************************************************************
+/** \file test_master.c
+ *  \brief This file tests the master task in task_master.c: that a safety fault 
+ *  reaches ERROR even when it finds the master's queue full, and the reset from ERROR.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <setjmp.h>
+#include <string.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "timestamp.h"
+#include "debounce.h"
+#include "task_master.h"
+#include "trip.h"
+#include "test.h"
+
+/// The master's queue, as a ring of SIZE_MASTER_QUEUE events like the real one.
+static master_event queue_items[SIZE_MASTER_QUEUE];
+static uint8_t queue_head;
+static uint8_t queue_count;
+
+/// Where the master task is left once the test script has run to its end.
+static jmp_buf script_done;
+
+static uint8_t script(void);
+
+xQueueHandle xQueueCreate(unsigned portBASE_TYPE length, unsigned portBASE_TYPE size){
+	return queue_items;
+}
+signed portBASE_TYPE xQueueSend(xQueueHandle queue, const void *item, portTickType wait){
+	if(queue_count == SIZE_MASTER_QUEUE)
+	{
+		return pdFAIL;
+	}
+	memcpy(&queue_items[(queue_head + queue_count++) % SIZE_MASTER_QUEUE], item,
+	       sizeof(master_event));
+	return pdPASS;
+}
+signed portBASE_TYPE xQueueSendFromISR(xQueueHandle queue, const void *item,
+                                       signed portBASE_TYPE *woken){
+	return xQueueSend(queue, item, 0);
+}
+unsigned portBASE_TYPE uxQueueMessagesWaiting(xQueueHandle queue){ return queue_count; }
+
+/// Where the master would block on the empty queue, the next step of the script runs.
+signed portBASE_TYPE xQueueReceive(xQueueHandle queue, void *item, portTickType wait){
+	while(!queue_count)
+	{
+		if(!script())
+		{
+			longjmp(script_done, 1);
+		}
+	}
+	memcpy(item, &queue_items[queue_head], sizeof(master_event));
+	queue_head = (queue_head + 1) % SIZE_MASTER_QUEUE;
+	queue_count--;
+	return pdPASS;
+}
+
+/// The switch inputs which are closed, as bits 1 << DEBOUNCE_ input, and the latched
+/// faults and driver faults the stand-ins of trip.c give.
+static uint32_t active_inputs;
+uint16_t safety_error_SHARED;
+static uint16_t driver_faults;
+
+uint8_t debounce_active(uint8_t input){ return (active_inputs >> input) & 1; }
+uint16_t trip_driver_faults(void){ return driver_faults; }
+uint16_t trip_reset(void)
+{
+	uint16_t faults = safety_error_SHARED;
+	safety_error_SHARED = 0;
+	return faults;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function fills the queue with button events and then latches and posts
+ *  a fault, which finds it full.
+ *  @param from_ISR Nonzero to post it as the fast trip does, from an ISR.
+ *  @param cause The TRIP_ bits posted.
+ */
+static void post_fault_to_full_queue(uint8_t from_ISR, uint16_t cause){
+	for(uint8_t item = 0; item < SIZE_MASTER_QUEUE; item++)
+	{
+		master_post(item & 1 ? MASTER_EVENT_BUTTON_RELEASE : MASTER_EVENT_BUTTON_PRESS);
+	}
+	CHECK(queue_count == SIZE_MASTER_QUEUE, "the queue didn't fill");
+	safety_error_SHARED |= cause;
+	if(from_ISR)
+	{
+		master_post_fault_from_ISR(cause);
+	}
+	else
+	{
+		master_post_fault(cause);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function presses and releases the button.
+ */
+static void press(void){
+	master_post(MASTER_EVENT_BUTTON_PRESS);
+	master_post(MASTER_EVENT_BUTTON_RELEASE);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function is the test script. The master task calls it through 
+ *  xQueueReceive() each time it has taken every event, so each step checks the state
+ *  the previous one's events led to and posts the events of the next.
+ *  @return Zero once the script has run to its end.
+ */
+static uint8_t script(void){
+	static uint8_t step = 0;
+	switch(step++)
+	{
+		case 0:
+			// The button events step the master on first, and then the fault which
+			// found the queue full takes it to ERROR.
+			post_fault_to_full_queue(1, TRIP_OVERCURRENT_M1);
+			return 1;
+
+		case 1:
+			printf("Fault from an ISR into a full queue: state %u, cause 0x%02X\n",
+			       state_SHARED, master_get_fault_cause());
+			CHECK(state_SHARED == ERROR, "the fault was lost, state %u", state_SHARED);
+			CHECK(master_get_fault_cause() == TRIP_OVERCURRENT_M1, "cause 0x%02X",
+			      master_get_fault_cause());
+
+			// The presses reset ERROR, since nothing holds the reset off, but the fault
+			// which found the queue full after them is taken last.
+			post_fault_to_full_queue(0, TRIP_STALL);
+			return 1;
+
+		case 2:
+			printf("Fault from a task into a full queue: state %u, cause 0x%02X\n",
+			       state_SHARED, master_get_fault_cause());
+			CHECK(state_SHARED == ERROR, "the fault was lost, state %u", state_SHARED);
+			CHECK(master_get_fault_cause() == TRIP_STALL, "cause 0x%02X",
+			      master_get_fault_cause());
+
+			// ERROR is kept while the emergency stop is closed.
+			safety_error_SHARED |= TRIP_ESTOP;
+			active_inputs = 1UL << DEBOUNCE_ESTOP;
+			press();
+			return 1;
+
+		case 3:
+			CHECK(state_SHARED == ERROR && safety_error_SHARED, "reset with the stop closed");
+
+			// And while a driver reports a fault.
+			active_inputs = 0;
+			driver_faults = TRIP_DRIVER_M2;
+			press();
+			return 1;
+
+		case 4:
+			CHECK(state_SHARED == ERROR && safety_error_SHARED, "reset with a driver fault");
+
+			// Once the causes are gone a press resets the faults.
+			driver_faults = 0;
+			press();
+			return 1;
+
+		case 5:
+			printf("Reset from ERROR: state %u, faults 0x%03X\n", state_SHARED, 
+			       safety_error_SHARED);
+			CHECK(state_SHARED == IDLE && !safety_error_SHARED, "state %u, faults 0x%03X",
+			      state_SHARED, safety_error_SHARED);
+
+			// The next press selects a target, with the calibration kept.
+			master_post(MASTER_EVENT_BUTTON_PRESS);
+			return 1;
+
+		case 6:
+			CHECK(state_SHARED == SELECT_TARG, "IDLE led to state %u", state_SHARED);
+
+			// After the loss of an encoder the axes are calibrated again.
+			safety_error_SHARED |= TRIP_ENCODER_LOSS;
+			master_post_fault(TRIP_ENCODER_LOSS);
+			press();
+			master_post(MASTER_EVENT_BUTTON_PRESS);
+			return 1;
+
+		case 7:
+			CHECK(state_SHARED == CALIBRATION, "encoder loss reset to state %u", 
+			      state_SHARED);
+			return 0;
+	}
+	return 0;
+}
+
+int main(void){
+	master_queue = xQueueCreate(SIZE_MASTER_QUEUE, sizeof(master_event));
+	if(!setjmp(script_done))
+	{
+		task_master(NULL);
+	}
+	return TEST_RESULT("test_master");
+}
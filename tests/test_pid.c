@@ -0,0 +1,142 @@
+//*************************************************************************************
+/** \file test_pid.c
+ *  \brief This file tests the pid_controller in pid.c against the pid_1() and pid_2()
+ *  functions it replaced, and checks its bumpless transfer and rate change.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>
+#include <math.h>
+#include <avr/io.h>
+#include "pid.h"
+#include "test.h"
+
+// Gains and limits of the old pid_1() and pid_2()
+#define REF_INT_CLAMP_1 100
+#define REF_OUT_CLAMP_1 150
+#define REF_K_INT_1 0.001F
+#define REF_K_PROP_1 1.0F
+#define REF_K_DER_1 0.0F
+
+#define REF_INT_CLAMP_2 75
+#define REF_OUT_CLAMP_2 350
+#define REF_K_INT_2 0.001F
+#define REF_K_PROP_2 1.0F
+#define REF_K_DER_2 0.0F
+
+//-------------------------------------------------------------------------------------
+/** \brief This macro expands to one of the old single-instance controllers, with its
+ *  state in function statics and its gains compiled in, as pid.c had it.
+ */
+#define REF_PID(name, n) \
+int16_t name(int32_t feedback_signal, int32_t reference_input) \
+{ \
+	static float int_out_prev = 0; \
+	static float error_prev = 0; \
+	float error = reference_input - feedback_signal; \
+	float prop_out = REF_K_PROP_##n*error; \
+	float int_out = REF_K_INT_##n*(float)error + int_out_prev; \
+	if( int_out > REF_INT_CLAMP_##n ) int_out = REF_INT_CLAMP_##n; \
+	if( int_out < -REF_INT_CLAMP_##n ) int_out = -REF_INT_CLAMP_##n; \
+	int_out_prev = int_out; \
+	float der_out = REF_K_DER_##n*(error - error_prev ); \
+	error_prev = error; \
+	int16_t out = prop_out + int_out + der_out; \
+	if( out  > REF_OUT_CLAMP_##n ) out = REF_OUT_CLAMP_##n; \
+	if( out < -REF_OUT_CLAMP_##n ) out = -REF_OUT_CLAMP_##n; \
+	return out; \
+}
+
+static REF_PID(ref_pid_1, 1)
+static REF_PID(ref_pid_2, 2)
+
+int main(void){
+	pid_controller pid_1, pid_2;
+	pid_init(&pid_1, REF_K_PROP_1, REF_K_INT_1, REF_K_DER_1, REF_INT_CLAMP_1, 
+	         REF_OUT_CLAMP_1, PID_TUNED_PERIOD_US);
+	pid_init(&pid_2, REF_K_PROP_2, REF_K_INT_2, REF_K_DER_2, REF_INT_CLAMP_2, 
+	         REF_OUT_CLAMP_2, PID_TUNED_PERIOD_US);
+
+	// Random inputs, two thirds of them near the setpoint where the integrator and
+	// the clamps are exercised.
+	uint32_t mismatches = 0;
+	const uint32_t samples = 2000000;
+	srand(1);
+	for(uint32_t n = 0; n < samples; n++)
+	{
+		int32_t feedback = rand()%4000 - 2000;
+		int32_t reference = (n % 3) ? feedback + rand()%300 - 150 : rand()%4000 - 2000;
+		mismatches += pid_update(&pid_1, feedback, reference) != ref_pid_1(feedback, reference);
+		mismatches += pid_update(&pid_2, feedback, reference) != ref_pid_2(feedback, reference);
+	}
+	printf("pid_update: %lu outputs, %lu differ from the old pid_1/pid_2\n", 
+	       (unsigned long)(2*samples), (unsigned long)mismatches);
+	CHECK(mismatches == 0, "%lu mismatches", (unsigned long)mismatches);
+
+	// Two controllers with the same gains don't share state: interleaved they give
+	// what each gives alone.
+	pid_controller a, b, alone;
+	pid_init(&a, 2.0F, 0.01F, 0.5F, 50, 300, PID_TUNED_PERIOD_US);
+	b = a;
+	alone = a;
+	uint32_t crosstalk = 0;
+	for(int32_t n = 0; n < 1000; n++)
+	{
+		pid_update(&b, -n, 3*n);
+		crosstalk += pid_update(&a, n, 100) != pid_update(&alone, n, 100);
+	}
+	CHECK(crosstalk == 0, "interleaved controllers differ in %lu samples", 
+	      (unsigned long)crosstalk);
+
+	// After a bumpless transfer the first update returns the output handed over.
+	uint32_t bumps = 0;
+	for(int16_t output = -40; output <= 40; output += 8)
+	{
+		pid_init(&a, 1.0F, 0.001F, 0.5F, 100, 300, PID_TUNED_PERIOD_US);
+		pid_bumpless(&a, 1000, 1020, output);
+		int16_t first = pid_update(&a, 1000, 1020);
+		bumps += abs(first - output) > 1;
+	}
+	CHECK(bumps == 0, "%lu bumpless transfers bumped by more than one count", 
+	      (unsigned long)bumps);
+
+	// Halving the period halves the per-sample integral gain and doubles the 
+	// derivative one.
+	pid_init(&a, 1.0F, 0.002F, 0.4F, 100, 300, 1000);
+	pid_set_period(&a, 500);
+	CHECK(fabsf(a.k_int - 0.001F) < 1e-9F && fabsf(a.k_der - 0.8F) < 1e-6F,
+	      "pid_set_period(): k_int %g k_der %g", a.k_int, a.k_der);
+
+	// A large gain, as the position loops have with VELOCITY_LOOP, saturates at the 
+	// clamp with the sign of the error, however large the error, rather than wrapping
+	// in the conversion to int16_t.
+	uint32_t wrong = 0;
+	pid_init(&a, 640.0F, 0.0F, 0.0F, 0, 20000, PID_TUNED_PERIOD_US);
+	for(int32_t error = -100000; error <= 100000; error += 7)
+	{
+		int32_t out = pid_update(&a, 0, error);
+		int32_t expected = 640*error;
+		expected = (expected > 20000) ? 20000 : (expected < -20000) ? -20000 : expected;
+		wrong += abs(out - expected) > 1;
+	}
+	CHECK(wrong == 0, "a gain of 640 gave %lu wrong outputs", (unsigned long)wrong);
+
+	return TEST_RESULT("test_pid");
+}
@@ -0,0 +1,197 @@
+//*************************************************************************************
+/** \file test_profile.c
+ *  \brief This file tests the motion profile in profile.c: the limits its
+ *  trajectories keep, and how it changes the settling of a simulated motor after a
+ *  setpoint step.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "pid.h"
+#include "profile.h"
+#include "task_motors.h"
+#include "test.h"
+
+/// The control period the profile and controller run at, in us.
+#define PERIOD_US 1024
+
+/// Limits the trajectory test runs the profile with, in counts/s, /s^2 and /s^3.
+#define VEL_MAX 2000.0
+#define ACC_MAX 4000.0
+#define JERK_MAX 400000.0
+
+/// Time constant of the simulated motor's speed, in s, and its integration substeps.
+#define PLANT_TAU 0.05
+#define PLANT_SUBSTEPS 10
+
+/// The band around the target which counts as settled, as a fraction of the step.
+#define SETTLE_BAND 0.02
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the profile from 100 to a target, and checks that its 
+ *  trajectory keeps the limits, never passes the target and ends exactly on it.
+ *  @param target The target position.
+ *  @param reverse Cycles to head for the mirror image of the target first, so the
+ *  profile has to turn around.
+ */
+static void check_trajectory(int32_t target, uint16_t reverse){
+	const double period = PERIOD_US*1e-6;
+	motion_profile prof;
+	profile_init(&prof, VEL_MAX, ACC_MAX, JERK_MAX, PERIOD_US);
+	profile_reset(&prof, 100);
+
+	double previous = 100;
+	double velocity = 0;
+	double accel = 0;
+	double vel_max = 0;
+	double acc_max = 0;
+	double jerk_max = 0;
+	double overshoot = 0;
+	uint32_t cycle;
+	for(cycle = 0; cycle < 400000; cycle++)
+	{
+		int32_t output = profile_update(&prof, (cycle < reverse) ? 200 - target : target);
+		double exact = prof.output + prof.output_fraction/65536.0;
+		double new_velocity = (exact - previous)/period;
+		double new_accel = (new_velocity - velocity)/period;
+		double jerk = (new_accel - accel)/period;
+		vel_max = fmax(vel_max, fabs(new_velocity));
+		if(cycle > 1)
+		{
+			acc_max = fmax(acc_max, fabs(new_accel));
+		}
+		if(cycle > 2)
+		{
+			jerk_max = fmax(jerk_max, fabs(jerk));
+		}
+		if(cycle >= reverse)
+		{
+			overshoot = fmax(overshoot, (target > 100) ? exact - target : target - exact);
+		}
+		previous = exact;
+		velocity = new_velocity;
+		accel = new_accel;
+		if(profile_done(&prof) && cycle > 0)
+		{
+			CHECK(output == target && prof.output_fraction == 0,
+			      "target %ld: stopped at %ld", (long)target, (long)output);
+			break;
+		}
+	}
+	printf("%7ld%s: done in %6lu cycles, peak %4.0f counts/s %4.0f counts/s^2 "
+	       "%6.0f counts/s^3\n", (long)target, reverse ? " reversing" : "          ",
+	       (unsigned long)cycle, vel_max, acc_max, jerk_max);
+
+	// The acceleration may exceed its limit by the rounding of one step per cycle.
+	CHECK(profile_done(&prof), "target %ld: never finished", (long)target);
+	CHECK(vel_max <= VEL_MAX*1.001, "target %ld: speed %.0f", (long)target, vel_max);
+	CHECK(acc_max <= ACC_MAX*1.01, "target %ld: acceleration %.0f", (long)target, acc_max);
+	CHECK(jerk_max <= JERK_MAX, "target %ld: jerk %.0f", (long)target, jerk_max);
+	CHECK(overshoot <= 0, "target %ld: passed the target by %.4f", (long)target,
+	      overshoot);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs motor 2's position controller against a simulated DC
+ *  motor after a step in the command, with or without the profile between them.
+ *  @param profiled Nonzero to run the command through the profile.
+ *  @param step The size of the step, in counts.
+ *  @param gain Speed of the motor per unit of power, in counts/s.
+ *  @param overshoot Set to the largest distance past the target.
+ *  @param settle Set to the time after which the motor stays in the settling band.
+ *  @return The number of cycles in which the controller output was at its clamp.
+ */
+static uint32_t run_step(uint8_t profiled, int32_t step, double gain, double *overshoot,
+                         double *settle){
+	const double dt = PERIOD_US*1e-6/PLANT_SUBSTEPS;
+	pid_controller pid;
+	motion_profile prof;
+	pid_init(&pid, K_PROP_2, K_INT_2, K_DER_2, INT_CLAMP_2, OUT_CLAMP_2, 
+	         PID_TUNED_PERIOD_US);
+	pid_set_period(&pid, PERIOD_US);
+	profile_init(&prof, PROFILE_VEL_MAX_2, PROFILE_ACC_MAX_2, PROFILE_JERK_MAX_2, 
+	             PERIOD_US);
+	profile_reset(&prof, 0);
+
+	double position = 0;
+	double speed = 0;
+	uint32_t saturated = 0;
+	*overshoot = 0;
+	*settle = 0;
+	for(uint16_t cycle = 0; cycle < 8000; cycle++)
+	{
+		int32_t feedback = lround(position);
+		int32_t reference = profiled ? profile_update(&prof, step) : step;
+		int16_t power = pid_update(&pid, feedback, reference);
+		if(power >= OUT_CLAMP_2 || power <= -OUT_CLAMP_2)
+		{
+			saturated++;
+		}
+		power = (power > PWR_LIMIT_M2) ? PWR_LIMIT_M2 : power;
+		power = (power < -PWR_LIMIT_M2) ? -PWR_LIMIT_M2 : power;
+		for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+		{
+			speed += (gain*power - speed)*dt/PLANT_TAU;
+			position += speed*dt;
+		}
+		*overshoot = fmax(*overshoot, position - step);
+		if(fabs(position - step) > SETTLE_BAND*step)
+		{
+			*settle = (cycle + 1)*PERIOD_US*1e-6;
+		}
+	}
+	return saturated;
+}
+
+int main(void){
+	const int32_t targets[] = {1, 7, 100, 1000, -5000, 30000, 200000};
+	for(uint8_t target = 0; target < sizeof(targets)/sizeof(targets[0]); target++)
+	{
+		check_trajectory(targets[target], 0);
+	}
+	check_trajectory(30000, 300);
+
+	printf("step response of motor 2, settled within %.0f%% of the step:\n"
+	       "  counts/s    step     direct: overshoot settle  at clamp"
+	       "    profiled: overshoot settle  at clamp\n", SETTLE_BAND*100);
+	const double gains[] = {5, 10, 20};
+	const int32_t steps[] = {200, 1000, 4000};
+	for(uint8_t gain = 0; gain < 3; gain++)
+	{
+		for(uint8_t step = 0; step < 3; step++)
+		{
+			double overshoot, settle, profiled_overshoot, profiled_settle;
+			uint32_t saturated = run_step(0, steps[step], gains[gain], &overshoot, 
+			                              &settle);
+			uint32_t profiled_saturated = run_step(1, steps[step], gains[gain],
+			                                       &profiled_overshoot, &profiled_settle);
+			printf("  %4.0f/pwr  %6ld  %19.1f %6.3f %8lu  %19.1f %6.3f %8lu\n",
+			       gains[gain], (long)steps[step], overshoot, settle, 
+			       (unsigned long)saturated, profiled_overshoot, profiled_settle,
+			       (unsigned long)profiled_saturated);
+			CHECK(profiled_overshoot <= overshoot + 0.5 && profiled_saturated <= saturated,
+			      "the profile made a %ld count step worse", (long)steps[step]);
+		}
+	}
+
+	return TEST_RESULT("test_profile");
+}
@@ -0,0 +1,166 @@
+//*************************************************************************************
+/** \file test_safety_log.c
+ *  \brief This file tests the safety event log in safety_log.c, fed by the fast trip
+ *  of trip.c as the safety task calls it: how many records persistent and 
+ *  chattering faults leave, what is counted, and the times they are stamped with.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <string.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "trip.h"
+#include "safety_log.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "test.h"
+
+/// Period of the safety task, which refills the buckets and reads the log, in ticks.
+#define SAFETY_PERIOD 100
+
+/// Length of a message the safety task sends for each record, with CR LF, in bytes, 
+/// and the bytes per second the serial link carries at 9600 baud.
+#define MESSAGE_BYTES 36
+#define LINK_BYTES_PER_S 960
+
+/// A time well past 2^32 counts of the 2 MHz time stamp, 35.8 minutes, in ticks.
+#define LATE_TICKS ( 3UL*3600*configTICK_RATE_HZ )
+
+uint8_t state_SHARED;
+
+void master_post_fault(uint16_t cause){ }
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){ return 0; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// The safety task's sequence number into the log, and the records it read.
+static uint8_t sequence;
+static safety_log_record records[256];
+static uint16_t records_read;
+
+/// Runs the log's side of one pass of the safety task.
+static void safety_task(void){
+	safety_log_tick();
+	while(records_read < 256 && safety_log_read(&records[records_read], 1, &sequence))
+	{
+		records_read++;
+	}
+}
+
+int main(void){
+	motors_init();
+	safety_log_init();
+	CHECK(sizeof(safety_log_record) == 8, "a record is %u bytes", 
+	      (unsigned)sizeof(safety_log_record));
+
+	// A driver fault which persists is found by the safety task every pass, but only
+	// its first latch is logged.
+	trip_init();
+	for(uint16_t pass = 0; pass < 600; pass++)
+	{
+		stub_tick_count = (portTickType)pass*SAFETY_PERIOD;
+		trip_fault(TRIP_DRIVER_M1);
+		safety_task();
+	}
+	safety_log_cause counts;
+	safety_log_get_cause(SAFETY_CAUSE_DRIVER_M1, &counts);
+	printf("driver fault held for 60 s: %u record, %u event\n", records_read, counts.count);
+	CHECK(records_read == 1 && records[0].cause == SAFETY_CAUSE_DRIVER_M1 
+	      && counts.count == 1, "a held fault left %u records, %u events", records_read,
+	      counts.count);
+
+	// A chattering limit switch, latched anew after each reset, is logged at the rate 
+	// the tokens allow, and the rest are counted.
+	safety_log_init();
+	sequence = 0;
+	records_read = 0;
+	uint16_t events = 0;
+	for(uint16_t pass = 0; pass < 600; pass++)
+	{
+		stub_tick_count = (portTickType)pass*SAFETY_PERIOD;
+		for(uint8_t edge = 0; edge < 2; edge++)
+		{
+			trip_init();
+			trip_fault(TRIP_LIMIT);
+			events++;
+		}
+		safety_task();
+	}
+	safety_log_get_cause(SAFETY_CAUSE_LIMIT, &counts);
+	uint16_t in_records = 0;
+	for(uint16_t record = 0; record < records_read; record++)
+	{
+		in_records += 1 + records[record].suppressed;
+	}
+	uint16_t expected = SAFETY_LOG_BURST + 600/SAFETY_LOG_REFILL_TICKS;
+	printf("limit switch edge every 50 ms for 60 s: %u records (%.1f%% of the link) for "
+	       "%u events, %u suppressed; without the log %u (%.0f%%)\n", records_read,
+	       100.0*records_read*MESSAGE_BYTES/60/LINK_BYTES_PER_S, counts.count, 
+	       counts.suppressed, events, 100.0*events*MESSAGE_BYTES/60/LINK_BYTES_PER_S);
+	CHECK(records_read <= expected, "%u records, at most %u expected", records_read, 
+	      expected);
+	CHECK(counts.count == events && counts.suppressed == events - records_read,
+	      "counted %u events, %u suppressed", counts.count, counts.suppressed);
+	CHECK(in_records <= events && in_records > events - 2*SAFETY_LOG_REFILL_TICKS,
+	      "the records account for %u of %u events", in_records, events);
+	CHECK(counts.first == 0 && counts.last == 599*SAFETY_PERIOD, 
+	      "first %lu, last %lu", (unsigned long)counts.first, (unsigned long)counts.last);
+
+	// Events are stamped with the tick count, which doesn't wrap after 35.8 minutes as
+	// the time stamp does.
+	safety_log_init();
+	sequence = 0;
+	records_read = 0;
+	trip_init();
+	stub_tick_count = LATE_TICKS;
+	trip_fault(TRIP_ESTOP);
+	stub_tick_count = LATE_TICKS + 2000;
+	safety_log_post(SAFETY_CAUSE_STOW);
+	safety_task();
+	printf("events 3 hours after reset stamped %lu and %lu ms\n", 
+	       (unsigned long)records[0].time, (unsigned long)records[1].time);
+	CHECK(records_read == 2 && records[0].time == LATE_TICKS 
+	      && records[1].time == LATE_TICKS + 2000, "late events stamped %lu and %lu",
+	      (unsigned long)records[0].time, (unsigned long)records[1].time);
+
+	// Readers which fall behind each get the newest SAFETY_LOG_RECORDS.
+	uint8_t late_sequence = sequence;
+	for(uint8_t round = 0; round < 3; round++)
+	{
+		for(uint8_t cause = 0; cause < SAFETY_LOG_CAUSES; cause++)
+		{
+			safety_log_post(cause);
+		}
+	}
+	records_read = 0;
+	safety_task();
+	safety_log_record behind[2*SAFETY_LOG_RECORDS];
+	uint8_t copied = safety_log_read(behind, 2*SAFETY_LOG_RECORDS, &late_sequence);
+	CHECK(records_read == SAFETY_LOG_RECORDS && copied == SAFETY_LOG_RECORDS,
+	      "readers behind got %u and %u records", records_read, copied);
+	CHECK(late_sequence == sequence 
+	      && memcmp(behind, records, copied*sizeof(safety_log_record)) == 0,
+	      "the readers got different records");
+
+	return TEST_RESULT("test_safety_log");
+}
@@ -0,0 +1,103 @@
+//*************************************************************************************
+/** \file test_sampled.c
+ *  \brief This file tests the fixed-rate sampled encoder mode, built with 
+ *  -DENCODER_SAMPLED, and compares its ISR load with pin change decoding.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "timestamp.h"
+#include "encoder.h"
+#include "test.h"
+
+ISR(TIMER2_COMPA_vect);
+
+/// The quadrature states in the order which counts up, (B<<1)|A.
+static const uint8_t up_sequence[4] = {0, 2, 3, 1};
+
+//-------------------------------------------------------------------------------------
+/** \brief This function samples both axes turning at a steady rate for one second.
+ *  @param rate The speed of each axis in counts/s; axis 1 turns the other way.
+ *  @param seconds Seconds to run.
+ *  @return Host nanoseconds per run of the sampling ISR.
+ */
+static double run_samples(double rate, double seconds){
+	PINA = 0;
+	encoders_init();
+	uint32_t samples = seconds*ENC_SAMPLE_HZ;
+	double start = test_seconds();
+	for(uint32_t n = 1; n <= samples; n++)
+	{
+		int32_t count = (int32_t)floor(rate*n/ENC_SAMPLE_HZ);
+		PINA = up_sequence[count & 3] | (up_sequence[-count & 3] << 2);
+		TIMER2_COMPA_vect();
+	}
+	return (test_seconds() - start)*1e9/samples;
+}
+
+int main(void){
+	PINA = 0;
+	encoders_init();
+	CHECK(OCR2A == 199 && TCCR2A == (1<<WGM21) && TCCR2B == (1<<CS21), 
+	      "Timer 2 is not set to 10 kHz CTC: OCR2A %u", OCR2A);
+
+	static const double rates[] = {100, 1000, 5000, 9999};
+	for(uint8_t i = 0; i < sizeof(rates)/sizeof(rates[0]); i++)
+	{
+		run_samples(rates[i], 1.0);
+		int32_t expected = (int32_t)floor(rates[i]);
+		CHECK(encoder_get_position(ENC_AXIS_M1) == expected 
+		      && encoder_get_position(ENC_AXIS_M2) == -expected,
+		      "%.0f counts/s: positions %ld %ld, expected +-%ld", rates[i], 
+		      (long)encoder_get_position(ENC_AXIS_M1), 
+		      (long)encoder_get_position(ENC_AXIS_M2), (long)expected);
+		CHECK(encoder_get_overspeed() == 0, "%.0f counts/s flagged overspeed", rates[i]);
+		CHECK(encoder_get_isr_count() == ENC_SAMPLE_HZ, "%.0f counts/s: %lu ISR runs", 
+		      rates[i], (unsigned long)encoder_get_isr_count());
+	}
+	printf("sampled at %lu Hz: positions exact up to %.0f counts/s\n", ENC_SAMPLE_HZ, 
+	       rates[sizeof(rates)/sizeof(rates[0]) - 1]);
+
+	// Above one count per sample, a state is skipped and the axis must be flagged.
+	run_samples(15000, 0.1);
+	CHECK(encoder_get_overspeed() == ((1<<ENC_AXIS_M1)|(1<<ENC_AXIS_M2)), 
+	      "15000 counts/s not flagged as overspeed");
+	printf("15000 counts/s: overspeed flagged, %u errors on axis 1 in 0.1 s\n", 
+	       encoder_get_errors(ENC_AXIS_M1));
+
+	// ISR runs per second in each mode with both axes turning, and the host time of
+	// a sample with and without a change on the lines. The target load is the rate
+	// times the cycles of one run, which have to be taken on the ATmega1284P.
+	double idle_ns = run_samples(0, 1.0);
+	double busy_ns = run_samples(9999, 1.0);
+	printf("host time per sample: %.1f ns with no change, %.1f ns with both axes moving\n",
+	       idle_ns, busy_ns);
+	printf("ISR runs/s with both axes turning:\n");
+	printf("   counts/s per axis   pin change   sampled\n");
+	for(uint8_t i = 0; i < sizeof(rates)/sizeof(rates[0]); i++)
+	{
+		printf("   %17.0f   %10.0f   %7lu\n", rates[i], 2*rates[i], ENC_SAMPLE_HZ);
+	}
+
+	return TEST_RESULT("test_sampled");
+}
@@ -0,0 +1,198 @@
+//*************************************************************************************
+/** \file test_scaling.c
+ *  \brief This file measures how the run time of the control cycle grows with the
+ *  number of motor axes. The Makefile builds it once for each of 1 to 4 axes.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "pid.h"
+#include "profile.h"
+#include "friction.h"
+#include "encoder.h"
+#include "timestamp.h"
+#include "task_motors.h"
+#include "task_safety.h"
+#include "thermal.h"
+#include "trip.h"
+#include "task_master.h"
+#include "control.h"
+#include "test.h"
+
+ISR(TIMER1_OVF_vect);
+ISR(PCINT0_vect);
+
+/// Simulated seconds per test; each axis steps its command every STEP_SECONDS.
+#define RUN_SECONDS 20
+#define STEP_SECONDS 2
+
+/// The simulated motor: counts/s per unit of power, and its time constant in s.
+#define PLANT_GAIN 20.0
+#define PLANT_TAU 0.05
+
+/// Substeps of the plant per PWM period, which set how finely edges are timed.
+#define PLANT_SUBSTEPS 8
+
+// The commands and joystick readings which task_motors.c and task_master.c own.
+uint8_t state_SHARED;
+int16_t motor1_power_SHARED;
+int16_t motor2_power_SHARED;
+int32_t position_cmd_SHARED[MOTOR_NUM_AXES];
+int32_t rate_cmd_SHARED[MOTOR_NUM_AXES];
+int32_t accel_cmd_SHARED[MOTOR_NUM_AXES];
+uint8_t setpoint_sequence_SHARED;
+int32_t position_targ_init_SHARED[MOTOR_NUM_AXES];
+
+/// An entry of motor_axes[] with the tuning of motor 1, turning the plant's way.
+#define TEST_AXIS(n) \
+	{ \
+		&PINB, 0, 0, &PINB, 0, &PIND, 0, &plant_ocr[n], 0, \
+		PWR_LIMIT_M1, PWR_PEAK_M1, n, ADC_CURRENT_M1, 0, +1, \
+		K_PROP_1, K_INT_1, K_DER_1, INT_CLAMP_1, OUT_CLAMP_1, \
+		PROFILE_VEL_MAX_1, PROFILE_ACC_MAX_1, PROFILE_JERK_MAX_1, \
+		K_FF_VEL_1, K_FF_ACC_1, \
+		FRICTION_BREAKAWAY_1, FRICTION_DITHER_1, \
+		THERMAL_CURRENT_M1, TRIP_CURRENT_M1, TRIP_OVERCURRENT_M1, TRIP_DRIVER_M1 \
+	}
+
+static volatile uint16_t plant_ocr[4];
+
+/// Every axis is a copy of motor 1, so the work per axis is the same.
+const motor_axis motor_axes[MOTOR_NUM_AXES] PROGMEM =
+{
+	TEST_AXIS(0)
+#if MOTOR_NUM_AXES > 1
+	, TEST_AXIS(1)
+#endif
+#if MOTOR_NUM_AXES > 2
+	, TEST_AXIS(2)
+#endif
+#if MOTOR_NUM_AXES > 3
+	, TEST_AXIS(3)
+#endif
+};
+
+/// The power each axis was last given, and the trips and events the cycle raised.
+static int16_t plant_power[MOTOR_NUM_AXES];
+static uint16_t trips;
+
+void motors_init(void){}
+void motor_get_axis(uint8_t axis, motor_axis *copy){ *copy = motor_axes[axis]; }
+void motor_power(uint8_t axis, int16_t power){ plant_power[axis] = power; }
+void motor_sleep(uint8_t axis){ plant_power[axis] = 0; }
+uint16_t adc_read(uint8_t adc_channel){ return 0; }
+uint8_t trip_fault_from_ISR(uint16_t faults){ trips++; return faults; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// The quadrature states in the order which counts up, (B<<1)|A.
+static const uint8_t up_sequence[4] = {0, 2, 3, 1};
+
+/// Sets the simulated clock which timestamp_now() reads, in time stamp counts.
+static void set_time(uint64_t counts){
+	stub_tick_count = counts/TIMESTAMP_COUNTS_PER_TICK;
+	TCNT3 = counts%TIMESTAMP_COUNTS_PER_TICK;
+}
+
+int main(void){
+	static double velocity[MOTOR_NUM_AXES];
+	static double position[MOTOR_NUM_AXES];
+	static int32_t counts[MOTOR_NUM_AXES];
+	const double dt = 512e-6/PLANT_SUBSTEPS;
+
+	PINA = 0;
+	set_time(0);
+	encoders_init();
+	control_init();
+	state_SHARED = TRACK_TARG;
+
+	uint64_t now = 0;
+	uint32_t cycles = 0;
+	uint32_t steps = 0;
+	double busy = 0;
+	double worst_error = 0;
+	for(uint32_t period = 0; period < RUN_SECONDS/512e-6; period++)
+	{
+		// Every axis moves between the ends of the same travel.
+		if(period % (uint32_t)(STEP_SECONDS/512e-6) == 0)
+		{
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				position_cmd_SHARED[axis] = (steps & 1) ? 0 : 1000;
+			}
+			setpoint_sequence_SHARED++;
+			steps++;
+		}
+
+		// The plant runs over the PWM period, with an encoder interrupt on each edge.
+		for(uint8_t sub = 0; sub < PLANT_SUBSTEPS; sub++)
+		{
+			now += 1024/PLANT_SUBSTEPS;
+			set_time(now);
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				velocity[axis] += (PLANT_GAIN*plant_power[axis] - velocity[axis])*dt
+				                  /PLANT_TAU;
+				position[axis] += velocity[axis]*dt;
+				while(counts[axis] != (int32_t)floor(position[axis]))
+				{
+					counts[axis] += (counts[axis] < position[axis]) ? 1 : -1;
+					uint8_t shift = 2*axis;
+					PINA = (PINA & ~(3 << shift)) | (up_sequence[counts[axis] & 3] << shift);
+					PCINT0_vect();
+				}
+			}
+		}
+
+		double start = test_seconds();
+		TIMER1_OVF_vect();
+		busy += test_seconds() - start;
+		if(period % CONTROL_PWM_DIVIDER == 0)
+		{
+			cycles++;
+		}
+
+		// Just before the next step every axis has settled on its command.
+		if((period + 1) % (uint32_t)(STEP_SECONDS/512e-6) == 0)
+		{
+			for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+			{
+				double error = labs(position_cmd_SHARED[axis] 
+				                    - encoder_get_position(axis));
+				worst_error = (error > worst_error) ? error : worst_error;
+			}
+		}
+	}
+
+	CHECK(trips == 0, "%u trips", trips);
+	CHECK(worst_error <= 5, "an axis settled %.0f counts from its command", worst_error);
+	double per_cycle = busy/cycles*1e9;
+	printf("%u axes: %.0f ns per control cycle; settled within %.0f counts\n",
+	       MOTOR_NUM_AXES, per_cycle, worst_error);
+
+	return TEST_RESULT("test_scaling");
+}
@@ -0,0 +1,175 @@
+//*************************************************************************************
+/** \file test_supervisor.c
+ *  \brief This file tests the axis supervisor in supervisor.c on a simulated motor
+ *  which slews and holds under a P controller: that it keeps quiet while the axis
+ *  works, and how soon it finds a jam, a wrong motor sign and a lost encoder.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "supervisor.h"
+#include "test.h"
+
+/// Time between updates, one per control cycle, in seconds.
+#define CYCLE_S 0.001024
+
+/// Rated and peak power of the axis, in motor power counts.
+#define POWER_LIMIT 150
+#define POWER_PEAK 300
+
+/// What goes wrong with the simulated axis.
+#define HEALTHY 0
+#define LOADED 1
+#define JAMMED 2
+#define WRONG_SIGN 3
+#define UNPLUGGED 4
+#define MISCOUNTING 5
+
+/// Names of the SUPERVISOR_ causes.
+static const char *cause_names[] = { "none", "stall", "runaway", "encoder loss" };
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs an axis for 60 s through slews of 3000 counts at 1500
+ *  counts/s, back and forth, with 8 s holds between them, and its supervisor with it.
+ *  \details The motor turns 10 counts/s per count of power, with a time constant of 
+ *  50 ms, and draws 0.17 ADC counts of current per count of power it doesn't turn 
+ *  against, plus some noise.
+ *  @param fault What goes wrong with the axis.
+ *  @param fault_time When it goes wrong, in seconds.
+ *  @param found_time Set to when the supervisor found a fault, in seconds.
+ *  @return The fault found, one of the SUPERVISOR_ codes.
+ */
+static uint8_t run(uint8_t fault, double fault_time, double *found_time){
+	axis_supervisor sv;
+	supervisor_init(&sv, POWER_LIMIT);
+	srand(1);
+	double angle = 0;
+	double speed = 0;
+	int32_t last_count = 0;
+	uint16_t errors = 0;
+	for(uint32_t cycle = 0; cycle < 60/CYCLE_S; cycle++)
+	{
+		double time = cycle*CYCLE_S;
+		uint8_t failed = (time > fault_time);
+		double phase = fmod(time, 10);
+		double target = (phase < 2) ? 1500*phase : 3000;
+		double rate = (phase < 2) ? 1500 : 0;
+		if(fmod(time, 20) >= 10)
+		{
+			target = 3000 - target;
+			rate = -rate;
+		}
+		int32_t position = (fault == UNPLUGGED && failed) ? last_count : (int32_t)angle;
+		last_count = position;
+
+		// P control with velocity feedforward, clamped to the peak power
+		double output = 0.5*(target - position) + rate/10;
+		output = fmax(-POWER_PEAK, fmin(POWER_PEAK, output));
+
+		double power = (fault == WRONG_SIGN) ? -output : output;
+		double load = (fault == LOADED) ? 60 : 0;
+		speed += (10*(power - load) - speed)/0.05*CYCLE_S;
+		if(fault == JAMMED && failed)
+		{
+			speed = 0;
+		}
+		angle += speed*CYCLE_S;
+		double current = 0.17*fabs(power - speed/10) + 2 + rand()%3;
+		if(fault == MISCOUNTING && failed && cycle % 8 == 0)
+		{
+			errors++;
+		}
+
+		uint8_t cause = supervisor_update(&sv, (int16_t)output, (uint16_t)current, 
+		                                  position, errors);
+		if(cause != SUPERVISOR_OK)
+		{
+			*found_time = time;
+			return cause;
+		}
+	}
+	return SUPERVISOR_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one case and checks what was found, and how soon.
+ *  @param label What the case is.
+ *  @param fault What goes wrong with the axis.
+ *  @param fault_time When it goes wrong, in seconds.
+ *  @param expected The fault which should be found.
+ *  @param by The time by which it should be found, in seconds.
+ */
+static void check_case(const char *label, uint8_t fault, double fault_time, 
+                       uint8_t expected, double by){
+	double found_time = 0;
+	uint8_t cause = run(fault, fault_time, &found_time);
+	if(cause == SUPERVISOR_OK)
+	{
+		printf("  %-34s nothing found in 60 s\n", label);
+	}
+	else
+	{
+		printf("  %-34s %s at %.3f s\n", label, cause_names[cause], found_time);
+	}
+	CHECK(cause == expected && (cause == SUPERVISOR_OK || found_time <= by),
+	      "%s: %s at %.3f s", label, cause_names[cause], found_time);
+}
+
+int main(void){
+	// A fault needs SUPERVISOR_WINDOWS whole windows, and may start just after one 
+	// began. A motor which turns with its encoder lost draws the current of a locked
+	// one while it speeds up, which can spoil one more window.
+	double latency = (SUPERVISOR_WINDOWS + 2)*SUPERVISOR_WINDOW*CYCLE_S;
+	printf("supervisor: %u windows of %u cycles, found within %.0f ms of the axis being "
+	       "driven into a fault:\n", SUPERVISOR_WINDOWS, SUPERVISOR_WINDOW, 1000*latency);
+	check_case("slews and holds", HEALTHY, 60, SUPERVISOR_OK, 0);
+	check_case("holding against a load", LOADED, 60, SUPERVISOR_OK, 0);
+	check_case("wrong motor sign", WRONG_SIGN, 0, SUPERVISOR_RUNAWAY, latency);
+	check_case("jammed at 1 s, mid slew", JAMMED, 1, SUPERVISOR_STALL, 1 + latency);
+	check_case("encoder unplugged at 1 s, mid slew", UNPLUGGED, 1, SUPERVISOR_ENCODER_LOSS,
+	           1 + latency);
+	check_case("encoder miscounting from 5 s", MISCOUNTING, 5, SUPERVISOR_ENCODER_LOSS,
+	           5 + latency);
+
+	// Jammed or unplugged while holding, the axis isn't driven hard, so nothing is 
+	// found until the next slew drives it.
+	check_case("jammed at 5 s, holding", JAMMED, 5, SUPERVISOR_STALL, 10 + latency);
+	check_case("encoder unplugged at 5 s, holding", UNPLUGGED, 5, SUPERVISOR_ENCODER_LOSS,
+	           10 + latency);
+
+	// A fault found is kept through supervisor_reset() and cleared by supervisor_init().
+	axis_supervisor sv;
+	supervisor_init(&sv, POWER_LIMIT);
+	for(uint16_t cycle = 0; cycle < SUPERVISOR_WINDOWS*SUPERVISOR_WINDOW; cycle++)
+	{
+		supervisor_update(&sv, POWER_PEAK, 100, 0, 0);
+	}
+	CHECK(supervisor_cause(&sv) == SUPERVISOR_STALL, "a locked axis gave cause %u",
+	      supervisor_cause(&sv));
+	supervisor_reset(&sv);
+	CHECK(supervisor_update(&sv, 0, 0, 0, 0) == SUPERVISOR_STALL, "reset dropped a fault");
+	supervisor_init(&sv, POWER_LIMIT);
+	CHECK(supervisor_cause(&sv) == SUPERVISOR_OK, "init kept a fault");
+
+	return TEST_RESULT("test_supervisor");
+}
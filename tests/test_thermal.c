@@ -0,0 +1,160 @@
+//*************************************************************************************
+/** \file test_thermal.c
+ *  \brief This file tests the thermal model in thermal.c on a stalled motor whose
+ *  current follows its duty cycle: how long the peak power lasts, where the heat 
+ *  settles, and how closely the fixed point model follows an exact one.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <stdlib.h>
+#include <math.h>
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "thermal.h"
+#include "trip.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "test.h"
+
+/// Time between current samples of one motor, in seconds: once per control cycle.
+#define SAMPLE_S 0.001024
+
+/// Current sense reading of the stalled motor per OCR count, which makes its rated 
+/// power draw its rated current.
+#define COUNTS_PER_OCR ( (double)THERMAL_CURRENT_M1/PWR_LIMIT_M1 )
+
+/// Time constant of the model in seconds.
+#define TAU_S ( (1UL<<THERMAL_TAU_SHIFT)*SAMPLE_S )
+
+uint8_t state_SHARED;
+
+void master_post_fault(uint16_t cause){ }
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){ return 0; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// Heat of an exact model of motor 1 in floating point, in 1/256 of the rated.
+static double exact_heat;
+
+/// Time the limit of motor 1 first went below its peak, or -1 while it hasn't.
+static double foldback_time;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs motor 1 stalled, asking for a power, through
+ *  motor_power(), and feeds the current it draws back to the model as the ADC ISR 
+ *  does. The exact model sees the same currents.
+ *  @param seconds How long to run for.
+ *  @param demand The power asked for, in OCR counts.
+ *  @return The largest difference between the two models, in 1/256 of the rated heat.
+ */
+static double run(double seconds, int16_t demand){
+	double worst = 0;
+	uint32_t samples = seconds/SAMPLE_S;
+	for(uint32_t sample = 0; sample < samples; sample++)
+	{
+		motor_power(0, demand);
+		uint16_t reading = lround(OCR1A*COUNTS_PER_OCR);
+		thermal_current(ADC_CURRENT_M1, reading);
+		double current = reading/(double)THERMAL_CURRENT_M1;
+		exact_heat += (256*current*current - exact_heat)/(1UL<<THERMAL_TAU_SHIFT);
+
+		thermal_status status;
+		thermal_get_status(0, &status);
+		worst = fmax(worst, fabs(status.heat - exact_heat));
+		if(foldback_time < 0 && OCR1A < PWR_PEAK_M1)
+		{
+			foldback_time = sample*SAMPLE_S;
+		}
+	}
+	return worst;
+}
+
+/// Starts over with a cold motor.
+static void start(void){
+	thermal_init();
+	exact_heat = 0;
+	foldback_time = -1;
+}
+
+int main(void){
+	motors_init();
+	trip_init();
+	thermal_status status;
+
+	// A cold motor gets its peak power until the heat reaches the start of the 
+	// foldback, at 1 - exp(-t/tau) = 192/1024 for twice the rated current.
+	start();
+	double error = run(120, 1000);
+	thermal_get_status(0, &status);
+	double expected = -TAU_S*log(1 - (double)THERMAL_FOLDBACK_START/1024);
+	printf("stalled at peak power, tau %.1f s: foldback after %.2f s (%.2f s exact), "
+	       "after 120 s heat %u/256 (exact %.1f), power %d of %u peak and %u rated\n",
+	       TAU_S, foldback_time, expected, status.heat, exact_heat, status.limit, 
+	       PWR_PEAK_M1, PWR_LIMIT_M1);
+	CHECK(fabs(foldback_time - expected) < 0.05, "foldback after %.2f s", foldback_time);
+	CHECK(status.heat >= THERMAL_HEAT_RATED && status.heat < THERMAL_HEAT_CUTOFF,
+	      "a stalled motor settled at heat %u", status.heat);
+	CHECK(status.limit >= PWR_LIMIT_M1*9/10 && status.limit <= PWR_LIMIT_M1,
+	      "a stalled motor settled at power %d", status.limit);
+	CHECK(status.foldbacks == 1 && status.heat_max < THERMAL_HEAT_CUTOFF, 
+	      "%u foldbacks, heat at most %u", status.foldbacks, status.heat_max);
+	CHECK(OCR1A == status.limit, "motor_power() gave %u, not the limit", OCR1A);
+
+	// It cools off again.
+	error = fmax(error, run(120, 0));
+	thermal_get_status(0, &status);
+	printf("  120 s off: heat %u/256 (exact %.1f), power %d\n", status.heat, exact_heat,
+	       status.limit);
+	CHECK(status.limit == PWR_PEAK_M1, "the cooled motor is allowed %d", status.limit);
+
+	// Bursts at peak power whose mean is the rated heat stay mostly at peak power.
+	start();
+	int16_t lowest = PWR_PEAK_M1;
+	for(uint8_t burst = 0; burst < 60; burst++)
+	{
+		error = fmax(error, run(2, 1000));
+		thermal_get_status(0, &status);
+		lowest = (status.limit < lowest) ? status.limit : lowest;
+		error = fmax(error, run(6, 0));
+	}
+	thermal_get_status(0, &status);
+	printf("  2 s bursts every 8 s for 8 min: lowest power %d, heat at most %u/256\n", 
+	       lowest, status.heat_max);
+	CHECK(lowest > PWR_LIMIT_M1 && status.heat_max < THERMAL_HEAT_RATED,
+	      "bursts folded back to %d", lowest);
+
+	// The rated power can be drawn for good, and settles at the rated heat.
+	start();
+	error = fmax(error, run(300, PWR_LIMIT_M1));
+	thermal_get_status(0, &status);
+	printf("  rated power for 300 s: heat %u/256 (exact %.1f), power %d\n", status.heat,
+	       exact_heat, status.limit);
+	CHECK(abs(status.heat - THERMAL_HEAT_RATED) <= 2, "rated heat %u", status.heat);
+	CHECK(OCR1A == PWR_LIMIT_M1, "rated power folded back to %u", OCR1A);
+
+	// The fixed point heat truncates to whole 1/256ths of the rated.
+	printf("  fixed point heat within %.2f/256 of the exact model throughout\n", error);
+	CHECK(error < 1.5, "fixed point heat off by %.2f/256", error);
+
+	return TEST_RESULT("test_thermal");
+}
@@ -0,0 +1,79 @@
+//*************************************************************************************
+/** \file test_timestamp.c
+ *  \brief This file tests the time stamps of timestamp.c while the RTOS tick is held
+ *  off, as the control cycle holds it: stamps taken while the tick is pending must 
+ *  still count on from the last one.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timestamp.h"
+#include "test.h"
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets the tick timer to a time, with the tick ISR held off 
+ *  since another, as Timer 3 and the tick count would be.
+ *  @param time The time, in time stamp counts.
+ *  @param held_since When the tick ISR was last able to run, in time stamp counts.
+ */
+static void set_time(uint32_t time, uint32_t held_since){
+	uint32_t ticks_run = held_since/TIMESTAMP_COUNTS_PER_TICK;
+	stub_tick_count = ticks_run;
+	TCNT3 = time % TIMESTAMP_COUNTS_PER_TICK;
+	TIFR3 = (time/TIMESTAMP_COUNTS_PER_TICK > ticks_run) ? (1<<OCF3A) : 0;
+}
+
+int main(void){
+	// The tick is held off for up to one tick less a count, from every phase of the
+	// tick, and stamps are taken all through.
+	uint32_t wrong = 0;
+	uint32_t backwards = 0;
+	uint32_t checked = 0;
+	for(uint32_t start = 0; start < TIMESTAMP_COUNTS_PER_TICK; start += 50)
+	{
+		uint32_t held_since = 10*TIMESTAMP_COUNTS_PER_TICK + start;
+		uint32_t last = 0;
+		for(uint32_t time = held_since; time < held_since + TIMESTAMP_COUNTS_PER_TICK; 
+		    time += 7)
+		{
+			set_time(time, held_since);
+			uint32_t stamp = timestamp_now_in_ISR();
+			wrong += (stamp != time);
+			backwards += (stamp < last);
+			last = stamp;
+			checked++;
+		}
+	}
+	printf("%lu stamps with the tick held off up to %.1f us: %lu wrong, %lu went "
+	       "backwards\n", (unsigned long)checked, 
+	       1e6/configTICK_RATE_HZ - 1e6/TIMESTAMP_HZ,
+	       (unsigned long)wrong, (unsigned long)backwards);
+	CHECK(wrong == 0 && backwards == 0, "%lu stamps wrong", (unsigned long)wrong);
+
+	// A tick pending for 0.9 ms still counts.
+	set_time(5*TIMESTAMP_COUNTS_PER_TICK + 9*TIMESTAMP_COUNTS_PER_TICK/10, 
+	         5*TIMESTAMP_COUNTS_PER_TICK - 1);
+	CHECK(timestamp_now() == 5*TIMESTAMP_COUNTS_PER_TICK + 9*TIMESTAMP_COUNTS_PER_TICK/10,
+	      "a tick pending 0.9 ms was dropped");
+
+	return TEST_RESULT("test_timestamp");
+}
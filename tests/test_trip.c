@@ -0,0 +1,258 @@
+//*************************************************************************************
+/** \file test_trip.c
+ *  \brief This file tests the fast current trip in trip.c, fed by the ADC ISR of adc.c
+ *  as the ADC times its conversions: which overcurrents trip, and how long after the 
+ *  onset of one the PWM is off.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "shares.h"
+#include "adc.h"
+#include "thermal.h"
+#include "task_safety.h"
+#include "trip.h"
+#include "task_motors.h"
+#include "task_master.h"
+#include "control.h"
+#include "test.h"
+
+ISR(ADC_vect);
+ISR(PCINT1_vect);
+ISR(PCINT2_vect);
+
+/// Current sense readings of motor 1 in the on-time of its PWM pulse, normally, above
+/// the lower limit, and above the hard limit, and in the off-time.
+#define NORMAL_M1 400
+#define OVER_M1 ( TRIP_CURRENT_M1 + 100 )
+#define HARD_M1 ( TRIP_HARD_CURRENT_M1 + 100 )
+#define OFF_M1 100
+
+/// Duty cycle of motor 1 while the onsets are timed, in Timer 1 counts.
+#define DUTY_M1 600
+
+/// Number of onsets, spread over two PWM periods, and the time each one is run for.
+#define ONSETS 64
+#define ONSET_PERIODS 16
+
+/// Phase of the ADC clock against the PWM period, in us; it runs on its own prescaler.
+#define ADC_CLOCK_PHASE 5
+
+uint8_t state_SHARED;
+
+/// The faults the master was told of.
+static uint16_t fault_posts;
+
+void master_post_fault(uint16_t cause){ fault_posts++; }
+signed portBASE_TYPE master_post_fault_from_ISR(uint16_t cause){ fault_posts++; return 0; }
+signed portBASE_TYPE master_post_from_ISR(uint8_t event){ return 0; }
+
+/// The simulated time in us, the onset of the overcurrent and its reading, and the 
+/// start of one PWM period whose on-time reads spike_reading, so one sample of motor 1
+/// does.
+static uint32_t now;
+static uint32_t onset;
+static uint16_t over_reading;
+static uint32_t spike;
+static uint16_t spike_reading;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function gives the voltage on an ADC input at a time.
+ *  @param channel The ADC channel.
+ *  @param time The time in us.
+ *  @return The reading the ADC would give.
+ */
+static uint16_t input(uint8_t channel, uint32_t time){
+	if(channel != ADC_CURRENT_M1)
+	{
+		return 0;
+	}
+	if(time >= spike && time < spike + 512 && time % 512 < DUTY_M1/2)
+	{
+		return spike_reading;
+	}
+	if(time % 512 >= DUTY_M1/2)
+	{
+		return OFF_M1;
+	}
+	return (time >= onset) ? over_reading : NORMAL_M1;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs the ADC as the ATmega1284P datasheet times it, in steps 
+ *  of 1 us, as test_adc.c does, until a time or until the PWM of motor 1 is off.
+ *  @param end The time to stop at.
+ *  @return The time the PWM of motor 1 went off, or 0 if it didn't.
+ */
+static uint32_t run_adc(uint32_t end){
+	static uint32_t done;
+	static uint32_t sample;
+	static uint8_t busy;
+	static uint8_t pending;
+	static uint8_t channel;
+	for(; now < end; now++)
+	{
+		TCNT1 = (now % 512)*2;
+		if(!busy && !pending 
+		   && ((now % 512 == 0 && (ADCSRA & (1<<ADATE))) || (ADCSRA & (1<<ADSC))))
+		{
+			pending = 1 + !(ADCSRA & (1<<ADSC));
+			ADCSRA |= (1<<ADSC);
+		}
+		if(pending && (now - ADC_CLOCK_PHASE) % 8 == 0)
+		{
+			channel = ADMUX & 0x07;
+			sample = now + ((pending == 2) ? 16 : 12);
+			done = now + ((pending == 2) ? 108 : 104);
+			busy = 1;
+			pending = 0;
+		}
+		if(busy && now == done)
+		{
+			ADC = input(channel, sample);
+			busy = 0;
+			ADCSRA &= ~(1<<ADSC);
+			ADC_vect();
+			if(!(TCCR1A & motor_axes[0].pwm_com))
+			{
+				return now;
+			}
+		}
+	}
+	return 0;
+}
+
+/// Starts over with the motors running and nothing tripped.
+static void start(void){
+	trip_init();
+	fault_posts = 0;
+	motor_power(0, DUTY_M1);
+	motor_power(1, 0);
+	onset = 0xFFFFFFFF;
+	spike = 0xFFFFFFFF;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function times the trip after overcurrents of one size, starting at 
+ *  every 16 us over two PWM periods, which is one pass of the scan.
+ *  @param reading The reading in the on-time once the overcurrent starts.
+ *  @param mean Set to the mean time from the onset to the PWM being off, in us.
+ *  @return The longest such time, in us, or 0 if one didn't trip.
+ */
+static uint32_t time_onsets(uint16_t reading, double *mean){
+	uint32_t worst = 0;
+	double sum = 0;
+	over_reading = reading;
+	for(uint8_t n = 0; n < ONSETS; n++)
+	{
+		start();
+		now = (now/1024 + 4)*1024;
+		run_adc(now + 4096);
+		onset = now + n*1024/ONSETS;
+		uint32_t off = run_adc(onset + 512*ONSET_PERIODS);
+		if(!off)
+		{
+			return 0;
+		}
+		sum += off - onset;
+		worst = (off - onset > worst) ? off - onset : worst;
+	}
+	*mean = sum/ONSETS;
+	return worst;
+}
+
+int main(void){
+	PINB = 0xFF;
+	PINC = 0xFF;
+	motors_init();
+	thermal_init();
+	adc_init();
+	trip_status status;
+
+	// Normal currents don't trip.
+	start();
+	run_adc(now + 512*200);
+	trip_get_status(&status);
+	CHECK(status.faults == 0, "normal currents tripped %03X", status.faults);
+
+	// A single noisy sample trips only if it is above the hard limit.
+	start();
+	run_adc(now + 4096);
+	spike = (now/1024 + 1)*1024;
+	spike_reading = OVER_M1;
+	run_adc(now + 4096);
+	trip_get_status(&status);
+	CHECK(status.faults == 0, "one sample of %u tripped", spike_reading);
+	spike = (now/1024 + 1)*1024;
+	spike_reading = HARD_M1;
+	run_adc(now + 4096);
+	trip_get_status(&status);
+	CHECK(status.faults == TRIP_OVERCURRENT_M1 && fault_posts == 1, 
+	      "one sample of %u: faults %03X, %u posts", spike_reading, status.faults,
+	      fault_posts);
+
+	// Overcurrents of both sizes, from onsets all over the scan
+	double mean_over, mean_hard;
+	uint32_t worst_over = time_onsets(OVER_M1, &mean_over);
+	uint32_t worst_hard = time_onsets(HARD_M1, &mean_hard);
+	trip_get_status(&status);
+	printf("current limits %u and %u counts, motor 1 sampled every %u us:\n",
+	       TRIP_CURRENT_M1, TRIP_HARD_CURRENT_M1, 512*ADC_SCAN_LENGTH/2);
+	printf("  %u counts, %u samples: PWM off %.0f us after the onset on average, %lu us "
+	       "at most\n", OVER_M1, TRIP_CURRENT_SAMPLES, mean_over, 
+	       (unsigned long)worst_over);
+	printf("  %u counts, 1 sample:  PWM off %.0f us after the onset on average, %lu us "
+	       "at most, %u us after the conversion started\n", HARD_M1, mean_hard, 
+	       (unsigned long)worst_hard, 
+	       (unsigned)(status.current_latency/CONTROL_COUNTS_PER_US));
+	CHECK(worst_over && worst_hard, "an overcurrent didn't trip");
+	CHECK(worst_hard < worst_over, "the hard limit took %lu us, the lower %lu us",
+	      (unsigned long)worst_hard, (unsigned long)worst_over);
+	CHECK(worst_hard <= 1200 && worst_over <= 2200, "the trips took %lu and %lu us",
+	      (unsigned long)worst_hard, (unsigned long)worst_over);
+
+	// A tripped motor stays off.
+	motor_power(0, DUTY_M1);
+	CHECK(!(TCCR1A & motor_axes[0].pwm_com), "motor_power() drove a tripped motor");
+
+	// A fault on the motor 2 driver pulls its EN_AB pin low and trips at once.
+	start();
+	motor_power(1, DUTY_M1);
+	PINC &= ~(1<<PC6);
+	PCINT2_vect();
+	PINC = 0xFF;
+	trip_get_status(&status);
+	CHECK(status.faults == TRIP_DRIVER_M2 && !(TCCR1A & motor_axes[1].pwm_com), 
+	      "a driver fault left faults %03X", status.faults);
+
+	// Faults found by a task latch too, and are posted to the master once.
+	start();
+	trip_fault(TRIP_ESTOP);
+	trip_fault(TRIP_ESTOP);
+	trip_get_status(&status);
+	CHECK(status.faults == TRIP_ESTOP && fault_posts == 1, 
+	      "a task trip left faults %03X, %u posts", status.faults, fault_posts);
+
+	return TEST_RESULT("test_trip");
+}
@@ -0,0 +1,143 @@
+//*************************************************************************************
+/** \file test_velocity.c
+ *  \brief This file tests the edge-timed velocity estimator in encoder.c with 
+ *  synthetic edge trains from 0.1 to 10000 counts/s.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"
+#include "timestamp.h"
+#include "encoder.h"
+#include "test.h"
+
+ISR(PCINT0_vect);
+
+/// Period at which the control ISR calls encoder_velocity_update(), in time stamp counts.
+#define UPDATE_COUNTS 2048UL
+
+/// The quadrature states in the order which counts up, (B<<1)|A.
+static const uint8_t up_sequence[4] = {0, 2, 3, 1};
+
+/// Sets the simulated clock which timestamp_now() reads, in time stamp counts.
+static void set_time(uint64_t counts){
+	stub_tick_count = counts/TIMESTAMP_COUNTS_PER_TICK;
+	TCNT3 = counts%TIMESTAMP_COUNTS_PER_TICK;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs an edge train on axis 0 through the encoder ISR while 
+ *  updating the estimate at the control rate.
+ *  @param rate The edge rate in counts/s; negative counts down.
+ *  @param seconds How long to run.
+ *  @param worst Set to the largest relative error once the first window has closed,
+ *  which takes two updates with edges.
+ *  @return The last estimate, in counts/s.
+ */
+static double run_train(double rate, double seconds, double *worst){
+	PINA = 0;
+	TIFR3 = 0;
+	set_time(0);
+	encoders_init();
+
+	double period = TIMESTAMP_HZ/fabs(rate);
+	double next_edge = period/2;
+	uint8_t phase = 0;
+	uint32_t edges = 0;
+	uint32_t edges_updated = 0;
+	uint32_t windows = 0;
+	double estimate = 0;
+	*worst = 0;
+	for(uint64_t now = UPDATE_COUNTS; now < seconds*TIMESTAMP_HZ; now += UPDATE_COUNTS)
+	{
+		while(next_edge <= now)
+		{
+			set_time((uint64_t)next_edge);
+			phase = (rate > 0) ? (phase + 1) & 3 : (phase + 3) & 3;
+			PINA = up_sequence[phase];
+			PCINT0_vect();
+			next_edge += period;
+			edges++;
+		}
+		if(edges != edges_updated)
+		{
+			windows++;
+			edges_updated = edges;
+		}
+		set_time(now);
+		encoder_velocity_update(ENC_AXIS_M1);
+		estimate = (double)encoder_get_velocity(ENC_AXIS_M1)/ENC_VEL_SCALE;
+		if(windows >= 2)
+		{
+			double error = fabs(estimate - rate)/fabs(rate);
+			if(error > *worst)
+			{
+				*worst = error;
+			}
+		}
+	}
+	return estimate;
+}
+
+int main(void){
+	static const double rates[] = {0.1, 0.3, 1, 3, 10, 30, 100, 300, 1000, 3000, 10000};
+	printf("edge train velocity, worst error once the first window closed:\n");
+	for(uint8_t i = 0; i < sizeof(rates)/sizeof(rates[0]); i++)
+	{
+		for(int8_t sign = 1; sign >= -1; sign -= 2)
+		{
+			double worst;
+			double rate = sign*rates[i];
+			double seconds = (fabs(rate) < 10) ? 3/fabs(rate) + 1 : 1;
+			double estimate = run_train(rate, seconds, &worst);
+			if(sign > 0)
+			{
+				printf("  %8.1f counts/s: estimate %10.3f, worst error %.3f%%\n", rate, 
+				       estimate, 100*worst);
+			}
+			CHECK(worst < 0.005, "%.1f counts/s: worst error %.3f%%", rate, 100*worst);
+		}
+	}
+
+	// After the shaft stops the estimate decays as 1/(time since the last edge) and
+	// reaches zero at ENC_VEL_TIMEOUT.
+	double worst;
+	run_train(100, 0.1, &worst);
+	uint64_t stop = 0.1*TIMESTAMP_HZ;
+	int32_t previous = encoder_get_velocity(ENC_AXIS_M1);
+	uint8_t rising = 0;
+	uint64_t now;
+	for(now = stop; encoder_get_velocity(ENC_AXIS_M1) != 0 && now < stop + 2*ENC_VEL_TIMEOUT;
+	    now += UPDATE_COUNTS)
+	{
+		set_time(now);
+		encoder_velocity_update(ENC_AXIS_M1);
+		rising |= (encoder_get_velocity(ENC_AXIS_M1) > previous);
+		previous = encoder_get_velocity(ENC_AXIS_M1);
+	}
+	printf("after stopping from 100 counts/s the estimate reaches zero in %.1f s\n",
+	       (double)(now - stop)/TIMESTAMP_HZ);
+	CHECK(!rising, "the estimate rose after the shaft stopped");
+	CHECK(encoder_get_velocity(ENC_AXIS_M1) == 0, "the estimate never reached zero");
+
+	return TEST_RESULT("test_velocity");
+}
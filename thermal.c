@@ -0,0 +1,177 @@
+//*************************************************************************************
+/** \file thermal.c
+ *  \brief This file contains the I2t thermal model of the motors. Each current sample
+ *  heats a first-order model of the motor by the square of the current, and it cools
+ *  in proportion to its heat, so the heat follows the mean of I^2 over the thermal 
+ *  time constant. The power limit of the motor is folded back from its peak to its
+ *  rated power as the heat gets near where the rated current would leave it.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "adc.h"
+#include "task_motors.h"
+#include "thermal.h"
+
+#if THERMAL_CURRENT_M1 < THERMAL_CURRENT_MIN || THERMAL_CURRENT_M2 < THERMAL_CURRENT_MIN
+	#error THERMAL_CURRENT_Mx must be at least THERMAL_CURRENT_MIN
+#endif
+#if THERMAL_TAU_SHIFT > 15
+	#error THERMAL_TAU_SHIFT must be at most 15
+#endif
+
+// Currents are scaled to 1/256 of the rated current, and clamped to this, 4 times the
+// rated current, which is above the trip current anyway. Their squares are dropped by
+// 4 bits, so they fit 16 bits and the rated current gives 4096.
+#define THERMAL_PU_MAX 1023U
+#define THERMAL_SQUARE_SHIFT 4
+#define THERMAL_HEAT_SHIFT ( THERMAL_TAU_SHIFT + THERMAL_SQUARE_SHIFT )
+
+/// Scale from ADC counts to 1/256 of the rated current of each motor, worked out
+/// from the rated_current of its entry in motor_axes[] by thermal_init().
+static uint16_t thm_scale[MOTOR_NUM_AXES];
+
+/// Heat of each motor, the mean square current times 2^THERMAL_HEAT_SHIFT/256 of
+/// the rated. Written by the ADC ISR.
+static volatile uint32_t thm_heat[MOTOR_NUM_AXES];
+
+/// Statistics, see thermal_get_status().
+static uint16_t thm_heat_max[MOTOR_NUM_AXES];
+static int16_t thm_limit[MOTOR_NUM_AXES];
+static uint16_t thm_foldbacks[MOTOR_NUM_AXES];
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up the thermal model, with the motors cold.
+ *  \details Call once from main(). The model starts cold after every reset, so a
+ *  motor which was hot when the board was reset gets a burst it shouldn't; the trip
+ *  still guards it.
+ */
+void thermal_init(void){
+	for(uint8_t motor = 0; motor < MOTOR_NUM_AXES; motor++)
+	{
+		thm_scale[motor] = 65536UL/MOTOR_AXIS_WORD(motor, rated_current);
+		thm_heat[motor] = 0;
+		thm_limit[motor] = MOTOR_AXIS_WORD(motor, peak_limit);
+	}
+	thermal_reset_stats();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function runs one current sample through the model. Call it from the
+ *  ADC interrupt for each conversion.
+ *  \details The cost is a multiply, a square and a shift of the heat by a constant.
+ *  @param adc_channel The channel converted.
+ *  @param reading The reading.
+ */
+void thermal_current(uint8_t adc_channel, uint16_t reading){
+	uint8_t motor = motor_axis_of_current(adc_channel);
+	if(motor >= MOTOR_NUM_AXES)
+	{
+		return;
+	}
+
+	uint16_t current = ((uint32_t)reading*thm_scale[motor]) >> 8;
+	if(current > THERMAL_PU_MAX)
+	{
+		current = THERMAL_PU_MAX;
+	}
+	uint16_t square = ((uint32_t)current*current) >> THERMAL_SQUARE_SHIFT;
+
+	// heat += I^2 - heat/2^tau, which settles at I^2*2^tau.
+	uint32_t heat = thm_heat[motor];
+	thm_heat[motor] = heat + square - (heat >> THERMAL_TAU_SHIFT);
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function works out how much power a motor is allowed from its heat.
+ *  \details Called by motor_power() each control cycle, from the control ISR with 
+ *  interrupts off, so the ADC ISR can't change the heat while it is read.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @return The largest magnitude of power, in OCR counts, between the peak limit of
+ *  the axis and 0.
+ */
+int16_t thermal_power_limit(uint8_t axis){
+	int16_t peak_limit = MOTOR_AXIS_WORD(axis, peak_limit);
+	int16_t power_limit = MOTOR_AXIS_WORD(axis, power_limit);
+	uint16_t heat = thm_heat[axis] >> THERMAL_HEAT_SHIFT;
+	int16_t limit;
+
+	if(heat <= THERMAL_FOLDBACK_START)
+	{
+		limit = peak_limit;
+	}
+	else if(heat <= THERMAL_HEAT_RATED)
+	{
+		int16_t burst = peak_limit - power_limit;
+		limit = peak_limit - (int32_t)burst*(heat - THERMAL_FOLDBACK_START)
+		                            /(THERMAL_HEAT_RATED - THERMAL_FOLDBACK_START);
+	}
+	else if(heat < THERMAL_HEAT_CUTOFF)
+	{
+		limit = (int32_t)power_limit*(THERMAL_HEAT_CUTOFF - heat)
+		        /(THERMAL_HEAT_CUTOFF - THERMAL_HEAT_RATED);
+	}
+	else
+	{
+		limit = 0;
+	}
+
+	if(heat > thm_heat_max[axis])
+	{
+		thm_heat_max[axis] = heat;
+	}
+	if(limit < peak_limit && thm_limit[axis] == peak_limit)
+	{
+		thm_foldbacks[axis]++;
+	}
+	thm_limit[axis] = limit;
+	return limit;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the state of the thermal model of one motor.
+ *  @param axis The motor, an index into motor_axes[].
+ *  @param status The structure into which the state is copied.
+ */
+void thermal_get_status(uint8_t axis, thermal_status *status){
+	taskENTER_CRITICAL();
+		status->heat = thm_heat[axis] >> THERMAL_HEAT_SHIFT;
+		status->heat_max = thm_heat_max[axis];
+		status->limit = thm_limit[axis];
+		status->foldbacks = thm_foldbacks[axis];
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the highest heat and the count of foldbacks.
+ */
+void thermal_reset_stats(void){
+	taskENTER_CRITICAL();
+		for(uint8_t motor = 0; motor < MOTOR_NUM_AXES; motor++)
+		{
+			thm_heat_max[motor] = 0;
+			thm_foldbacks[motor] = 0;
+		}
+	taskEXIT_CRITICAL();
+}
@@ -0,0 +1,67 @@
+//*************************************************************************************
+/** \file thermal.h
+ *  \brief This file contains #defines, types and function declarations for the I2t
+ *  thermal model of the motors, which lets them run above their continuous rating for
+ *  short bursts and folds their power back before they get too hot.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _THERMAL_H_
+#define _THERMAL_H_
+
+// Current each motor can carry for good, in raw ADC counts of its current sense. Set
+// them from the rated current of the motors; the rated_current of each entry in
+// motor_axes[] is one of these. They must be at least THERMAL_CURRENT_MIN, so the 
+// scaling in thermal.c fits 16 bits.
+#define THERMAL_CURRENT_M1 256
+#define THERMAL_CURRENT_M2 256
+#define THERMAL_CURRENT_MIN 64
+
+// Time constant of the model, as a shift: 2^THERMAL_TAU_SHIFT current samples, one
+// per control cycle. 14 gives 16.8 s, about that of the windings of a small gearmotor.
+// At most 15, so the heat fits 32 bits.
+#define THERMAL_TAU_SHIFT 14
+
+// The heat is in 1/256 of what it settles at when the rated current flows for good.
+// Below THERMAL_FOLDBACK_START the peak power of the axis is allowed. From there the
+// limit goes down in a straight line to the rated power at THERMAL_HEAT_RATED, and on
+// to nothing at THERMAL_HEAT_CUTOFF. The model settles where the allowed power gives
+// as much heat as the motor loses, just above rated.
+#define THERMAL_FOLDBACK_START 192
+#define THERMAL_HEAT_RATED 256
+#define THERMAL_HEAT_CUTOFF 320
+
+/** This structure holds the state of the thermal model of one motor.
+ */
+typedef struct
+{
+	uint16_t heat;              ///< Present heat, 256 at the rated steady state
+	uint16_t heat_max;          ///< Highest heat since the status was last reset
+	int16_t limit;              ///< Power the motor is allowed now, in OCR counts
+	uint16_t foldbacks;         ///< Times the limit went below the peak power
+} thermal_status;
+
+void thermal_init(void);
+void thermal_current(uint8_t adc_channel, uint16_t reading);
+int16_t thermal_power_limit(uint8_t axis);
+void thermal_get_status(uint8_t axis, thermal_status *status);
+void thermal_reset_stats(void);
+
+#endif
@@ -0,0 +1,81 @@
+//*************************************************************************************
+/** \file timestamp.c
+ *  \brief This file contains functions which read a 32-bit time stamp from the
+ *  RTOS tick count and the hardware timer which generates it.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#include <avr/io.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+
+#include "timestamp.h"
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the current time stamp from within an ISR.
+ *  \details The time stamp is the RTOS tick count times TIMESTAMP_COUNTS_PER_TICK plus
+ *  the hardware timer count, so it wraps after 2^32 counts (about 35 minutes at
+ *  2 MHz). Use differences of time stamps, never absolute values. Must be called with
+ *  interrupts disabled. A tick held off for less than a whole tick, as the control
+ *  cycle holds it, is credited; one held off longer is lost from the tick count.
+ *  @return The time stamp, in counts of TIMESTAMP_HZ.
+ */
+uint32_t timestamp_now_in_ISR(void){
+	uint16_t count;
+	uint8_t tick_pending;
+
+	// Read the compare flag, then the timer, until the flag is the same after the
+	// timer was read. A flag set before the timer was read means the timer has 
+	// cleared and the tick ISR hasn't run yet, because interrupts or the tick are 
+	// masked, so the tick count is one tick behind the timer, however long the tick 
+	// has been pending. The flag can't clear again while interrupts are off, so this
+	// reads at most twice.
+	#ifdef TIMER3_COMPA_vect
+		do
+		{
+			tick_pending = TIFR3 & (1<<OCF3A);
+			count = TCNT3;
+		} while( tick_pending != (TIFR3 & (1<<OCF3A)) );
+	#else
+		do
+		{
+			tick_pending = TIFR1 & (1<<OCF1A);
+			count = TCNT1;
+		} while( tick_pending != (TIFR1 & (1<<OCF1A)) );
+	#endif
+	portTickType ticks = xTaskGetTickCountFromISR();
+	if( tick_pending )
+	{
+		ticks++;
+	}
+	return (uint32_t)ticks*TIMESTAMP_COUNTS_PER_TICK + count;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function returns the current time stamp from within a task.
+ *  @return The time stamp, in counts of TIMESTAMP_HZ.
+ */
+uint32_t timestamp_now(void){
+	uint32_t now;
+	taskENTER_CRITICAL();
+		now = timestamp_now_in_ISR();
+	taskEXIT_CRITICAL();
+	return now;
+}
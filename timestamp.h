@@ -0,0 +1,39 @@
+//*************************************************************************************
+/** \file timestamp.h
+ *  \brief This file contains #defines and function declarations for the high
+ *  resolution time stamps used to time events in ISRs and tasks.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _TIMESTAMP_H_
+#define _TIMESTAMP_H_
+
+/** Rate at which time stamps count, in Hz. This is the rate of the hardware timer
+ *  which generates the RTOS tick, the same clock used by time_stamp in lib/frtcpp.
+ */
+#define TIMESTAMP_HZ ( configCPU_CLOCK_HZ / portCLOCK_PRESCALER )
+
+// Number of time stamp counts in one RTOS tick.
+#define TIMESTAMP_COUNTS_PER_TICK ( TIMESTAMP_HZ / configTICK_RATE_HZ )
+
+uint32_t timestamp_now_in_ISR(void);
+uint32_t timestamp_now(void);
+
+#endif
@@ -0,0 +1,245 @@
+//*************************************************************************************
+/** \file trip.c
+ *  \brief This file contains the fast trip. The ADC interrupt checks each motor
+ *  current sample and pin change interrupts watch the drivers' fault pins; on a fault
+ *  the PWM outputs are turned off at once, the fault is latched in
+ *  safety_error_SHARED and the master is woken.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "FreeRTOS.h"                       // Primary header for FreeRTOS
+#include "task.h"                           // Header for FreeRTOS task functions
+#include "queue.h"                          // FreeRTOS inter-task communication queues
+#include "croutine.h" 
+#include "semphr.h"
+
+#include "shares.h"
+#include "adc.h"
+#include "task_motors.h"
+#include "task_safety.h"
+#include "task_master.h"
+#include "safety_log.h"
+#include "trip.h"
+
+uint16_t safety_error_SHARED;
+
+/// Current readings in a row above the limit, for each motor.
+static uint8_t trp_over_count[MOTOR_NUM_AXES];
+
+/// Trip counts and latency, see trip_get_status().
+static uint16_t trp_trips;
+static uint16_t trp_current_latency;
+
+//-------------------------------------------------------------------------------------
+/** \brief This function sets up the fast trip.
+ *  \details Pin change interrupts are enabled on the EN_AB pins of the drivers which
+ *  are on port B (PCINT8-15) or port C (PCINT16-23), as those of motors 1 and 2 are,
+ *  PB2 (PCINT10) and PC6 (PCINT22). A driver on another port is only found by the 
+ *  safety task's poll of trip_driver_faults(). The current checks need no set up, 
+ *  since the ADC interrupt calls trip_current(). Call once from main(), after 
+ *  control_init() has set the pins up with their pullups.
+ */
+void trip_init(void){
+	safety_error_SHARED = 0;
+	trp_trips = 0;
+	trp_current_latency = 0;
+
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		trp_over_count[axis] = 0;
+
+		volatile uint8_t *en_pin = MOTOR_AXIS_PTR(axis, en_pin);
+		uint8_t en_ab = MOTOR_AXIS_BYTE(axis, en_ab);
+		if(en_pin == &PINB)
+		{
+			PCMSK1 |= en_ab;
+			PCICR |= (1<<PCIE1);
+		}
+		else if(en_pin == &PINC)
+		{
+			PCMSK2 |= en_ab;
+			PCICR |= (1<<PCIE2);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function latches faults and turns the motors off. Call it with 
+ *  interrupts off. Each fault is logged when it is first latched, so one which 
+ *  persists is logged once.
+ *  @param faults The TRIP_ fault bits to latch.
+ *  @return Nonzero if these are the first faults, so the master has to be woken.
+ */
+static uint8_t trip_latch(uint16_t faults){
+	if(!faults)
+	{
+		return 0;
+	}
+	motors_trip();
+	uint8_t first = (safety_error_SHARED == 0);
+	uint16_t new_faults = faults & ~safety_error_SHARED;
+	if(new_faults)
+	{
+		trp_trips++;
+		safety_log_post_faults_from_ISR(new_faults, xTaskGetTickCountFromISR());
+	}
+	safety_error_SHARED |= faults;
+	return first;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function checks one current sample. Call it from the ADC interrupt for
+ *  each conversion. A sample above the hard limit trips at once; one above the lower
+ *  limit only trips if the one before it was above it too.
+ *  @param adc_channel The channel converted.
+ *  @param reading The reading.
+ *  @return The TRIP_ fault bit this tripped, or 0.
+ */
+uint16_t trip_current(uint8_t adc_channel, uint16_t reading){
+	uint8_t motor = motor_axis_of_current(adc_channel);
+	if(motor >= MOTOR_NUM_AXES)
+	{
+		return 0;
+	}
+	uint16_t limit = MOTOR_AXIS_WORD(motor, trip_current);
+	uint16_t hard_limit = TRIP_HARD_CURRENT(limit);
+
+	if(reading <= limit)
+	{
+		trp_over_count[motor] = 0;
+		return 0;
+	}
+	if(reading <= hard_limit && ++trp_over_count[motor] < TRIP_CURRENT_SAMPLES)
+	{
+		return 0;
+	}
+	trp_over_count[motor] = TRIP_CURRENT_SAMPLES;
+
+	uint16_t fault = MOTOR_AXIS_WORD(motor, overcurrent_fault);
+	if(!(safety_error_SHARED & fault))
+	{
+		uint8_t first = trip_latch(fault);
+		// The sample was taken at the Timer 1 overflow, where the count restarts.
+		trp_current_latency = TCNT1;
+		if(first)
+		{
+			master_post_fault_from_ISR(fault);
+		}
+	}
+	return fault;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function reads the fault pins of the drivers.
+ *  @return The TRIP_DRIVER_ bits of the drivers whose EN_AB pin is low.
+ */
+uint16_t trip_driver_faults(void){
+	uint16_t faults = 0;
+	for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+	{
+		volatile uint8_t *en_pin = MOTOR_AXIS_PTR(axis, en_pin);
+		if(!(*en_pin & MOTOR_AXIS_BYTE(axis, en_ab)))
+		{
+			faults |= MOTOR_AXIS_WORD(axis, driver_fault);
+		}
+	}
+	return faults;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function latches faults found by a task and turns the motors off.
+ *  @param faults The TRIP_ fault bits to latch.
+ */
+void trip_fault(uint16_t faults){
+	uint8_t first;
+	taskENTER_CRITICAL();
+		first = trip_latch(faults);
+	taskEXIT_CRITICAL();
+	if(first)
+	{
+		master_post_fault(faults);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function latches faults found by an ISR and turns the motors off.
+ *  \details The master is woken at the next tick at the latest; the motors are off 
+ *  already, so it need not be sooner.
+ *  @param faults The TRIP_ fault bits to latch.
+ *  @return Nonzero if these were the first faults.
+ */
+uint8_t trip_fault_from_ISR(uint16_t faults){
+	uint8_t first = trip_latch(faults);
+	if(first)
+	{
+		master_post_fault_from_ISR(faults);
+	}
+	return first;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function clears the latched faults, so the motors can be driven again.
+ *  \details Called by the master when ERROR is reset. A fault whose cause persists is
+ *  latched again by the next check which finds it.
+ *  @return The TRIP_ fault bits which were latched.
+ */
+uint16_t trip_reset(void){
+	uint16_t faults;
+	taskENTER_CRITICAL();
+		faults = safety_error_SHARED;
+		safety_error_SHARED = 0;
+		for(uint8_t axis = 0; axis < MOTOR_NUM_AXES; axis++)
+		{
+			trp_over_count[axis] = 0;
+		}
+	taskEXIT_CRITICAL();
+	return faults;
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This function copies the state of the fast trip.
+ *  @param status The structure into which the state is copied.
+ */
+void trip_get_status(trip_status *status){
+	taskENTER_CRITICAL();
+		status->faults = safety_error_SHARED;
+		status->trips = trp_trips;
+		status->current_latency = trp_current_latency;
+	taskEXIT_CRITICAL();
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This ISR trips on a fault of a driver whose EN_AB pin is on port B, such
+ *  as that of motor 1 on PB2.
+ */
+ISR(PCINT1_vect){
+	trip_fault_from_ISR(trip_driver_faults());
+}
+
+//-------------------------------------------------------------------------------------
+/** \brief This ISR trips on a fault of a driver whose EN_AB pin is on port C, such
+ *  as that of motor 2 on PC6.
+ */
+ISR(PCINT2_vect){
+	trip_fault_from_ISR(trip_driver_faults());
+}
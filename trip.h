@@ -0,0 +1,72 @@
+//*************************************************************************************
+/** \file trip.h
+ *  \brief This file contains #defines, types and function declarations for the fast 
+ *  trip, which turns the motors off from interrupt level on overcurrent or a driver
+ *  fault.
+ *
+ *  Revisions:
+ *    \li 10-17-2026 created original file
+ *
+ *  License:
+ *		This file is copyright 2012 by JF, ML, JR and released under the Lesser GNU 
+ *		Public License, version 2. It intended for educational use only, but its use
+ *		is not limited thereto. */
+/*		THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ *		AND	ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * 		IMPLIED 	WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * 		ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+ * 		LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUEN-
+ * 		TIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * 		OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+ * 		CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, 
+ * 		OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * 		OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+//*************************************************************************************
+
+#ifndef _TRIP_H_
+#define _TRIP_H_
+
+// Fault bits, latched in safety_error_SHARED until trip_reset().
+#define TRIP_OVERCURRENT_M1 0x01        ///< Motor 1 current over its limit
+#define TRIP_OVERCURRENT_M2 0x02        ///< Motor 2 current over its limit
+#define TRIP_DRIVER_M1 0x04             ///< Motor 1 driver pulled its EN_AB pin low
+#define TRIP_DRIVER_M2 0x08             ///< Motor 2 driver pulled its EN_AB pin low
+#define TRIP_STALL 0x10                 ///< An axis stalled, see supervisor.h
+#define TRIP_RUNAWAY 0x20               ///< An axis ran away from its target
+#define TRIP_ENCODER_LOSS 0x40          ///< An axis lost its encoder
+#define TRIP_LIMIT 0x80                 ///< A limit switch closed
+#define TRIP_ESTOP 0x100                ///< The emergency stop was pressed
+
+// A current trips on the first PWM-synchronous sample above its hard limit, or once
+// TRIP_CURRENT_SAMPLES samples in a row are above its lower limit, in raw ADC counts;
+// the lower limit lets one noisy sample pass. Each current is sampled every 1024 us, so
+// the PWM is off at most 1.11 ms after the onset of a current above the hard limit and
+// 2.13 ms after one above the lower limit (test_trip). The safety task also checks the
+// filtered currents against MAX_CURRENT_Mx, slower but less sensitive to noise.
+#define TRIP_CURRENT_M1 MAX_CURRENT_M1
+#define TRIP_CURRENT_M2 MAX_CURRENT_M2
+#define TRIP_HARD_CURRENT(limit) ( (limit) + (limit)/2 )
+#define TRIP_HARD_CURRENT_M1 TRIP_HARD_CURRENT(TRIP_CURRENT_M1)
+#define TRIP_HARD_CURRENT_M2 TRIP_HARD_CURRENT(TRIP_CURRENT_M2)
+#define TRIP_CURRENT_SAMPLES 2
+
+/** This structure holds the state of the fast trip. Times are in Timer 1 counts, 
+ *  CONTROL_COUNTS_PER_US per microsecond.
+ */
+typedef struct
+{
+	uint16_t faults;            ///< Latched TRIP_ fault bits
+	uint16_t trips;             ///< Number of times a new fault bit was latched
+	uint16_t current_latency;   ///< From the start of the conversion of the current
+	                            ///< sample which tripped to the PWM being off
+} trip_status;
+
+void trip_init(void);
+uint16_t trip_current(uint8_t adc_channel, uint16_t reading);
+uint16_t trip_driver_faults(void);
+void trip_fault(uint16_t faults);
+uint8_t trip_fault_from_ISR(uint16_t faults);
+uint16_t trip_reset(void);
+void trip_get_status(trip_status *status);
+
+#endif
\ No newline at end of file